@@ -132,6 +132,10 @@ void (*malloc_alloc::malloc_alloc_oom_handler)() = nullptr;
 
 //-----------------------------【default_alloc class】-----------------------------
 
+// The free lists and the chunk being carved up are per thread, so threads
+// never touch each other's state and no locking is needed. A block freed on
+// another thread than the one that allocated it joins the freeing thread's
+// lists.
 class default_alloc
 {
 private:
@@ -203,17 +207,17 @@ public:
     static char* chunk_alloc(size_t size, int& nobjs);
 
 private:
-    static char* start_free;
-    static char* end_free;
-    static size_t heap_size;
-    static obj* free_list[__NFREELISTS];
+    static thread_local char* start_free;
+    static thread_local char* end_free;
+    static thread_local size_t heap_size;
+    static thread_local obj* free_list[__NFREELISTS];
 };
 
-char* default_alloc::start_free = nullptr;
-char* default_alloc::end_free = nullptr;
-size_t default_alloc::heap_size = 0;
+thread_local char* default_alloc::start_free = nullptr;
+thread_local char* default_alloc::end_free = nullptr;
+thread_local size_t default_alloc::heap_size = 0;
 
-default_alloc::obj* default_alloc::free_list[__NFREELISTS] = 
+thread_local default_alloc::obj* default_alloc::free_list[__NFREELISTS] = 
 { 
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
@@ -0,0 +1,803 @@
+#ifndef ZYX_BTREE
+#define ZYX_BTREE
+
+#include "Iterator.h"
+#include "Alloc.h"
+#include "Construct.h"
+#include "Algorithm.h"
+#include "Utility.h"
+
+namespace Zyx {
+
+//--------------------------------------【BTree class】--------------------------------------
+
+// An in-memory B-tree: every node stores up to max_values elements contiguously
+// in a block of about NodeBytes bytes, so ordered scans walk arrays instead of
+// chasing one pointer per element. Leaves have no child array at all.
+// Unlike the red-black tree, values move within and between nodes, so both
+// insert and erase invalidate every iterator, pointer and reference.
+struct __btree_node_base
+{
+    __btree_node_base* parent;
+    unsigned short position;    // index of this node in parent's children
+    unsigned short count;       // number of values
+    bool leaf;
+};
+
+template <typename Value, size_t NodeBytes>
+struct __btree_node : public __btree_node_base
+{
+    typedef __btree_node* node_ptr;
+
+    // blocks from Alloc are only 8-byte aligned (default_alloc's granularity),
+    // so the values start at the first offset aligned for Value, and Value may
+    // not need more than 8
+    static_assert(alignof(Value) <= 8, "BTree values must not need more than 8-byte alignment");
+    enum { value_align = alignof(Value) };
+    enum { values_offset = (sizeof(__btree_node_base) + value_align - 1) & ~(value_align - 1) };
+    enum { fitting_values = (NodeBytes - values_offset) / sizeof(Value) };
+    enum { max_values = fitting_values < 3 ? 3 :
+                        fitting_values > 4096 ? 4096 : fitting_values };
+    // a full node splits into two around one separator, so an even max_values
+    // leaves one half with (max_values - 1) / 2
+    enum { min_values = (max_values - 1) / 2 };
+    enum { children_offset = (values_offset + max_values * sizeof(Value) + sizeof(void*) - 1)
+                             / sizeof(void*) * sizeof(void*) };
+    enum { leaf_size = children_offset };
+    enum { internal_size = children_offset + (max_values + 1) * sizeof(void*) };
+
+    Value& value(int i)
+    {
+        return reinterpret_cast<Value*>(reinterpret_cast<char*>(this) + values_offset)[i];
+    }
+
+    node_ptr& child(int i)
+    {
+        return reinterpret_cast<node_ptr*>(reinterpret_cast<char*>(this) + children_offset)[i];
+    }
+
+    node_ptr parent_node() const { return static_cast<node_ptr>(parent); }
+};
+
+template <typename Value, typename Ref, typename Ptr, size_t NodeBytes>
+struct __btree_iterator
+{
+    typedef __btree_iterator<Value, Ref, Ptr, NodeBytes>                  self;
+    typedef __btree_iterator<Value, Value&, Value*, NodeBytes>            iterator;
+    typedef __btree_iterator<Value, const Value&, const Value*, NodeBytes> const_iterator;
+    typedef __btree_node<Value, NodeBytes>*                               node_ptr;
+
+    typedef bidirectional_iterator_tag    iterator_category;
+    typedef Value                         value_type;
+    typedef Ptr                           pointer;
+    typedef Ref                           reference;
+    typedef ptrdiff_t                     difference_type;
+
+    node_ptr node;
+    int position;
+
+    __btree_iterator() : node(nullptr), position(0) { }
+    __btree_iterator(node_ptr x, int pos) : node(x), position(pos) { }
+    __btree_iterator(const iterator& x) : node(x.node), position(x.position) { }
+
+    bool operator==(const self& x) const { return node == x.node && position == x.position; }
+    bool operator!=(const self& x) const { return !(*this == x); }
+
+    reference operator*() const { return node->value(position); }
+    pointer operator->() const { return &(operator*()); }
+
+    // the past-the-end position is one past the last value of the rightmost leaf
+    void increment()
+    {
+        if (node->leaf) {
+            if (++position < node->count)
+                return;
+            node_ptr save = node;
+            int save_position = position;
+            while (position == node->count && node->parent != nullptr) {
+                position = node->position;
+                node = node->parent_node();
+            }
+            if (position == node->count) {
+                node = save;
+                position = save_position;
+            }
+        } else {
+            node = node->child(position + 1);
+            while (!node->leaf)
+                node = node->child(0);
+            position = 0;
+        }
+    }
+
+    void decrement()
+    {
+        if (node->leaf) {
+            if (position > 0) {
+                --position;
+                return;
+            }
+            while (position == 0 && node->parent != nullptr) {
+                position = node->position;
+                node = node->parent_node();
+            }
+            --position;
+        } else {
+            node = node->child(position);
+            while (!node->leaf)
+                node = node->child(node->count);
+            position = node->count - 1;
+        }
+    }
+
+    self& operator++()
+    {
+        increment();
+        return *this;
+    }
+
+    self operator++(int)
+    {
+        self tmp = *this;
+        increment();
+        return tmp;
+    }
+
+    self& operator--()
+    {
+        decrement();
+        return *this;
+    }
+
+    self operator--(int)
+    {
+        self tmp = *this;
+        decrement();
+        return tmp;
+    }
+};
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare,
+          typename Alloc = alloc, size_t NodeBytes = 256>
+class BTree
+{
+private:
+    typedef __btree_node<Value, NodeBytes>    btree_node;
+    typedef btree_node*                       node_ptr;
+
+public:
+    typedef Key                  key_type;
+    typedef Value                value_type;
+    typedef value_type*          pointer;
+    typedef const value_type*    const_pointer;
+    typedef value_type&          reference;
+    typedef const value_type&    const_reference;
+    typedef size_t               size_type;
+    typedef ptrdiff_t            difference_type;
+
+    typedef __btree_iterator<value_type, reference, pointer, NodeBytes>
+            iterator;
+    typedef __btree_iterator<value_type, const_reference, const_pointer, NodeBytes>
+            const_iterator;
+
+    enum { node_values = btree_node::max_values };
+
+public:
+    BTree(const Compare& comp = Compare())
+      : root(nullptr), leftmost(nullptr), rightmost(nullptr),
+        node_count(0), key_compare(comp)
+    {
+    }
+
+    BTree(const BTree& x)
+      : root(nullptr), leftmost(nullptr), rightmost(nullptr),
+        node_count(0), key_compare(x.key_compare)
+    {
+        copy_from(x);
+    }
+
+    BTree& operator=(const BTree& x)
+    {
+        if (this != &x) {
+            BTree tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    ~BTree() { clear(); }
+
+public:
+    Compare key_comp() const { return key_compare; }
+    iterator begin() { return iterator(leftmost, 0); }
+    const_iterator begin() const { return const_iterator(leftmost, 0); }
+    iterator end() { return iterator(rightmost, rightmost ? rightmost->count : 0); }
+    const_iterator end() const { return const_iterator(rightmost, rightmost ? rightmost->count : 0); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    size_type max_size() const { return size_type(-1); }
+
+public:
+    // inserting shifts values and splits nodes, so every iterator is
+    // invalidated except the returned one
+    Pair<iterator, bool> insert_unique(const value_type& val)
+    {
+        if (root == nullptr)
+            return Pair<iterator, bool>(insert_into_leaf(new_root(), 0, val), true);
+
+        const key_type& k = KeyOfValue()(val);
+        node_ptr x = root;
+        while (true) {
+            int i = lower_bound_in_node(x, k);
+            if (i < x->count && !key_compare(k, key(x, i)))
+                return Pair<iterator, bool>(iterator(x, i), false);
+            if (x->leaf)
+                return Pair<iterator, bool>(insert_into_leaf(x, i, val), true);
+            x = x->child(i);
+        }
+    }
+
+    iterator insert_equal(const value_type& val)
+    {
+        if (root == nullptr)
+            return insert_into_leaf(new_root(), 0, val);
+
+        const key_type& k = KeyOfValue()(val);
+        node_ptr x = root;
+        while (true) {
+            int i = upper_bound_in_node(x, k);
+            if (x->leaf)
+                return insert_into_leaf(x, i, val);
+            x = x->child(i);
+        }
+    }
+
+    template <typename InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert_unique(*first);
+    }
+
+    template <typename InputIterator>
+    void insert_equal(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert_equal(*first);
+    }
+
+    // erasing moves values between nodes, so every iterator is invalidated;
+    // the returned one points to the element that followed pos
+    iterator erase(iterator pos) { return erase_at(pos.node, pos.position); }
+
+    void erase(iterator first, iterator last)
+    {
+        if (first == begin() && last == end()) {
+            clear();
+        } else {
+            difference_type n = Zyx::distance(first, last);
+            for (; n > 0; --n)
+                first = erase(first);
+        }
+    }
+
+    size_type erase(const key_type& k)
+    {
+        size_type n = 0;
+        for (iterator it = lower_bound(k); it != end() && !key_compare(k, key(it.node, it.position)); ) {
+            it = erase_at(it.node, it.position);
+            ++n;
+        }
+        return n;
+    }
+
+    void clear()
+    {
+        if (root != nullptr) {
+            delete_subtree(root);
+            root = leftmost = rightmost = nullptr;
+            node_count = 0;
+        }
+    }
+
+    void swap(BTree& t)
+    {
+        Zyx::swap(root, t.root);
+        Zyx::swap(leftmost, t.leftmost);
+        Zyx::swap(rightmost, t.rightmost);
+        Zyx::swap(node_count, t.node_count);
+        Zyx::swap(key_compare, t.key_compare);
+    }
+
+public:
+    iterator find(const key_type& k)
+    {
+        iterator j = lower_bound(k);
+        return (j == end() || key_compare(k, key(j.node, j.position))) ? end() : j;
+    }
+
+    const_iterator find(const key_type& k) const
+    {
+        const_iterator j = lower_bound(k);
+        return (j == end() || key_compare(k, key(j.node, j.position))) ? end() : j;
+    }
+
+    size_type count(const key_type& k) const
+    {
+        Pair<const_iterator, const_iterator> p = equal_range(k);
+        return Zyx::distance(p.first, p.second);
+    }
+
+    // the bound is either a value on the search path or the deepest one found;
+    // every value in child(i) precedes value(i)
+    iterator lower_bound(const key_type& k)
+    {
+        iterator result = end();
+        for (node_ptr x = root; x != nullptr; ) {
+            int i = lower_bound_in_node(x, k);
+            if (i < x->count)
+                result = iterator(x, i);
+            x = x->leaf ? nullptr : x->child(i);
+        }
+        return result;
+    }
+
+    const_iterator lower_bound(const key_type& k) const
+    {
+        return const_cast<BTree*>(this)->lower_bound(k);
+    }
+
+    iterator upper_bound(const key_type& k)
+    {
+        iterator result = end();
+        for (node_ptr x = root; x != nullptr; ) {
+            int i = upper_bound_in_node(x, k);
+            if (i < x->count)
+                result = iterator(x, i);
+            x = x->leaf ? nullptr : x->child(i);
+        }
+        return result;
+    }
+
+    const_iterator upper_bound(const key_type& k) const
+    {
+        return const_cast<BTree*>(this)->upper_bound(k);
+    }
+
+    Pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return Pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+
+    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return Pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+
+    // checks the links, the fill of every node, that all leaves are equally 
+    // deep and that the values are in order
+    bool __btree_verify() const
+    {
+        if (root == nullptr)
+            return leftmost == nullptr && rightmost == nullptr && node_count == 0;
+        if (root->parent != nullptr || __verify_subtree(root, true, true) < 0)
+            return false;
+        node_ptr first = root;
+        node_ptr last = root;
+        while (!first->leaf)
+            first = first->child(0);
+        while (!last->leaf)
+            last = last->child(last->count);
+        if (leftmost != first || rightmost != last)
+            return false;
+        size_type n = 0;
+        for (const_iterator prev = begin(), it = begin(); it != end(); prev = it++, ++n) {
+            if (n > 0 && key_compare(key(it.node, it.position), key(prev.node, prev.position)))
+                return false;
+        }
+        return n == node_count;
+    }
+
+private:
+    // the height of x, or -1; only the root and the nodes on the edges may 
+    // hold fewer than min_values
+    int __verify_subtree(node_ptr x, bool left_edge, bool right_edge) const
+    {
+        if (x->count == 0 || x->count > btree_node::max_values)
+            return -1;
+        if (x != root && !left_edge && !right_edge && x->count < btree_node::min_values)
+            return -1;
+        if (x->leaf)
+            return 0;
+        int height = -1;
+        for (int j = 0; j <= x->count; ++j) {
+            node_ptr c = x->child(j);
+            if (c->parent != x || c->position != j)
+                return -1;
+            int h = __verify_subtree(c, left_edge && j == 0, right_edge && j == x->count);
+            if (h < 0 || (j > 0 && h != height))
+                return -1;
+            height = h;
+        }
+        return height + 1;
+    }
+
+    static const key_type& key(node_ptr x, int i) { return KeyOfValue()(x->value(i)); }
+
+    int lower_bound_in_node(node_ptr x, const key_type& k) const
+    {
+        int lo = 0, hi = x->count;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (key_compare(key(x, mid), k))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    int upper_bound_in_node(node_ptr x, const key_type& k) const
+    {
+        int lo = 0, hi = x->count;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (key_compare(k, key(x, mid)))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+    static node_ptr new_node(bool leaf)
+    {
+        node_ptr x = static_cast<node_ptr>(Alloc::allocate(leaf ? btree_node::leaf_size 
+                                                                : btree_node::internal_size));
+        x->parent = nullptr;
+        x->position = 0;
+        x->count = 0;
+        x->leaf = leaf;
+        return x;
+    }
+
+    static void delete_node(node_ptr x)
+    {
+        Alloc::deallocate(x, x->leaf ? btree_node::leaf_size : btree_node::internal_size);
+    }
+
+    node_ptr new_root()
+    {
+        root = leftmost = rightmost = new_node(true);
+        return root;
+    }
+
+    static void set_child(node_ptr p, int i, node_ptr c)
+    {
+        p->child(i) = c;
+        c->parent = p;
+        c->position = static_cast<unsigned short>(i);
+    }
+
+    static void move_value(node_ptr dst, int i, node_ptr src, int j)
+    {
+        construct(&dst->value(i), src->value(j));
+        destroy(&src->value(j));
+    }
+
+    iterator insert_into_leaf(node_ptr x, int i, const value_type& val)
+    {
+        if (x->count == btree_node::max_values)
+            split(x, i);
+        for (int j = x->count; j > i; --j)
+            move_value(x, j, x, j - 1);
+        construct(&x->value(i), val);
+        ++x->count;
+        ++node_count;
+        return iterator(x, i);
+    }
+
+    // x must have room; c becomes the child right after the new value
+    static void insert_into_internal(node_ptr x, int i, const value_type& val, node_ptr c)
+    {
+        for (int j = x->count; j > i; --j) {
+            move_value(x, j, x, j - 1);
+            set_child(x, j + 1, x->child(j));
+        }
+        construct(&x->value(i), val);
+        set_child(x, i + 1, c);
+        ++x->count;
+    }
+
+    // splits the full node x ahead of an insertion at position i, then points
+    // x and i at the slot the new value belongs in. Appending past the right
+    // edge of the tree or prepending before its left edge leaves the untouched
+    // half full, so sorted input packs nodes densely. The node on the edge
+    // then holds fewer than min_values until later appends fill it; every
+    // other node except the root keeps at least min_values.
+    void split(node_ptr& x, int& i)
+    {
+        const int n = x->count;
+        const int mid = i == n && on_edge(x, true) ? n - 1 :
+                        i == 0 && on_edge(x, false) ? 1 : n / 2;
+
+        if (x == root) {
+            root = new_node(false);
+            set_child(root, 0, x);
+        } else if (x->parent_node()->count == btree_node::max_values) {
+            node_ptr p = x->parent_node();
+            int pos = x->position;
+            split(p, pos);
+        }
+
+        node_ptr s = new_node(x->leaf);
+        for (int j = mid + 1; j < n; ++j)
+            move_value(s, j - mid - 1, x, j);
+        if (!x->leaf) {
+            for (int j = mid + 1; j <= n; ++j)
+                set_child(s, j - mid - 1, x->child(j));
+        }
+        s->count = static_cast<unsigned short>(n - mid - 1);
+
+        insert_into_internal(x->parent_node(), x->position, x->value(mid), s);
+        destroy(&x->value(mid));
+        x->count = static_cast<unsigned short>(mid);
+        if (x == rightmost)
+            rightmost = s;
+
+        if (i > mid) {
+            x = s;
+            i -= mid + 1;
+        }
+    }
+
+    // whether x is on the path from the root to rightmost, or to leftmost
+    bool on_edge(node_ptr x, bool right) const
+    {
+        while (!x->leaf)
+            x = x->child(right ? x->count : 0);
+        return x == (right ? rightmost : leftmost);
+    }
+
+    // values of internal nodes are replaced by their predecessor, so only
+    // leaves ever lose a slot. Returns the successor of the erased value.
+    iterator erase_at(node_ptr x, int i)
+    {
+        const bool internal = !x->leaf;
+        if (internal) {
+            node_ptr y = x->child(i);
+            while (!y->leaf)
+                y = y->child(y->count);
+            destroy(&x->value(i));
+            construct(&x->value(i), y->value(y->count - 1));
+            x = y;
+            i = y->count - 1;
+        }
+        destroy(&x->value(i));
+        for (int j = i + 1; j < x->count; ++j)
+            move_value(x, j - 1, x, j);
+        --x->count;
+        --node_count;
+
+        // (x, i) is now the slot after the erased one; from an internal
+        // node that is the moved predecessor, one short of the successor
+        iterator result = rebalance(x, iterator(x, i));
+        if (internal)
+            ++result;
+        return result;
+    }
+
+    // Restores the minimum fill from the leaf x upwards. it is a position in
+    // x, possibly one past its last value, and is carried along when x's
+    // values move; positions in other leaves never move. The result is it
+    // made dereferenceable, or end().
+    iterator rebalance(node_ptr x, iterator it)
+    {
+        while (x != root && x->count < btree_node::min_values) {
+            node_ptr p = x->parent_node();
+            int pos = x->position;
+            if (pos > 0 && p->child(pos - 1)->count > btree_node::min_values) {
+                rotate_right(p, pos - 1);
+                if (it.node == x)
+                    ++it.position;
+                break;
+            }
+            if (pos < p->count && p->child(pos + 1)->count > btree_node::min_values) {
+                rotate_left(p, pos);
+                break;
+            }
+            if (pos > 0 && it.node == x) {
+                it.node = p->child(pos - 1);
+                it.position += it.node->count + 1;
+            }
+            merge_children(p, pos > 0 ? pos - 1 : pos);
+            x = p;
+        }
+
+        if (root->count == 0) {
+            node_ptr old = root;
+            if (root->leaf) {
+                root = leftmost = rightmost = nullptr;
+                delete_node(old);
+                return end();
+            }
+            root = root->child(0);
+            root->parent = nullptr;
+            root->position = 0;
+            delete_node(old);
+        }
+
+        while (it.position == it.node->count && it.node->parent != nullptr) {
+            it.position = it.node->position;
+            it.node = it.node->parent_node();
+        }
+        return it.position == it.node->count ? end() : it;
+    }
+
+    // moves the last value of child(i) up into p and the separator down into child(i + 1)
+    static void rotate_right(node_ptr p, int i)
+    {
+        node_ptr left = p->child(i);
+        node_ptr right = p->child(i + 1);
+        for (int j = right->count; j > 0; --j)
+            move_value(right, j, right, j - 1);
+        if (!right->leaf) {
+            for (int j = right->count + 1; j > 0; --j)
+                set_child(right, j, right->child(j - 1));
+            set_child(right, 0, left->child(left->count));
+        }
+        move_value(right, 0, p, i);
+        move_value(p, i, left, left->count - 1);
+        --left->count;
+        ++right->count;
+    }
+
+    // moves the first value of child(i + 1) up into p and the separator down into child(i)
+    static void rotate_left(node_ptr p, int i)
+    {
+        node_ptr left = p->child(i);
+        node_ptr right = p->child(i + 1);
+        move_value(left, left->count, p, i);
+        move_value(p, i, right, 0);
+        if (!left->leaf)
+            set_child(left, left->count + 1, right->child(0));
+        for (int j = 1; j < right->count; ++j)
+            move_value(right, j - 1, right, j);
+        if (!right->leaf) {
+            for (int j = 1; j <= right->count; ++j)
+                set_child(right, j - 1, right->child(j));
+        }
+        ++left->count;
+        --right->count;
+    }
+
+    // folds the separator and child(i + 1) into child(i)
+    void merge_children(node_ptr p, int i)
+    {
+        node_ptr left = p->child(i);
+        node_ptr right = p->child(i + 1);
+        const int n = left->count;
+        move_value(left, n, p, i);
+        for (int j = 0; j < right->count; ++j)
+            move_value(left, n + 1 + j, right, j);
+        if (!left->leaf) {
+            for (int j = 0; j <= right->count; ++j)
+                set_child(left, n + 1 + j, right->child(j));
+        }
+        left->count = static_cast<unsigned short>(n + 1 + right->count);
+
+        for (int j = i + 1; j < p->count; ++j) {
+            move_value(p, j - 1, p, j);
+            set_child(p, j, p->child(j + 1));
+        }
+        --p->count;
+
+        if (right == rightmost)
+            rightmost = left;
+        delete_node(right);
+    }
+
+    static void delete_subtree(node_ptr x)
+    {
+        if (!x->leaf) {
+            for (int j = 0; j <= x->count; ++j)
+                delete_subtree(x->child(j));
+        }
+        for (int j = 0; j < x->count; ++j)
+            destroy(&x->value(j));
+        delete_node(x);
+    }
+
+    static node_ptr copy_subtree(node_ptr x)
+    {
+        node_ptr top = new_node(x->leaf);
+        for (int j = 0; j < x->count; ++j) {
+            construct(&top->value(j), x->value(j));
+            ++top->count;
+        }
+        if (!x->leaf) {
+            for (int j = 0; j <= x->count; ++j)
+                set_child(top, j, copy_subtree(x->child(j)));
+        }
+        return top;
+    }
+
+    void copy_from(const BTree& x)
+    {
+        if (x.root != nullptr) {
+            root = copy_subtree(x.root);
+            for (leftmost = root; !leftmost->leaf; leftmost = leftmost->child(0))
+                ;
+            for (rightmost = root; !rightmost->leaf; rightmost = rightmost->child(rightmost->count))
+                ;
+            node_count = x.node_count;
+        }
+    }
+
+private:
+    node_ptr root;
+    node_ptr leftmost;
+    node_ptr rightmost;
+    size_type node_count;
+    Compare key_compare;
+};
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, size_t NodeBytes>
+inline bool operator==(const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& lhs,
+                       const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, size_t NodeBytes>
+inline bool operator!=(const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& lhs,
+                       const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, size_t NodeBytes>
+inline bool operator<(const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& lhs,
+                      const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, size_t NodeBytes>
+inline bool operator>(const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& lhs,
+                      const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, size_t NodeBytes>
+inline bool operator<=(const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& lhs,
+                       const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, size_t NodeBytes>
+inline bool operator>=(const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& lhs,
+                       const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, size_t NodeBytes>
+inline void swap(BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& x,
+                 BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& y)
+{
+    x.swap(y);
+}
+
+}
+
+#endif
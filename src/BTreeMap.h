@@ -0,0 +1,362 @@
+#ifndef ZYX_BTREE_MAP
+#define ZYX_BTREE_MAP
+
+#include "BTree.h"
+#include "Functional.h"
+
+namespace Zyx {
+
+//-------------------------------------【BTreeMap class】-------------------------------------
+
+// The interface of Map over a BTree. Unlike Map, both insert
+// and erase invalidate every iterator, pointer and reference to elements.
+template <typename Key, typename Value, typename Compare = less<Key>,
+          typename Alloc = alloc, size_t NodeBytes = 256>
+class BTreeMap
+{
+public:
+    typedef Key                                  key_type;
+    typedef Value                                data_type;
+    typedef Value                                mapped_type;
+    typedef Pair<const key_type, mapped_type>    value_type;
+    typedef Compare                              key_compare;
+
+public:
+    class value_compare
+    {
+    public:
+        friend class BTreeMap;
+        typedef value_type first_argument_type;
+        typedef value_type second_argument_type;
+        typedef bool result_type;
+        bool operator()(const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+
+    private:
+        Compare comp;
+        value_compare(Compare c) : comp(c) { }
+    };
+
+private:
+    typedef BTree<key_type, value_type, select1st<value_type>, key_compare, Alloc, NodeBytes>
+            rep_type;
+
+public:
+    typedef typename rep_type::pointer            pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::reference          reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::iterator           iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    BTreeMap() : t(Compare()) { }
+    explicit BTreeMap(const Compare& comp) : t(comp) { }
+
+    template <typename InputIterator>
+    BTreeMap(InputIterator first, InputIterator last) : t(Compare())
+    {
+        t.insert_unique(first, last);
+    }
+
+    template <typename InputIterator>
+    BTreeMap(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
+    {
+        t.insert_unique(first, last);
+    }
+
+    BTreeMap(const BTreeMap& x) : t(x.t) { }
+
+    BTreeMap& operator=(const BTreeMap& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    // unlike the red-black tree containers, inserting invalidates all
+    // iterators except the returned one
+    Pair<iterator, bool> insert(const value_type& val) { return t.insert_unique(val); }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_unique(first, last);
+    }
+
+    mapped_type& operator[](const key_type& k)
+    {
+        return insert(value_type(k, mapped_type())).first->second;
+    }
+
+    // unlike the red-black tree containers, erasing invalidates all iterators
+    // too; the returned one points to the element after pos
+    iterator erase(iterator pos) { return t.erase(pos); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    void clear() { t.clear(); }
+    void swap(BTreeMap& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) { return t.find(k); }
+    const_iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+    iterator lower_bound(const key_type& k) { return t.lower_bound(k); }
+    const_iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+    iterator upper_bound(const key_type& k) { return t.upper_bound(k); }
+    const_iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return t.equal_range(k);
+    }
+
+    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator==(const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator!=(const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<(const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>(const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<=(const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>=(const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline void swap(BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                 BTreeMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+//-------------------------------------【BTreeMultiMap class】-------------------------------------
+
+template <typename Key, typename Value, typename Compare = less<Key>,
+          typename Alloc = alloc, size_t NodeBytes = 256>
+class BTreeMultiMap
+{
+public:
+    typedef Key                                  key_type;
+    typedef Value                                data_type;
+    typedef Value                                mapped_type;
+    typedef Pair<const key_type, mapped_type>    value_type;
+    typedef Compare                              key_compare;
+
+public:
+    class value_compare
+    {
+    public:
+        friend class BTreeMultiMap;
+        typedef value_type first_argument_type;
+        typedef value_type second_argument_type;
+        typedef bool result_type;
+        bool operator()(const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+
+    private:
+        Compare comp;
+        value_compare(Compare c) : comp(c) { }
+    };
+
+private:
+    typedef BTree<key_type, value_type, select1st<value_type>, key_compare, Alloc, NodeBytes>
+            rep_type;
+
+public:
+    typedef typename rep_type::pointer            pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::reference          reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::iterator           iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    BTreeMultiMap() : t(Compare()) { }
+    explicit BTreeMultiMap(const Compare& comp) : t(comp) { }
+
+    template <typename InputIterator>
+    BTreeMultiMap(InputIterator first, InputIterator last) : t(Compare())
+    {
+        t.insert_equal(first, last);
+    }
+
+    template <typename InputIterator>
+    BTreeMultiMap(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
+    {
+        t.insert_equal(first, last);
+    }
+
+    BTreeMultiMap(const BTreeMultiMap& x) : t(x.t) { }
+
+    BTreeMultiMap& operator=(const BTreeMultiMap& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    // unlike the red-black tree containers, inserting invalidates all
+    // iterators except the returned one
+    iterator insert(const value_type& val) { return t.insert_equal(val); }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_equal(first, last);
+    }
+
+    // unlike the red-black tree containers, erasing invalidates all iterators
+    // too; the returned one points to the element after pos
+    iterator erase(iterator pos) { return t.erase(pos); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    void clear() { t.clear(); }
+    void swap(BTreeMultiMap& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) { return t.find(k); }
+    const_iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+    iterator lower_bound(const key_type& k) { return t.lower_bound(k); }
+    const_iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+    iterator upper_bound(const key_type& k) { return t.upper_bound(k); }
+    const_iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return t.equal_range(k);
+    }
+
+    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator==(const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator!=(const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<(const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>(const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<=(const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>=(const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc, size_t NodeBytes>
+inline void swap(BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& lhs,
+                 BTreeMultiMap<Key, Value, Compare, Alloc, NodeBytes>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
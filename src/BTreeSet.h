@@ -0,0 +1,317 @@
+#ifndef ZYX_BTREE_SET
+#define ZYX_BTREE_SET
+
+#include "BTree.h"
+#include "Functional.h"
+
+namespace Zyx {
+
+//-------------------------------------【BTreeSet class】-------------------------------------
+
+// The interface of Set over a BTree. Unlike Set, both insert
+// and erase invalidate every iterator, pointer and reference to elements.
+template <typename Key, typename Compare = less<Key>, typename Alloc = alloc,
+          size_t NodeBytes = 256>
+class BTreeSet
+{
+private:
+    typedef BTree<Key, Key, identity<Key>, Compare, Alloc, NodeBytes> rep_type;
+    typedef typename rep_type::iterator rep_iterator;
+
+public:
+    typedef Key        key_type;
+    typedef Key        value_type;
+    typedef Compare    key_compare;
+    typedef Compare    value_compare;
+
+    typedef typename rep_type::const_pointer      pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::const_reference    reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::const_iterator     iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    BTreeSet() : t(Compare()) { }
+    explicit BTreeSet(const Compare& comp) : t(comp) { }
+
+    template <typename InputIterator>
+    BTreeSet(InputIterator first, InputIterator last) : t(Compare())
+    {
+        t.insert_unique(first, last);
+    }
+
+    template <typename InputIterator>
+    BTreeSet(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
+    {
+        t.insert_unique(first, last);
+    }
+
+    BTreeSet(const BTreeSet& x) : t(x.t) { }
+
+    BTreeSet& operator=(const BTreeSet& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    // unlike the red-black tree containers, inserting invalidates all
+    // iterators except the returned one
+    Pair<iterator, bool> insert(const value_type& val)
+    {
+        Pair<typename rep_type::iterator, bool> p = t.insert_unique(val);
+        return Pair<iterator, bool>(p.first, p.second);
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_unique(first, last);
+    }
+
+    // unlike the red-black tree containers, erasing invalidates all iterators
+    // too; the returned one points to the element after pos
+    iterator erase(iterator pos)
+    {
+        return t.erase(rep_iterator(pos.node, pos.position));
+    }
+
+    void erase(iterator first, iterator last)
+    {
+        t.erase(rep_iterator(first.node, first.position), rep_iterator(last.node, last.position));
+    }
+
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    void clear() { t.clear(); }
+    void swap(BTreeSet& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+    iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+    iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator==(const BTreeSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator!=(const BTreeSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<(const BTreeSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>(const BTreeSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<=(const BTreeSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>=(const BTreeSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline void swap(BTreeSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                 BTreeSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+//-------------------------------------【BTreeMultiSet class】-------------------------------------
+
+template <typename Key, typename Compare = less<Key>, typename Alloc = alloc,
+          size_t NodeBytes = 256>
+class BTreeMultiSet
+{
+private:
+    typedef BTree<Key, Key, identity<Key>, Compare, Alloc, NodeBytes> rep_type;
+    typedef typename rep_type::iterator rep_iterator;
+
+public:
+    typedef Key        key_type;
+    typedef Key        value_type;
+    typedef Compare    key_compare;
+    typedef Compare    value_compare;
+
+    typedef typename rep_type::const_pointer      pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::const_reference    reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::const_iterator     iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    BTreeMultiSet() : t(Compare()) { }
+    explicit BTreeMultiSet(const Compare& comp) : t(comp) { }
+
+    template <typename InputIterator>
+    BTreeMultiSet(InputIterator first, InputIterator last) : t(Compare())
+    {
+        t.insert_equal(first, last);
+    }
+
+    template <typename InputIterator>
+    BTreeMultiSet(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
+    {
+        t.insert_equal(first, last);
+    }
+
+    BTreeMultiSet(const BTreeMultiSet& x) : t(x.t) { }
+
+    BTreeMultiSet& operator=(const BTreeMultiSet& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    // unlike the red-black tree containers, inserting invalidates all
+    // iterators except the returned one
+    iterator insert(const value_type& val) { return t.insert_equal(val); }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_equal(first, last);
+    }
+
+    // unlike the red-black tree containers, erasing invalidates all iterators
+    // too; the returned one points to the element after pos
+    iterator erase(iterator pos)
+    {
+        return t.erase(rep_iterator(pos.node, pos.position));
+    }
+
+    void erase(iterator first, iterator last)
+    {
+        t.erase(rep_iterator(first.node, first.position), rep_iterator(last.node, last.position));
+    }
+
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    void clear() { t.clear(); }
+    void swap(BTreeMultiSet& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+    iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+    iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator==(const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator!=(const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<(const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>(const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                      const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator<=(const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline bool operator>=(const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                       const BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, size_t NodeBytes>
+inline void swap(BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& lhs,
+                 BTreeMultiSet<Key, Compare, Alloc, NodeBytes>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
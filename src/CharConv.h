@@ -0,0 +1,579 @@
+#ifndef ZYX_CHAR_CONV
+#define ZYX_CHAR_CONV
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Zyx {
+
+// Number to text and back without sprintf or temporary buffers. to_chars
+// writes at first and returns the end of the text, or nullptr when it does
+// not fit before last. from_chars parses a prefix of [first, last) and
+// returns where parsing stopped, or first, leaving value alone, when there
+// is no number or it is out of range. Neither skips whitespace or accepts
+// a leading '+'.
+
+// no number takes more characters than this
+enum { __MAX_NUMBER_CHARS = 32 };
+
+inline int __highest_bit64(unsigned long long x)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long r;
+    _BitScanReverse64(&r, x);
+    return static_cast<int>(r);
+#else
+    int r = 0;
+    while (x >>= 1)
+        ++r;
+    return r;
+#endif
+}
+
+inline const unsigned long long* __pow10_table()
+{
+    static const unsigned long long table[20] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+        100000000ull, 1000000000ull, 10000000000ull, 100000000000ull,
+        1000000000000ull, 10000000000000ull, 100000000000000ull,
+        1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull
+    };
+    return table;
+}
+
+// the bit length gives the digit count to within one; a single compare
+// against a power of ten settles it
+inline int __count_digits(unsigned long long v)
+{
+    v |= 1;
+    const int t = (__highest_bit64(v) + 1) * 1233 >> 12;
+    return t + (v >= __pow10_table()[t]);
+}
+
+inline const char* __digit_pairs()
+{
+    static const char table[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    return table;
+}
+
+// writes the digits of v two at a time, from the right
+inline char* __write_digits(char* out, unsigned long long v)
+{
+    const char* pairs = __digit_pairs();
+    char* const end = out + __count_digits(v);
+    char* p = end;
+    while (v >= 100) {
+        const unsigned i = static_cast<unsigned>(v % 100) * 2;
+        v /= 100;
+        *--p = pairs[i + 1];
+        *--p = pairs[i];
+    }
+    if (v >= 10) {
+        *--p = pairs[v * 2 + 1];
+        *--p = pairs[v * 2];
+    } else {
+        *--p = static_cast<char>('0' + v);
+    }
+    return end;
+}
+
+inline char* __write_integer(char* out, long long v)
+{
+    unsigned long long u = static_cast<unsigned long long>(v);
+    if (v < 0) {
+        *out++ = '-';
+        u = 0 - u;
+    }
+    return __write_digits(out, u);
+}
+
+//---------------------------------------【Grisu2】-------------------------------------------
+
+// Shortest double to text, after Florian Loitsch's Grisu2 as laid out in
+// RapidJSON's dtoa. The digits always read back as the same double; in
+// rare cases a shorter such string exists.
+
+// the value f * 2^e
+struct __diy_fp
+{
+    unsigned long long f;
+    int e;
+
+    __diy_fp(unsigned long long f_, int e_) : f(f_), e(e_) { }
+
+    __diy_fp operator-(const __diy_fp& x) const { return __diy_fp(f - x.f, e); }
+
+    // the upper 64 bits of the 128-bit product, rounded
+    __diy_fp operator*(const __diy_fp& x) const
+    {
+        const unsigned long long M32 = 0xFFFFFFFFull;
+        const unsigned long long a = f >> 32, b = f & M32, c = x.f >> 32, d = x.f & M32;
+        const unsigned long long ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        unsigned long long tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+        tmp += 1ull << 31;
+        return __diy_fp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + x.e + 64);
+    }
+
+    __diy_fp normalize() const
+    {
+        const int shift = 63 - __highest_bit64(f);
+        return __diy_fp(f << shift, e - shift);
+    }
+};
+
+// a power of ten c with -60 <= e + c.e + 64 <= -32, and K with c ~ 10^-K
+inline __diy_fp __cached_power(int e, int& K)
+{
+    static const unsigned long long significands[] = {
+        0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull,
+        0xcf42894a5dce35eaull, 0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull,
+        0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full, 0xbe5691ef416bd60cull,
+        0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+        0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull,
+        0xc21094364dfb5637ull, 0x9096ea6f3848984full, 0xd77485cb25823ac7ull,
+        0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull, 0xb23867fb2a35b28eull,
+        0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+        0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull,
+        0xb5b5ada8aaff80b8ull, 0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull,
+        0x964e858c91ba2655ull, 0xdff9772470297ebdull, 0xa6dfbd9fb8e5b88full,
+        0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+        0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull,
+        0xaa242499697392d3ull, 0xfd87b5f28300ca0eull, 0xbce5086492111aebull,
+        0x8cbccc096f5088ccull, 0xd1b71758e219652cull, 0x9c40000000000000ull,
+        0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+        0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull,
+        0x9f4f2726179a2245ull, 0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull,
+        0x83c7088e1aab65dbull, 0xc45d1df942711d9aull, 0x924d692ca61be758ull,
+        0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+        0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull,
+        0x952ab45cfa97a0b3ull, 0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull,
+        0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull, 0x88fcf317f22241e2ull,
+        0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+        0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull,
+        0x8bab8eefb6409c1aull, 0xd01fef10a657842cull, 0x9b10a4e5e9913129ull,
+        0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull, 0x80444b5e7aa7cf85ull,
+        0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+        0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull    };
+    static const short exponents[] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007,  -980,
+         -954,  -927,  -901,  -874,  -847,  -821,  -794,  -768,  -741,  -715,
+         -688,  -661,  -635,  -608,  -582,  -555,  -529,  -502,  -475,  -449,
+         -422,  -396,  -369,  -343,  -316,  -289,  -263,  -236,  -210,  -183,
+         -157,  -130,  -103,   -77,   -50,   -24,     3,    30,    56,    83,
+          109,   136,   162,   189,   216,   242,   269,   295,   322,   348,
+          375,   402,   428,   455,   481,   508,   534,   561,   588,   614,
+          641,   667,   694,   720,   747,   774,   800,   827,   853,   880,
+          907,   933,   960,   986,  1013,  1039,  1066    };
+    const double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0)
+        ++k;
+    const int index = (k >> 3) + 1;
+    K = -(-348 + index * 8);
+    return __diy_fp(significands[index], exponents[index]);
+}
+
+inline void __grisu_round(char* buffer, int len, unsigned long long delta,
+                          unsigned long long rest, unsigned long long ten_kappa,
+                          unsigned long long wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        --buffer[len - 1];
+        rest += ten_kappa;
+    }
+}
+
+// writes the shortest digits within delta of Mp; K gains their exponent
+inline int __grisu_digits(const __diy_fp& W, const __diy_fp& Mp, unsigned long long delta,
+                          char* buffer, int& K)
+{
+    const unsigned long long* pow10 = __pow10_table();
+    const __diy_fp one(1ull << -Mp.e, Mp.e);
+    const __diy_fp wp_w = Mp - W;
+    unsigned p1 = static_cast<unsigned>(Mp.f >> -one.e);
+    unsigned long long p2 = Mp.f & (one.f - 1);
+    int kappa = __count_digits(p1);
+    int len = 0;
+    while (kappa > 0) {
+        const unsigned d = static_cast<unsigned>(p1 / pow10[kappa - 1]);
+        p1 = static_cast<unsigned>(p1 % pow10[kappa - 1]);
+        if (d != 0 || len != 0)
+            buffer[len++] = static_cast<char>('0' + d);
+        --kappa;
+        const unsigned long long rest = (static_cast<unsigned long long>(p1) << -one.e) + p2;
+        if (rest <= delta) {
+            K += kappa;
+            __grisu_round(buffer, len, delta, rest, pow10[kappa] << -one.e, wp_w.f);
+            return len;
+        }
+    }
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        const char d = static_cast<char>(p2 >> -one.e);
+        if (d != 0 || len != 0)
+            buffer[len++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta) {
+            K += kappa;
+            const int index = -kappa;
+            __grisu_round(buffer, len, delta, p2, one.f, wp_w.f * (index < 20 ? pow10[index] : 0));
+            return len;
+        }
+    }
+}
+
+// v must be positive and finite; the result is the digits times 10^K
+inline int __grisu2(double v, char* buffer, int& K)
+{
+    const unsigned long long hidden = 1ull << 52;
+    unsigned long long bits;
+    memcpy(&bits, &v, sizeof(bits));
+    const int biased = static_cast<int>(bits >> 52);
+    const unsigned long long significand = bits & (hidden - 1);
+    const __diy_fp w = biased != 0 ? __diy_fp(significand + hidden, biased - 1075)
+                                   : __diy_fp(significand, -1074);
+
+    // the halfway points to the neighbouring doubles
+    const __diy_fp plus = __diy_fp((w.f << 1) + 1, w.e - 1).normalize();
+    __diy_fp minus = w.f == hidden ? __diy_fp((w.f << 2) - 1, w.e - 2)
+                                   : __diy_fp((w.f << 1) - 1, w.e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    const __diy_fp c = __cached_power(plus.e, K);
+    const __diy_fp W = w.normalize() * c;
+    __diy_fp Wp = plus * c;
+    __diy_fp Wm = minus * c;
+    ++Wm.f;
+    --Wp.f;
+    return __grisu_digits(W, Wp, Wp.f - Wm.f, buffer, K);
+}
+
+inline char* __write_exponent(char* out, int K)
+{
+    if (K < 0) {
+        *out++ = '-';
+        K = -K;
+    } else {
+        *out++ = '+';
+    }
+    if (K >= 100) {
+        *out++ = static_cast<char>('0' + K / 100);
+        K %= 100;
+        *out++ = __digit_pairs()[K * 2];
+        *out++ = __digit_pairs()[K * 2 + 1];
+        return out;
+    }
+    return __write_digits(out, static_cast<unsigned long long>(K));
+}
+
+// lays out len digits times 10^k the way JavaScript prints numbers: plain
+// notation from 1e-7 up to 1e21, exponent notation outside
+inline char* __prettify(char* buffer, int len, int k)
+{
+    const int kk = len + k;    // 10^(kk - 1) <= v < 10^kk
+    if (0 <= k && kk <= 21) {
+        memset(buffer + len, '0', k);
+        return buffer + kk;
+    }
+    if (0 < kk && kk <= 21) {
+        memmove(buffer + kk + 1, buffer + kk, len - kk);
+        buffer[kk] = '.';
+        return buffer + len + 1;
+    }
+    if (-6 < kk && kk <= 0) {
+        const int offset = 2 - kk;
+        memmove(buffer + offset, buffer, len);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        memset(buffer + 2, '0', offset - 2);
+        return buffer + len + offset;
+    }
+    if (len == 1) {
+        buffer[1] = 'e';
+        return __write_exponent(buffer + 2, kk - 1);
+    }
+    memmove(buffer + 2, buffer + 1, len - 1);
+    buffer[1] = '.';
+    buffer[len + 1] = 'e';
+    return __write_exponent(buffer + len + 2, kk - 1);
+}
+
+// needs __MAX_NUMBER_CHARS of room
+inline char* __write_double(char* out, double v)
+{
+    unsigned long long bits;
+    memcpy(&bits, &v, sizeof(bits));
+    if ((bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull) {
+        if ((bits & 0x000FFFFFFFFFFFFFull) != 0) {
+            memcpy(out, "nan", 3);
+            return out + 3;
+        }
+        if (v < 0)
+            *out++ = '-';
+        memcpy(out, "inf", 3);
+        return out + 3;
+    }
+    if (bits >> 63) {
+        *out++ = '-';
+        v = -v;
+    }
+    if (v == 0) {
+        *out++ = '0';
+        return out;
+    }
+    int K;
+    const int len = __grisu2(v, out, K);
+    return __prettify(out, len, K);
+}
+
+//-------------------------------------【to_chars()】-----------------------------------------
+
+inline char* to_chars(char* first, char* last, unsigned long long v)
+{
+    if (last - first < __count_digits(v))
+        return nullptr;
+    return __write_digits(first, v);
+}
+
+inline char* to_chars(char* first, char* last, long long v)
+{
+    if (v < 0) {
+        if (first == last)
+            return nullptr;
+        *first++ = '-';
+        return to_chars(first, last, 0 - static_cast<unsigned long long>(v));
+    }
+    return to_chars(first, last, static_cast<unsigned long long>(v));
+}
+
+inline char* to_chars(char* first, char* last, int v)
+{
+    return to_chars(first, last, static_cast<long long>(v));
+}
+
+inline char* to_chars(char* first, char* last, long v)
+{
+    return to_chars(first, last, static_cast<long long>(v));
+}
+
+inline char* to_chars(char* first, char* last, unsigned int v)
+{
+    return to_chars(first, last, static_cast<unsigned long long>(v));
+}
+
+inline char* to_chars(char* first, char* last, unsigned long v)
+{
+    return to_chars(first, last, static_cast<unsigned long long>(v));
+}
+
+// the shortest text that reads back as v
+inline char* to_chars(char* first, char* last, double v)
+{
+    char buffer[__MAX_NUMBER_CHARS];
+    const size_t n = __write_double(buffer, v) - buffer;
+    if (static_cast<size_t>(last - first) < n)
+        return nullptr;
+    memcpy(first, buffer, n);
+    return first + n;
+}
+
+//------------------------------------【from_chars()】----------------------------------------
+
+template <typename Unsigned>
+const char* __parse_unsigned(const char* first, const char* last, Unsigned& value, Unsigned max)
+{
+    Unsigned result = 0;
+    const char* p = first;
+    for (; p != last && static_cast<unsigned>(*p - '0') < 10; ++p) {
+        const unsigned d = static_cast<unsigned>(*p - '0');
+        if (result > (max - d) / 10)
+            return first;
+        result = result * 10 + d;
+    }
+    if (p != first)
+        value = result;
+    return p;
+}
+
+template <typename Unsigned>
+const char* __from_chars_unsigned(const char* first, const char* last, Unsigned& value)
+{
+    return __parse_unsigned(first, last, value, static_cast<Unsigned>(~static_cast<Unsigned>(0)));
+}
+
+template <typename Signed, typename Unsigned>
+const char* __from_chars_signed(const char* first, const char* last, Signed& value)
+{
+    const bool negative = first != last && *first == '-';
+    const Unsigned max = static_cast<Unsigned>(~static_cast<Unsigned>(0)) / 2 + negative;
+    Unsigned magnitude = 0;
+    const char* p = __parse_unsigned(first + negative, last, magnitude, max);
+    if (p == first + negative)
+        return first;
+    value = negative ? static_cast<Signed>(0 - magnitude) : static_cast<Signed>(magnitude);
+    return p;
+}
+
+inline const char* from_chars(const char* first, const char* last, int& value)
+{
+    return __from_chars_signed<int, unsigned int>(first, last, value);
+}
+
+inline const char* from_chars(const char* first, const char* last, long& value)
+{
+    return __from_chars_signed<long, unsigned long>(first, last, value);
+}
+
+inline const char* from_chars(const char* first, const char* last, long long& value)
+{
+    return __from_chars_signed<long long, unsigned long long>(first, last, value);
+}
+
+inline const char* from_chars(const char* first, const char* last, unsigned int& value)
+{
+    return __from_chars_unsigned(first, last, value);
+}
+
+inline const char* from_chars(const char* first, const char* last, unsigned long& value)
+{
+    return __from_chars_unsigned(first, last, value);
+}
+
+inline const char* from_chars(const char* first, const char* last, unsigned long long& value)
+{
+    return __from_chars_unsigned(first, last, value);
+}
+
+// how many leading characters of [p, last) spell the lowercase word in any case
+inline size_t __match_word(const char* p, const char* last, const char* word)
+{
+    size_t n = 0;
+    while (word[n] != '\0' && p + n != last && (p[n] | 0x20) == word[n])
+        ++n;
+    return n;
+}
+
+// inf, infinity or nan, the sign already skipped
+inline const char* __parse_special(const char* first, const char* p, const char* last, 
+                                   bool negative, double& value)
+{
+    unsigned long long bits;
+    const size_t n = __match_word(p, last, "infinity");
+    if (n >= 3) {
+        bits = 0x7FF0000000000000ull;
+        p += n == 8 ? 8 : 3;
+    } else if (__match_word(p, last, "nan") == 3) {
+        bits = 0x7FF8000000000000ull;
+        p += 3;
+    } else {
+        return first;
+    }
+    if (negative)
+        bits |= 1ull << 63;
+    memcpy(&value, &bits, sizeof(value));
+    return p;
+}
+
+// Accepts [-]digits[.digits][(e|E)[+|-]digits], and inf, infinity and nan
+// in any case as to_chars writes them. When the significant digits fit in
+// 53 bits and the power of ten is at most 22, both are exact doubles and
+// one multiplication or division rounds correctly; anything else goes to
+// strtod, which follows the C locale's decimal point. A value too large for
+// a double, or too small to be anything but zero, is out of range; one that
+// lands among the subnormals is kept.
+inline const char* from_chars(const char* first, const char* last, double& value)
+{
+    static const double exact_pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char* p = first;
+    const bool negative = p != last && *p == '-';
+    p += negative;
+    if (p != last && ((*p | 0x20) == 'i' || (*p | 0x20) == 'n'))
+        return __parse_special(first, p, last, negative, value);
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    const char* const mantissa_first = p;
+    for (; p != last && static_cast<unsigned>(*p - '0') < 10; ++p) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else {
+            ++exponent;
+        }
+    }
+    const char* const int_last = p;
+    if (p != last && *p == '.') {
+        for (++p; p != last && static_cast<unsigned>(*p - '0') < 10; ++p) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+    if (int_last == mantissa_first && p - int_last <= 1)
+        return first;
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        const bool exp_negative = q != last && *q == '-';
+        q += (q != last && (*q == '-' || *q == '+'));
+        int e = 0;
+        const char* const exp_first = q;
+        for (; q != last && static_cast<unsigned>(*q - '0') < 10; ++q) {
+            if (e < 100000)
+                e = e * 10 + (*q - '0');
+        }
+        if (q != exp_first) {
+            exponent += exp_negative ? -e : e;
+            p = q;
+        }
+    }
+    if (digits < 19 && mantissa <= (1ull << 53) && -22 <= exponent && exponent <= 22) {
+        double result = static_cast<double>(mantissa);
+        if (exponent < 0)
+            result /= exact_pow10[-exponent];
+        else
+            result *= exact_pow10[exponent];
+        value = negative ? -result : result;
+        return p;
+    }
+    char local[128];
+    const size_t n = p - first;
+    char* text = n < sizeof(local) ? local : static_cast<char*>(malloc(n + 1));
+    memcpy(text, first, n);
+    text[n] = '\0';
+    const int saved_errno = errno;
+    errno = 0;
+    const double result = strtod(text, nullptr);
+    const bool out_of_range = errno == ERANGE && 
+                              (result == 0 || result == HUGE_VAL || result == -HUGE_VAL);
+    if (text != local)
+        free(text);
+    errno = saved_errno;
+    if (out_of_range)
+        return first;
+    value = result;
+    return p;
+}
+
+}
+
+#endif
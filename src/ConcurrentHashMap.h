@@ -0,0 +1,215 @@
+#ifndef ZYX_CONCURRENT_HASH_MAP
+#define ZYX_CONCURRENT_HASH_MAP
+
+#include <new>
+#include "HashTable.h"
+#include "HashFun.h"
+#include "Functional.h"
+#include "Alloc.h"
+#include "Utility.h"
+#include "NonCopyable.h"
+#include "LockGuard.h"
+#include "RWLock.h"
+
+namespace Zyx {
+
+//--------------------------------【ConcurrentHashMap class】---------------------------------
+
+// A thread-safe hash map made of independently locked HashTable shards. A key's
+// shard is picked from the high bits of its (mixed) hash, so the low bits that
+// HashTable uses for its buckets stay well distributed inside each shard.
+//
+// Nodes default to malloc_alloc: one thread often erases what another
+// inserted, and default_alloc's per-thread free lists would then pile the
+// freed nodes up on the erasing thread.
+template <typename Key, typename T, typename HashFcn = hash<Key>,
+          typename EqualKey = equal_to<Key>, typename Alloc = malloc_alloc>
+class ConcurrentHashMap : NonCopyable
+{
+public:
+    typedef Key                   key_type;
+    typedef T                     data_type;
+    typedef T                     mapped_type;
+    typedef Pair<const Key, T>    value_type;
+    typedef HashFcn               hasher;
+    typedef EqualKey              key_equal;
+    typedef size_t                size_type;
+
+    typedef HashTable<value_type, key_type, hasher, select1st<value_type>, key_equal, Alloc>
+            shard_type;
+
+private:
+    struct shard
+    {
+        shard(size_type n, const hasher& hf, const key_equal& eql) : table(n, hf, eql) { }
+
+        mutable RWLock lock;
+        shard_type table;
+    };
+
+    typedef simple_alloc<shard, Alloc> shard_allocator;
+
+public:
+    explicit ConcurrentHashMap(size_type n_shards = 16, size_type n = 100)
+      : hash(hasher())
+    {
+        initialize_shards(n_shards, n, hasher(), key_equal());
+    }
+
+    ConcurrentHashMap(size_type n_shards, size_type n,
+                      const hasher& hf, const key_equal& eql)
+      : hash(hf)
+    {
+        initialize_shards(n_shards, n, hf, eql);
+    }
+
+    ~ConcurrentHashMap()
+    {
+        for (size_type i = 0; i < num_shards; ++i)
+            destroy(shards + i);
+        shard_allocator::deallocate(shards, num_shards);
+    }
+
+public:
+    hasher hash_function() const { return hash; }
+    size_type shard_count() const { return num_shards; }
+
+    // the result is only a snapshot: other threads may change the map meanwhile
+    size_type size() const
+    {
+        size_type result = 0;
+        for (size_type i = 0; i < num_shards; ++i) {
+            SharedLockGuard<RWLock> guard(shards[i].lock);
+            result += shards[i].table.size();
+        }
+        return result;
+    }
+
+    bool empty() const { return size() == 0; }
+
+public:
+    bool insert(const value_type& obj)
+    {
+        shard& s = shard_of(obj.first);
+        LockGuard<RWLock> guard(s.lock);
+        return s.table.insert_unique(obj).second;
+    }
+
+    // returns true if k was inserted, false if an existing value was replaced
+    bool insert_or_assign(const key_type& k, const mapped_type& obj)
+    {
+        shard& s = shard_of(k);
+        LockGuard<RWLock> guard(s.lock);
+        typename shard_type::iterator it = s.table.find(k);
+        if (it != s.table.end()) {
+            it->second = obj;
+            return false;
+        }
+        s.table.insert_unique(value_type(k, obj));
+        return true;
+    }
+
+    bool find(const key_type& k, mapped_type& result) const
+    {
+        const shard& s = shard_of(k);
+        SharedLockGuard<RWLock> guard(s.lock);
+        typename shard_type::const_iterator it = s.table.find(k);
+        if (it == s.table.end())
+            return false;
+        result = it->second;
+        return true;
+    }
+
+    // calls f(const value_type&) under the shard's read lock; f must not
+    // call back into this map
+    template <typename Function>
+    bool find_and_apply(const key_type& k, Function f) const
+    {
+        const shard& s = shard_of(k);
+        SharedLockGuard<RWLock> guard(s.lock);
+        typename shard_type::const_iterator it = s.table.find(k);
+        if (it == s.table.end())
+            return false;
+        f(*it);
+        return true;
+    }
+
+    size_type count(const key_type& k) const
+    {
+        const shard& s = shard_of(k);
+        SharedLockGuard<RWLock> guard(s.lock);
+        return s.table.count(k);
+    }
+
+    size_type erase(const key_type& k)
+    {
+        shard& s = shard_of(k);
+        LockGuard<RWLock> guard(s.lock);
+        return s.table.erase(k);
+    }
+
+    void clear()
+    {
+        for (size_type i = 0; i < num_shards; ++i) {
+            LockGuard<RWLock> guard(shards[i].lock);
+            shards[i].table.clear();
+        }
+    }
+
+    // calls f(shard_type&) on every shard in turn, each under its write lock
+    template <typename Function>
+    void for_each_shard(Function f)
+    {
+        for (size_type i = 0; i < num_shards; ++i) {
+            LockGuard<RWLock> guard(shards[i].lock);
+            f(shards[i].table);
+        }
+    }
+
+    // calls f(const shard_type&) on every shard in turn, each under its read lock
+    template <typename Function>
+    void for_each_shard(Function f) const
+    {
+        for (size_type i = 0; i < num_shards; ++i) {
+            SharedLockGuard<RWLock> guard(shards[i].lock);
+            f(static_cast<const shard_type&>(shards[i].table));
+        }
+    }
+
+private:
+    void initialize_shards(size_type n_shards, size_type n,
+                           const hasher& hf, const key_equal& eql)
+    {
+        shard_bits = 0;
+        while ((static_cast<size_type>(1) << shard_bits) < n_shards)
+            ++shard_bits;
+        num_shards = static_cast<size_type>(1) << shard_bits;
+        shards = shard_allocator::allocate(num_shards);
+        for (size_type i = 0; i < num_shards; ++i)
+            new (shards + i) shard(n / num_shards + 1, hf, eql);
+    }
+
+    size_type shard_index(const key_type& k) const
+    {
+        if (shard_bits == 0)
+            return 0;
+        // Fibonacci hashing spreads weak hashes (e.g. hash<int>) over the high bits
+        const size_type golden = sizeof(size_type) > 4
+                               ? static_cast<size_type>(0x9E3779B97F4A7C15ull)
+                               : static_cast<size_type>(0x9E3779B9ul);
+        return (hash(k) * golden) >> (sizeof(size_type) * 8 - shard_bits);
+    }
+
+    shard& shard_of(const key_type& k) { return shards[shard_index(k)]; }
+    const shard& shard_of(const key_type& k) const { return shards[shard_index(k)]; }
+
+private:
+    hasher hash;
+    shard* shards;
+    size_type num_shards;
+    size_type shard_bits;
+};
+
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef ZYX_EPOCH
+#define ZYX_EPOCH
+
+#include <atomic>
+#include <cstddef>
+#include "Alloc.h"
+#include "NonCopyable.h"
+#include "Singleton.h"
+
+namespace Zyx {
+
+//------------------------------------【EpochDomain class】-----------------------------------
+
+// Epoch-based reclamation for lock-free containers. A thread pins the current
+// epoch while it reads shared nodes (see EpochGuard). A node unlinked from a
+// structure is retired, not freed. It is freed once the global epoch is two
+// steps ahead of its retirement epoch, because by then no pinned reader can
+// still hold it.
+//
+// All bookkeeping is allocated with malloc_alloc: records are often freed on
+// another thread than the one that allocated them.
+class EpochDomain : NonCopyable
+{
+public:
+    typedef void (*deleter_type)(void*);
+
+private:
+    struct retired
+    {
+        void* ptr;
+        deleter_type deleter;
+        size_t epoch;
+        retired* next;
+    };
+
+    // one record per thread; records are recycled but never freed while the
+    // domain lives, so readers of the record list need no protection
+    struct record
+    {
+        std::atomic<size_t> state;      // (epoch << 1) | pinned
+        std::atomic<bool> in_use;
+        record* next;
+        size_t depth;                   // nesting of pins, owner only
+        retired* limbo;                 // owner only
+        size_t retire_count;            // owner only
+    };
+
+    typedef simple_alloc<record, malloc_alloc> record_allocator;
+    typedef simple_alloc<retired, malloc_alloc> retired_allocator;
+
+    enum { __COLLECT_INTERVAL = 64 };
+
+    struct local_handle
+    {
+        record* rec;
+        local_handle() : rec(nullptr) { }
+        ~local_handle()
+        {
+            if (rec != nullptr)
+                Singleton<EpochDomain>::instance().release_record(rec);
+        }
+    };
+
+public:
+    EpochDomain() : global_epoch(0), records(nullptr) { }
+
+    ~EpochDomain()
+    {
+        record* r = records.load();
+        while (r != nullptr) {
+            record* next = r->next;
+            free_limbo(r, size_t(-1));
+            r->~record();
+            record_allocator::deallocate(r);
+            r = next;
+        }
+    }
+
+public:
+    static EpochDomain& instance() { return Singleton<EpochDomain>::instance(); }
+
+    void pin()
+    {
+        record* r = local_record();
+        if (r->depth++ == 0) {
+            r->state.store((global_epoch.load() << 1) | 1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void unpin()
+    {
+        record* r = local_record();
+        if (--r->depth == 0)
+            r->state.store(r->state.load(std::memory_order_relaxed) & ~size_t(1),
+                           std::memory_order_release);
+    }
+
+    // p must already be unreachable for threads that pin after this call
+    void retire(void* p, deleter_type deleter)
+    {
+        record* r = local_record();
+        retired* node = retired_allocator::allocate();
+        node->ptr = p;
+        node->deleter = deleter;
+        node->epoch = global_epoch.load();
+        node->next = r->limbo;
+        r->limbo = node;
+        if (++r->retire_count % __COLLECT_INTERVAL == 0)
+            collect();
+    }
+
+    // tries to advance the epoch and frees what the calling thread retired
+    // long enough ago
+    void collect()
+    {
+        record* r = local_record();
+        try_advance();
+        const size_t epoch = global_epoch.load();
+        if (epoch >= 2)
+            free_limbo(r, epoch - 2);
+    }
+
+private:
+    void try_advance()
+    {
+        size_t epoch = global_epoch.load();
+        for (record* r = records.load(); r != nullptr; r = r->next) {
+            const size_t s = r->state.load();
+            if ((s & 1) && (s >> 1) != epoch)
+                return;
+        }
+        global_epoch.compare_exchange_strong(epoch, epoch + 1);
+    }
+
+    // frees the entries of r's limbo list retired at or before epoch
+    void free_limbo(record* r, size_t epoch)
+    {
+        retired** link = &r->limbo;
+        while (*link != nullptr) {
+            retired* cur = *link;
+            if (cur->epoch <= epoch) {
+                *link = cur->next;
+                cur->deleter(cur->ptr);
+                retired_allocator::deallocate(cur);
+            } else {
+                link = &cur->next;
+            }
+        }
+    }
+
+    record* local_record()
+    {
+        static thread_local local_handle handle;
+        if (handle.rec == nullptr)
+            handle.rec = acquire_record();
+        return handle.rec;
+    }
+
+    record* acquire_record()
+    {
+        for (record* r = records.load(); r != nullptr; r = r->next) {
+            bool expected = false;
+            if (!r->in_use.load() && r->in_use.compare_exchange_strong(expected, true))
+                return r;
+        }
+
+        record* r = record_allocator::allocate();
+        new (r) record;
+        r->state.store(0);
+        r->in_use.store(true);
+        r->depth = 0;
+        r->limbo = nullptr;
+        r->retire_count = 0;
+        r->next = records.load();
+        while (!records.compare_exchange_weak(r->next, r))
+            ;
+        return r;
+    }
+
+    // the limbo list stays with the record and is reclaimed by its next owner
+    void release_record(record* r)
+    {
+        r->state.store(0);
+        r->in_use.store(false);
+    }
+
+private:
+    std::atomic<size_t> global_epoch;
+    std::atomic<record*> records;
+};
+
+//------------------------------------【EpochGuard class】------------------------------------
+
+class EpochGuard : NonCopyable
+{
+public:
+    EpochGuard() { EpochDomain::instance().pin(); }
+    ~EpochGuard() { EpochDomain::instance().unpin(); }
+};
+
+}
+
+#endif
@@ -12,6 +12,16 @@ struct equal_to
     bool operator()(const T& x, const T& y) const { return x == y; }
 };
 
+template <>
+struct equal_to<void>
+{
+    typedef void is_transparent;
+    typedef bool result_type;
+
+    template <typename T, typename U>
+    bool operator()(const T& x, const U& y) const { return x == y; }
+};
+
 template <typename T>
 struct not_equal_to
 {
@@ -30,6 +40,16 @@ struct less
     bool operator()(const T& x, const T& y) const { return x < y; }
 };
 
+template <>
+struct less<void>
+{
+    typedef void is_transparent;
+    typedef bool result_type;
+
+    template <typename T, typename U>
+    bool operator()(const T& x, const U& y) const { return x < y; }
+};
+
 template <typename T>
 struct less_equal
 {
@@ -2,11 +2,20 @@
 #define ZYX_HASH_FUN 
 
 #include <cstddef>
+#include "TypeTraits.h"
 
 namespace Zyx {
 
 template <typename Key> struct hash { };
 
+// HashTable stores the full hash code in every node when this is _true_type 
+// for its hasher; specialize it for hashers that are expensive to evaluate.
+template <typename HashFcn>
+struct cache_hash_code
+{
+    typedef _false_type type;
+};
+
 inline size_t hash_string(const char* s)
 {
     unsigned long h = 0;
@@ -15,6 +24,14 @@ inline size_t hash_string(const char* s)
     return size_t(h);
 }
 
+inline size_t hash_string(const char* s, size_t n)
+{
+    unsigned long h = 0;
+    for (; n > 0; --n, ++s)
+    	h = 5 * h + *s;
+    return size_t(h);
+}
+
 template <>
 struct hash<char*>
 {
@@ -27,6 +44,18 @@ struct hash<const char*>
     size_t operator()(const char* s) const { return hash_string(s); }
 };
 
+template <>
+struct cache_hash_code<hash<char*> >
+{
+    typedef _true_type type;
+};
+
+template <>
+struct cache_hash_code<hash<const char*> >
+{
+    typedef _true_type type;
+};
+
 template <>
 struct hash<char>
 {
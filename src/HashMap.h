@@ -1,6 +1,7 @@
 #ifndef ZYX_HASH_MAP
 #define ZYX_HASH_MAP 
 
+#include <utility>
 #include "HashTable.h"
 #include "HashFun.h"
 #include "Functional.h"
@@ -39,6 +40,7 @@ public:
     typedef typename ht::const_iterator     const_iterator;
     typedef typename ht::size_type          size_type;
     typedef typename ht::difference_type    difference_type;
+    typedef typename ht::node_type          node_type;
 
 public:
     HashMap() : rep(100, hasher(), key_equal()) { }
@@ -116,10 +118,26 @@ public:
         return rep.find_or_insert(value_type(key, T())).second;
     }
 
+    Pair<iterator, bool> insert(node_type&& nh) { return rep.insert_unique(std::move(nh)); }
+
+    node_type extract(const_iterator pos) { return rep.extract(pos); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    void merge(HashMap& hm) { rep.merge_unique(hm.rep); }
+
     size_type erase(const key_type& key) { return rep.erase(key); }
     void erase(iterator pos) { rep.erase(pos); }
     void erase(iterator first, iterator last) { rep.erase(first, last); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return rep.erase_if(pred); }
+
+    // full scans with prefetching; f may change mapped values
+    template <typename Function>
+    Function for_each(Function f) { return rep.for_each(f); }
+
+    template <typename Function>
+    Function for_each(Function f) const { return rep.for_each(f); }
+
     void clear() { rep.clear(); }
     void swap(HashMap& hs) { rep.swap(hs.rep); }
 
@@ -139,6 +157,44 @@ public:
     	return rep.equal_range(key); 
     }
 
+private:
+    template <typename K, typename Result>
+    struct transparent_result : ht::template transparent_result<K, Result> { };
+
+public:
+    // lookups with any key type accepted by a transparent hasher and key_equal
+    template <typename K>
+    typename transparent_result<K, iterator>::type find(const K& key)
+    {
+        return rep.find(key);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type find(const K& key) const
+    {
+        return rep.find(key);
+    }
+
+    template <typename K>
+    typename transparent_result<K, size_type>::type count(const K& key) const
+    {
+        return rep.count(key);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<iterator, iterator> >::type 
+    equal_range(const K& key)
+    {
+        return rep.equal_range(key);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<const_iterator, const_iterator> >::type 
+    equal_range(const K& key) const
+    { 
+        return rep.equal_range(key); 
+    }
+
 private:
     ht rep;
 };
@@ -195,6 +251,7 @@ public:
     typedef typename ht::const_iterator     const_iterator;
     typedef typename ht::size_type          size_type;
     typedef typename ht::difference_type    difference_type;
+    typedef typename ht::node_type          node_type;
 
 public:
     HashMultiMap() : rep(100, hasher(), key_equal()) { }
@@ -267,10 +324,26 @@ public:
         rep.insert_equal(first, last);
     }
 
+    iterator insert(node_type&& nh) { return rep.insert_equal(std::move(nh)); }
+
+    node_type extract(const_iterator pos) { return rep.extract(pos); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    void merge(HashMultiMap& hm) { rep.merge_equal(hm.rep); }
+
     size_type erase(const key_type& key) { return rep.erase(key); }
     void erase(iterator pos) { rep.erase(pos); }
     void erase(iterator first, iterator last) { rep.erase(first, last); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return rep.erase_if(pred); }
+
+    // full scans with prefetching; f may change mapped values
+    template <typename Function>
+    Function for_each(Function f) { return rep.for_each(f); }
+
+    template <typename Function>
+    Function for_each(Function f) const { return rep.for_each(f); }
+
     void clear() { rep.clear(); }
     void swap(HashMultiMap& hs) { rep.swap(hs.rep); }
 
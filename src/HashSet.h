@@ -1,6 +1,7 @@
 #ifndef ZYX_HASH_SET
 #define ZYX_HASH_SET 
 
+#include <utility>
 #include "HashTable.h"
 #include "HashFun.h"
 #include "Functional.h"
@@ -34,6 +35,7 @@ public:
     typedef typename ht::const_iterator     const_iterator;
     typedef typename ht::size_type          size_type;
     typedef typename ht::difference_type    difference_type;
+    typedef typename ht::node_type          node_type;
 
 public:
     HashSet() : rep(100, hasher(), key_equal()) { }	
@@ -106,10 +108,27 @@ public:
     	rep.insert_unique(first, last);
     }
 
+    Pair<iterator, bool> insert(node_type&& nh)
+    {
+        Pair<typename ht::iterator, bool> p = rep.insert_unique(std::move(nh));
+        return Pair<iterator, bool>(p.first, p.second);
+    }
+
+    node_type extract(const_iterator pos) { return rep.extract(pos); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    void merge(HashSet& hs) { rep.merge_unique(hs.rep); }
+
     size_type erase(const key_type& key) { return rep.erase(key); }
     void erase(iterator pos) { rep.erase(pos); }
     void erase(iterator first, iterator last) { rep.erase(first, last); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return rep.erase_if(pred); }
+
+    // full scan with prefetching
+    template <typename Function>
+    Function for_each(Function f) const { return rep.for_each(f); }
+
     void clear() { rep.clear(); }
     void swap(HashSet& hs) { rep.swap(hs.rep); }
 
@@ -122,6 +141,31 @@ public:
     	return rep.equal_range(key); 
     }
 
+private:
+    template <typename K, typename Result>
+    struct transparent_result : ht::template transparent_result<K, Result> { };
+
+public:
+    // lookups with any key type accepted by a transparent hasher and key_equal
+    template <typename K>
+    typename transparent_result<K, iterator>::type find(const K& key) const
+    {
+        return rep.find(key);
+    }
+
+    template <typename K>
+    typename transparent_result<K, size_type>::type count(const K& key) const
+    {
+        return rep.count(key);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<iterator, iterator> >::type 
+    equal_range(const K& key) const
+    {
+        return rep.equal_range(key);
+    }
+
 private:
     ht rep;
 };
@@ -174,6 +218,7 @@ public:
     typedef typename ht::const_iterator     const_iterator;
     typedef typename ht::size_type          size_type;
     typedef typename ht::difference_type    difference_type;
+    typedef typename ht::node_type          node_type;
 
 public:
     HashMultiSet() : rep(100, hasher(), key_equal()) { }	
@@ -244,10 +289,23 @@ public:
     	rep.insert_equal(first, last);
     }
 
+    iterator insert(node_type&& nh) { return rep.insert_equal(std::move(nh)); }
+
+    node_type extract(const_iterator pos) { return rep.extract(pos); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    void merge(HashMultiSet& hs) { rep.merge_equal(hs.rep); }
+
     size_type erase(const key_type& key) { return rep.erase(key); }
     void erase(iterator pos) { rep.erase(pos); }
     void erase(iterator first, iterator last) { rep.erase(first, last); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return rep.erase_if(pred); }
+
+    // full scan with prefetching
+    template <typename Function>
+    Function for_each(Function f) const { return rep.for_each(f); }
+
     void clear() { rep.clear(); }
     void swap(HashMultiSet& hs) { rep.swap(hs.rep); }
 
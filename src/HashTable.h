@@ -1,22 +1,41 @@
 #ifndef ZYX_HASH_TABLE
 #define ZYX_HASH_TABLE
 
+#include "TypeTraits.h"
 #include "Iterator.h"
 #include "Alloc.h"
 #include "Construct.h"
 #include "Algorithm.h"
-#include "Utility"
+#include "Utility.h"
 #include "Vector.h"
+#include "HashFun.h"
+#include "NodeHandle.h"
 
 namespace Zyx {
 
-template <typename Value>
+template <typename Value, typename CacheHash = _false_type>
 struct __hashtable_node
 {
     __hashtable_node* next;
     Value val;
 };
 
+// node layout used when cache_hash_code<HashFcn> is _true_type: the full hash 
+// of the key is kept next to val, so rehashing and chain walks never call the hasher
+template <typename Value>
+struct __hashtable_node<Value, _true_type>
+{
+    __hashtable_node* next;
+    size_t hash_code;
+    Value val;
+};
+
+template <typename Value, typename CacheHash>
+inline Value& __node_value(__hashtable_node<Value, CacheHash>* p)
+{
+    return p->val;
+}
+
 template <typename Value, typename Key, typename HashFcn, typename ExtractKey, 
           typename EqualKey, typename Alloc = alloc>
 class HashTable;
@@ -29,7 +48,7 @@ struct __hashtable_iterator
             hashtable;
     typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> 
             iterator;
-    typedef __hashtable_node<Value> node;
+    typedef __hashtable_node<Value, typename cache_hash_code<HashFcn>::type> node;
 
     typedef forward_iterator_tag    iterator_category;
     typedef Value                   value_type;
@@ -55,7 +74,7 @@ struct __hashtable_iterator
         const node* old = cur;
         cur = cur->next;
         if (cur == nullptr) {
-            size_type bucket = ht->bkt_num(old->val);
+            size_type bucket = ht->bkt_num_node(old);
             while (cur == nullptr && ++bucket < ht->buckets.size())
                 cur = ht->buckets[bucket];
         }
@@ -80,7 +99,7 @@ struct __hashtable_const_iterator
             iterator;
     typedef __hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> 
             const_iterator;
-    typedef __hashtable_node<Value> node;
+    typedef __hashtable_node<Value, typename cache_hash_code<HashFcn>::type> node;
 
     typedef forward_iterator_tag    iterator_category;
     typedef Value                   value_type;
@@ -107,7 +126,7 @@ struct __hashtable_const_iterator
         const node* old = cur;
         cur = cur->next;
         if (cur == nullptr) {
-            size_type bucket = ht->bkt_num(old->val);
+            size_type bucket = ht->bkt_num_node(old);
             while (cur == nullptr && ++bucket < ht->buckets.size())
                 cur = ht->buckets[bucket];
         }
@@ -172,9 +191,15 @@ public:
             const_iterator;
 
 private:
-    typedef __hashtable_node<Value> node;
+    typedef typename cache_hash_code<HashFcn>::type cache_hash;
+    typedef __hashtable_node<Value, cache_hash> node;
     typedef simple_alloc<node, Alloc> node_allocator;
 
+    enum { __PREFETCH_DISTANCE = 8 };
+
+public:
+    typedef NodeHandle<node, value_type, Alloc> node_type;
+
 public:
     HashTable(size_type n, const hasher& hf, const key_equal& eql) 
       : hash(hf), equals(eql), get_key(ExtractKey()), num_elements(0)
@@ -308,14 +333,15 @@ public:
 
     size_type erase(const key_type& key)
     {
-        const size_type n = bkt_num_key(key);
+        const size_type code = hash(key);
+        const size_type n = code % buckets.size();
         node* first = buckets[n];
         size_type erased = 0;
         if (first != nullptr) {
             node* cur = first;
             node* next = cur->next;
             while (next) {
-                if (equals(get_key(next->val), key)) {
+                if (node_equals(next, code, key)) {
                     cur->next = next->next;
                     delete_node(next);
                     next = cur->next;
@@ -326,7 +352,7 @@ public:
                     next = cur->next;
                 }
             }
-            if (equals(get_key(first->val), key)) {
+            if (node_equals(first, code, key)) {
                 buckets[n] = first->next;
                 delete_node(first);
                 ++erased;
@@ -340,26 +366,8 @@ public:
     {
         node* p = pos.cur;
         if (p != nullptr) {
-            const size_type n = bkt_num(p->val);
-            node* cur = buckets[n];
-            if (cur == p) {
-                buckets[n] = cur->next;
-                delete_node(cur);
-                --num_elements;
-            } else {
-                node* next = cur->next;
-                while (next) {
-                    if (next == p) {
-                        cur->next = next->next;
-                        delete_node(next);
-                        --num_elements;
-                        break;
-                    } else {
-                        cur = next;
-                        next = cur->next;
-                    }
-                }
-            }
+            unlink_node(p);
+            delete_node(p);
         }
     }
 
@@ -370,8 +378,8 @@ public:
 
     void erase(iterator first, iterator last) 
     {
-        size_type f_bucket = first.cur ? bkt_num(first.cur->val) : buckets.size();
-        size_type l_bucket = last.cur ? bkt_num(last.cur->val) : buckets.size();
+        size_type f_bucket = first.cur ? bkt_num_node(first.cur) : buckets.size();
+        size_type l_bucket = last.cur ? bkt_num_node(last.cur) : buckets.size();
         if (first.cur == last.cur) {
             return;
         } else if (f_bucket == l_bucket) {
@@ -391,6 +399,67 @@ public:
               iterator(const_cast<node*>(last.cur), const_cast<HashTable*>(last.ht)));
     }
 
+    // calls f on every element, bucket by bucket. The bucket array is read 
+    // in order, so the chain heads a few buckets ahead can be prefetched 
+    // while f works on the current one.
+    template <typename Function>
+    Function for_each(Function f)
+    {
+        const size_type n = buckets.size();
+        for (size_type i = 0; i < n; ++i) {
+            if (i + __PREFETCH_DISTANCE < n)
+                __prefetch(buckets[i + __PREFETCH_DISTANCE]);
+            for (node* cur = buckets[i]; cur != nullptr; cur = cur->next)
+                f(cur->val);
+        }
+        return f;
+    }
+
+    template <typename Function>
+    Function for_each(Function f) const
+    {
+        const size_type n = buckets.size();
+        for (size_type i = 0; i < n; ++i) {
+            if (i + __PREFETCH_DISTANCE < n)
+                __prefetch(buckets[i + __PREFETCH_DISTANCE]);
+            for (const node* cur = buckets[i]; cur != nullptr; cur = cur->next)
+                f(cur->val);
+        }
+        return f;
+    }
+
+    // filters every bucket in one pass and frees the removed nodes together; 
+    // the scan stops once all elements have been seen
+    template <typename Predicate>
+    size_type erase_if(Predicate pred)
+    {
+        node* garbage = nullptr;
+        size_type seen = 0;
+        size_type erased = 0;
+        for (size_type n = 0; n < buckets.size() && seen < num_elements; ++n) {
+            node** link = &buckets[n];
+            while (*link != nullptr) {
+                node* cur = *link;
+                ++seen;
+                if (pred(cur->val)) {
+                    *link = cur->next;
+                    cur->next = garbage;
+                    garbage = cur;
+                    ++erased;
+                } else {
+                    link = &cur->next;
+                }
+            }
+        }
+        while (garbage != nullptr) {
+            node* next = garbage->next;
+            delete_node(garbage);
+            garbage = next;
+        }
+        num_elements -= erased;
+        return erased;
+    }
+
     void clear()
     {
         for (size_type i = 0; i < buckets.size(); ++i) {
@@ -415,71 +484,194 @@ public:
     }
 
 public:
-    iterator find(const key_type& key)
+    node_type extract(const const_iterator& pos)
     {
-        const size_type n = bkt_num_key(key);
-        node* first = buckets[n];
-        while (first != nullptr && !equals(get_key(first->val), key))
-            first = first->next;
-        return iterator(first, this);
+        node* p = const_cast<node*>(pos.cur);
+        if (p != nullptr)
+            unlink_node(p);
+        return node_type(p);
     }
 
-    const_iterator find(const key_type& key) const
+    node_type extract(const key_type& key)
     {
-        const size_type n = bkt_num_key(key);
-        node* first = buckets[n];
-        while (first != nullptr && !equals(get_key(first->val), key))
-            first = first->next;
-        return const_iterator(first, this);
+        node* p = find_node(key);
+        if (p != nullptr)
+            unlink_node(p);
+        return node_type(p);
     }
 
-    size_type count(const key_type& key) const
+    // links the handle's node in unless its key is already present, in which 
+    // case the handle keeps the node
+    Pair<iterator, bool> insert_unique(node_type&& nh)
     {
-        const size_type n = bkt_num_key(key);
-        size_type result = 0;
-        for (const node* cur = buckets[n]; cur != nullptr; cur = cur->next)
-            if (equals(get_key(cur->val), key))
-                ++result;
+        if (nh.empty())
+            return make_pair(end(), false);
+        resize(num_elements + 1);
+        Pair<iterator, bool> result = link_node_unique(nh.ptr);
+        if (result.second)
+            nh.release();
         return result;
     }
 
-    Pair<iterator, iterator> equal_range(const key_type& key)
+    iterator insert_equal(node_type&& nh)
     {
-        const size_type n = bkt_num_key(key);
-        for (node* first = buckets[n]; first != nullptr; first = first->next) {
-            if (equals(get_key(first->val), key)) {
-                for (node* cur = first->next; cur != nullptr; cur = cur->next)
-                    if (!equals(get_key(cur->val), key))
-                        return make_pair(iterator(first, this), 
-                                         iterator(cur, this));
-                for (size_type m = n + 1; m < buckets.size(); ++m)
-                    if (buckets[m] != nullptr)
-                        return make_pair(iterator(first, this), 
-                                         iterator(buckets[m], this));
-                return make_pair(iterator(first, this), end());
+        if (nh.empty())
+            return end();
+        resize(num_elements + 1);
+        return link_node_equal(nh.release());
+    }
+
+    // moves every node of ht whose key is not present here; nodes are relinked, 
+    // not copied
+    void merge_unique(HashTable& ht)
+    {
+        if (&ht == this)
+            return;
+        for (size_type i = 0; i < ht.buckets.size(); ++i) {
+            node** link = &ht.buckets[i];
+            while (*link != nullptr) {
+                node* p = *link;
+                node* next = p->next;
+                resize(num_elements + 1);
+                if (link_node_unique(p).second) {
+                    *link = next;
+                    --ht.num_elements;
+                } else {
+                    link = &p->next;
+                }
             }
         }
-        return make_pair(end(), end());
+    }
+
+    void merge_equal(HashTable& ht)
+    {
+        if (&ht == this)
+            return;
+        resize(num_elements + ht.num_elements);
+        for (size_type i = 0; i < ht.buckets.size(); ++i) {
+            node* p = ht.buckets[i];
+            while (p != nullptr) {
+                node* next = p->next;
+                link_node_equal(p);
+                p = next;
+            }
+            ht.buckets[i] = nullptr;
+        }
+        ht.num_elements = 0;
+    }
+
+public:
+    iterator find(const key_type& key) 
+    { 
+        return iterator(find_node(key), this); 
+    }
+
+    const_iterator find(const key_type& key) const 
+    { 
+        return const_iterator(find_node(key), this); 
+    }
+
+    size_type count(const key_type& key) const { return count_key(key); }
+
+    Pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        Pair<node*, node*> p = equal_range_node(key);
+        return make_pair(iterator(p.first, this), iterator(p.second, this));
     }
 
     Pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     {
-        const size_type n = bkt_num_key(key);
+        Pair<node*, node*> p = equal_range_node(key);
+        return make_pair(const_iterator(p.first, this), const_iterator(p.second, this));
+    }
+
+public:
+    // Result when both functors are transparent, otherwise no type; the 
+    // wrappers constrain their own heterogeneous lookups with it too
+    template <typename K, typename Result>
+    struct transparent_result
+      : _enable_if<_is_transparent<HashFcn>::value && _is_transparent<EqualKey>::value, 
+                   Result> 
+    { 
+    };
+
+    // heterogeneous lookup: only available when both the hasher and the key 
+    // equality are transparent, so that no key_type has to be built
+    template <typename K>
+    typename transparent_result<K, iterator>::type find(const K& key)
+    {
+        return iterator(find_node(key), this);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type find(const K& key) const
+    {
+        return const_iterator(find_node(key), this);
+    }
+
+    template <typename K>
+    typename transparent_result<K, size_type>::type count(const K& key) const
+    {
+        return count_key(key);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<iterator, iterator> >::type 
+    equal_range(const K& key)
+    {
+        Pair<node*, node*> p = equal_range_node(key);
+        return make_pair(iterator(p.first, this), iterator(p.second, this));
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<const_iterator, const_iterator> >::type 
+    equal_range(const K& key) const
+    {
+        Pair<node*, node*> p = equal_range_node(key);
+        return make_pair(const_iterator(p.first, this), const_iterator(p.second, this));
+    }
+
+private:
+    template <typename K>
+    node* find_node(const K& key) const
+    {
+        const size_type code = hash(key);
+        node* first = buckets[code % buckets.size()];
+        while (first != nullptr && !node_equals(first, code, key))
+            first = first->next;
+        return first;
+    }
+
+    template <typename K>
+    size_type count_key(const K& key) const
+    {
+        const size_type code = hash(key);
+        const size_type n = code % buckets.size();
+        size_type result = 0;
+        for (const node* cur = buckets[n]; cur != nullptr; cur = cur->next)
+            if (node_equals(cur, code, key))
+                ++result;
+        return result;
+    }
+
+    template <typename K>
+    Pair<node*, node*> equal_range_node(const K& key) const
+    {
+        const size_type code = hash(key);
+        const size_type n = code % buckets.size();
         for (node* first = buckets[n]; first != nullptr; first = first->next) {
-            if (equals(get_key(first->val), key)) {
+            if (node_equals(first, code, key)) {
                 for (node* cur = first->next; cur != nullptr; cur = cur->next)
-                    if (!equals(get_key(cur->val), key))
-                        return make_pair(const_iterator(first, this), 
-                                         const_iterator(cur, this));
+                    if (!node_equals(cur, code, key))
+                        return make_pair(first, cur);
                 for (size_type m = n + 1; m < buckets.size(); ++m)
                     if (buckets[m] != nullptr)
-                        return make_pair(const_iterator(first, this), 
-                                         const_iterator(buckets[m], this));
-                return make_pair(const_iterator(first, this), end());
+                        return make_pair(first, buckets[m]);
+                return make_pair(first, static_cast<node*>(nullptr));
             }
         }
-        return make_pair(end(), end());
-    }    
+        return make_pair(static_cast<node*>(nullptr), static_cast<node*>(nullptr));
+    }
 
 private:
     node* new_node(const value_type& obj)
@@ -496,6 +688,57 @@ private:
         node_allocator::deallocate(n);
     }
 
+    node* clone_node(const node* n)
+    {
+        node* tmp = new_node(n->val);
+        copy_hash_code(tmp, n, cache_hash());
+        return tmp;
+    }
+
+    void unlink_node(node* p)
+    {
+        node** link = &buckets[bkt_num_node(p)];
+        while (*link != p)
+            link = &(*link)->next;
+        *link = p->next;
+        p->next = nullptr;
+        --num_elements;
+    }
+
+    // the hash code is recomputed since p may come from a table with another 
+    // hasher instance
+    Pair<iterator, bool> link_node_unique(node* p)
+    {
+        const size_type code = hash(get_key(p->val));
+        const size_type n = code % buckets.size();
+        for (node* cur = buckets[n]; cur != nullptr; cur = cur->next)
+            if (node_equals(cur, code, get_key(p->val)))
+                return make_pair(iterator(cur, this), false);
+        set_hash_code(p, code, cache_hash());
+        p->next = buckets[n];
+        buckets[n] = p;
+        ++num_elements;
+        return make_pair(iterator(p, this), true);
+    }
+
+    iterator link_node_equal(node* p)
+    {
+        const size_type code = hash(get_key(p->val));
+        const size_type n = code % buckets.size();
+        set_hash_code(p, code, cache_hash());
+        node** link = &buckets[n];
+        for (node* cur = buckets[n]; cur != nullptr; cur = cur->next) {
+            if (node_equals(cur, code, get_key(p->val))) {
+                link = &cur->next;
+                break;
+            }
+        }
+        p->next = *link;
+        *link = p;
+        ++num_elements;
+        return iterator(p, this);
+    }
+
 private:
     void initialize_buckets(size_type n)
     {
@@ -513,10 +756,10 @@ private:
         for (size_type i = 0; i < ht.buckets.size(); ++i) {
             const node* cur = ht.buckets[i];
             if (cur != nullptr) {
-                node* copy = new_node(cur->val);
+                node* copy = clone_node(cur);
                 buckets[i] = copy;
                 for (cur = cur->next; cur != nullptr; cur = cur->next) {
-                    copy->next = new_node(cur->val);
+                    copy->next = clone_node(cur);
                     copy = copy->next;
                 }
             }
@@ -578,6 +821,39 @@ private:
         return hash(key) % n;
     }
 
+    size_type bkt_num_node(const node* p) const
+    {
+        return node_hash(p, cache_hash()) % buckets.size();
+    }
+
+private:
+    size_type node_hash(const node* p, _true_type) const { return p->hash_code; }
+    size_type node_hash(const node* p, _false_type) const { return hash(get_key(p->val)); }
+
+    template <typename K>
+    bool node_equals(const node* p, size_type code, const K& key) const
+    {
+        return node_equals(p, code, key, cache_hash());
+    }
+
+    template <typename K>
+    bool node_equals(const node* p, size_type code, const K& key, _true_type) const
+    {
+        return p->hash_code == code && equals(get_key(p->val), key);
+    }
+
+    template <typename K>
+    bool node_equals(const node* p, size_type, const K& key, _false_type) const
+    {
+        return equals(get_key(p->val), key);
+    }
+
+    void set_hash_code(node* p, size_type code, _true_type) { p->hash_code = code; }
+    void set_hash_code(node*, size_type, _false_type) { }
+
+    void copy_hash_code(node* p, const node* src, _true_type) { p->hash_code = src->hash_code; }
+    void copy_hash_code(node*, const node*, _false_type) { }
+
 private:
     hasher hash;
     key_equal equals;
@@ -632,7 +908,7 @@ void HashTable<Val, Key, HF, Ex, Eq, Alloc>::resize(size_type num_elements_hint)
             for (size_type bucket = 0; bucket < old_n; ++bucket) {
                 node* first = buckets[bucket];
                 while (first != nullptr) {
-                    size_type new_bucket = bkt_num(first->val, n);
+                    size_type new_bucket = node_hash(first, cache_hash()) % n;
                     buckets[bucket] = first->next;
                     first->next = tmp[new_bucket];
                     tmp[new_bucket] = first;
@@ -649,12 +925,14 @@ typename HashTable<Val, Key, HF, Ex, Eq, Alloc>::reference
 HashTable<Val, Key, HF, Ex, Eq, Alloc>::find_or_insert(const value_type& obj)
 {
     resize(num_elements + 1);
-    const size_type n = bkt_num(obj);
+    const size_type code = hash(get_key(obj));
+    const size_type n = code % buckets.size();
     node* first = buckets[n];
     for (node* cur = first; cur != nullptr; cur = cur->next)
-        if (equals(get_key(cur->val), get_key(obj)))
+        if (node_equals(cur, code, get_key(obj)))
             return cur->val;
     node* tmp = new_node(obj);
+    set_hash_code(tmp, code, cache_hash());
     tmp->next = first;
     buckets[n] = tmp;
     ++num_elements;
@@ -665,12 +943,14 @@ template <typename Val, typename Key, typename HF, typename Ex, typename Eq, typ
 Pair<typename HashTable<Val, Key, HF, Ex, Eq, Alloc>::iterator, bool> 
 HashTable<Val, Key, HF, Ex, Eq, Alloc>::insert_unique_noresize(const value_type& obj)
 {
-    const size_type n = bkt_num(obj);
+    const size_type code = hash(get_key(obj));
+    const size_type n = code % buckets.size();
     node* first = buckets[n];
     for (node* cur = first; cur != nullptr; cur = cur->next)
-        if (equals(get_key(cur->val), get_key(obj)))
+        if (node_equals(cur, code, get_key(obj)))
             return make_pair(iterator(cur, this), false);
     node* tmp = new_node(obj);
+    set_hash_code(tmp, code, cache_hash());
     tmp->next = first;
     buckets[n] = tmp;
     ++num_elements;
@@ -681,11 +961,13 @@ template <typename Val, typename Key, typename HF, typename Ex, typename Eq, typ
 typename HashTable<Val, Key, HF, Ex, Eq, Alloc>::iterator 
 HashTable<Val, Key, HF, Ex, Eq, Alloc>::insert_equal_noresize(const value_type& obj)
 {
-    const size_type n = bkt_num(obj);
+    const size_type code = hash(get_key(obj));
+    const size_type n = code % buckets.size();
     node* first = buckets[n];
     for (node* cur = first; cur != nullptr; cur = cur->next) {
-        if (equals(get_key(cur->val), get_key(obj))) {
+        if (node_equals(cur, code, get_key(obj))) {
             node* tmp = new_node(obj);
+            set_hash_code(tmp, code, cache_hash());
             tmp->next = cur->next;
             cur->next = tmp;
             ++num_elements;
@@ -693,6 +975,7 @@ HashTable<Val, Key, HF, Ex, Eq, Alloc>::insert_equal_noresize(const value_type&
         }
     }
     node* tmp = new_node(obj);
+    set_hash_code(tmp, code, cache_hash());
     tmp->next = first;
     buckets[n] = tmp;
     ++num_elements;
@@ -0,0 +1,199 @@
+#ifndef ZYX_INTERVAL_MAP
+#define ZYX_INTERVAL_MAP
+
+#include "RedBlackTree.h"
+#include "Functional.h"
+
+namespace Zyx {
+
+// orders intervals by low endpoint, then by high endpoint
+template <typename Interval, typename Compare>
+struct __interval_less
+{
+    Compare comp;
+
+    __interval_less() : comp(Compare()) { }
+    explicit __interval_less(const Compare& c) : comp(c) { }
+
+    bool operator()(const Interval& x, const Interval& y) const
+    {
+        return comp(x.first, y.first) || (!comp(y.first, x.first) && comp(x.second, y.second));
+    }
+};
+
+//------------------------------------【IntervalMap class】-----------------------------------
+
+// Maps closed intervals [lo, hi] to values. Several entries may share or
+// overlap an interval. Each node also tracks the greatest high endpoint in
+// its subtree, so find_overlapping takes O(log n), and a query reporting k
+// entries takes O(log n + k log(n / k)) instead of a scan: every entry may
+// cost part of a root path. Compare orders endpoints and must be default
+// constructible.
+template <typename Key, typename Value, typename Compare = less<Key>,
+          typename Alloc = alloc>
+class IntervalMap
+{
+public:
+    typedef Key                                  endpoint_type;
+    typedef Pair<Key, Key>                       key_type;
+    typedef Value                                data_type;
+    typedef Value                                mapped_type;
+    typedef Pair<const key_type, mapped_type>    value_type;
+    typedef __interval_less<key_type, Compare>   key_compare;
+
+private:
+    typedef RedBlackTree<key_type, value_type, select1st<value_type>, key_compare, Alloc,
+                         __rb_tree_interval_node<value_type, Compare> >
+            rep_type;
+
+public:
+    typedef typename rep_type::pointer            pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::reference          reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::iterator           iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    IntervalMap() : t(key_compare()) { }
+
+    template <typename InputIterator>
+    IntervalMap(InputIterator first, InputIterator last) : t(key_compare())
+    {
+        t.insert_equal(first, last);
+    }
+
+    IntervalMap(const IntervalMap& x) : t(x.t) { }
+
+    IntervalMap& operator=(const IntervalMap& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    iterator insert(const value_type& val) { return t.insert_equal(val); }
+
+    iterator insert(const endpoint_type& lo, const endpoint_type& hi, const mapped_type& obj)
+    {
+        return t.insert_equal(value_type(key_type(lo, hi), obj));
+    }
+
+    iterator insert(const_iterator hint, const value_type& val)
+    {
+        return t.insert_equal(hint, val);
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_equal(first, last);
+    }
+
+    void erase(iterator pos) { t.erase(pos); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    void clear() { t.clear(); }
+    void swap(IntervalMap& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) { return t.find(k); }
+    const_iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k) { return t.equal_range(k); }
+
+    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+public:
+    // writes an iterator to each entry meeting [lo, hi], ordered by interval
+    template <typename OutputIterator>
+    OutputIterator overlapping(const endpoint_type& lo, const endpoint_type& hi,
+                               OutputIterator result)
+    {
+        return t.overlapping(lo, hi, result);
+    }
+
+    template <typename OutputIterator>
+    OutputIterator overlapping(const endpoint_type& lo, const endpoint_type& hi,
+                               OutputIterator result) const
+    {
+        return t.overlapping(lo, hi, result);
+    }
+
+    // entries whose interval contains point
+    template <typename OutputIterator>
+    OutputIterator stabbing(const endpoint_type& point, OutputIterator result)
+    {
+        return t.overlapping(point, point, result);
+    }
+
+    template <typename OutputIterator>
+    OutputIterator stabbing(const endpoint_type& point, OutputIterator result) const
+    {
+        return t.overlapping(point, point, result);
+    }
+
+    // the first entry meeting [lo, hi], or end()
+    iterator find_overlapping(const endpoint_type& lo, const endpoint_type& hi)
+    {
+        return t.find_overlapping(lo, hi);
+    }
+
+    const_iterator find_overlapping(const endpoint_type& lo, const endpoint_type& hi) const
+    {
+        return t.find_overlapping(lo, hi);
+    }
+
+    bool overlaps(const endpoint_type& lo, const endpoint_type& hi) const
+    {
+        return find_overlapping(lo, hi) != end();
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator==(const IntervalMap<Key, Value, Compare, Alloc>& lhs,
+                       const IntervalMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator!=(const IntervalMap<Key, Value, Compare, Alloc>& lhs,
+                       const IntervalMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline void swap(IntervalMap<Key, Value, Compare, Alloc>& lhs,
+                 IntervalMap<Key, Value, Compare, Alloc>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
@@ -236,6 +236,33 @@ public:
         return last;
     }
 
+    // calls f on each element in order. The node after next is prefetched 
+    // while f runs; a list is pointer chasing, so this hides the latency 
+    // of one node per step and no more.
+    template <typename Function>
+    Function for_each(Function f)
+    {
+        for (list_node* cur = node->next; cur != node; ) {
+            list_node* next = cur->next;
+            __prefetch(next->next);
+            f(cur->data);
+            cur = next;
+        }
+        return f;
+    }
+
+    template <typename Function>
+    Function for_each(Function f) const
+    {
+        for (const list_node* cur = node->next; cur != node; ) {
+            const list_node* next = cur->next;
+            __prefetch(next->next);
+            f(cur->data);
+            cur = next;
+        }
+        return f;
+    }
+
     void resize(size_type n) { resize(n, T()); }
 
     void resize(size_type n, const T& val)
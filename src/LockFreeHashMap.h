@@ -0,0 +1,86 @@
+#ifndef ZYX_LOCK_FREE_HASH_MAP
+#define ZYX_LOCK_FREE_HASH_MAP
+
+#include "LockFreeHashTable.h"
+#include "HashFun.h"
+#include "Functional.h"
+#include "Alloc.h"
+#include "Utility.h"
+
+namespace Zyx {
+
+//--------------------------------【LockFreeHashMap class】-----------------------------------
+
+// Lookups take no locks; erased elements are reclaimed through EpochDomain.
+// Stored values are immutable: replace a value by erasing and reinserting it.
+// Nodes are freed by whichever thread reclaims them, so Alloc defaults to
+// malloc_alloc rather than to default_alloc's per-thread free lists.
+template <typename Key, typename T, typename HashFcn = hash<Key>,
+          typename EqualKey = equal_to<Key>, typename Alloc = malloc_alloc>
+class LockFreeHashMap : NonCopyable
+{
+public:
+    typedef Key                   key_type;
+    typedef T                     data_type;
+    typedef T                     mapped_type;
+    typedef Pair<const Key, T>    value_type;
+    typedef HashFcn               hasher;
+    typedef EqualKey              key_equal;
+
+private:
+    typedef LockFreeHashTable<value_type, key_type, hasher, select1st<value_type>, 
+                              key_equal, Alloc> 
+            ht;
+
+    struct copy_mapped
+    {
+        mapped_type* result;
+        explicit copy_mapped(mapped_type* r) : result(r) { }
+        void operator()(const value_type& val) const { *result = val.second; }
+    };
+
+public:
+    typedef typename ht::const_reference    const_reference;
+    typedef typename ht::size_type          size_type;
+
+public:
+    LockFreeHashMap() : rep(100, hasher(), key_equal()) { }
+    explicit LockFreeHashMap(size_type n) : rep(n, hasher(), key_equal()) { }
+    LockFreeHashMap(size_type n, const hasher& hf) : rep(n, hf, key_equal()) { }
+    LockFreeHashMap(size_type n, const hasher& hf, const key_equal& eql) : rep(n, hf, eql) { }
+
+public:
+    hasher hash_function() const { return rep.hash_function(); }
+    key_equal key_eq() const { return rep.key_eq(); }
+    size_type size() const { return rep.size(); }
+    bool empty() const { return rep.empty(); }
+    size_type bucket_count() const { return rep.bucket_count(); }
+
+public:
+    bool insert(const value_type& obj) { return rep.insert_unique(obj); }
+    size_type erase(const key_type& key) { return rep.erase(key); }
+
+    bool find(const key_type& key, mapped_type& result) const
+    {
+        return rep.find_and_apply(key, copy_mapped(&result));
+    }
+
+    template <typename Function>
+    bool find_and_apply(const key_type& key, Function f) const 
+    { 
+        return rep.find_and_apply(key, f); 
+    }
+
+    bool contains(const key_type& key) const { return rep.contains(key); }
+    size_type count(const key_type& key) const { return rep.count(key); }
+
+    template <typename Function>
+    void for_each(Function f) const { rep.for_each(f); }
+
+private:
+    ht rep;
+};
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef ZYX_LOCK_FREE_HASH_SET
+#define ZYX_LOCK_FREE_HASH_SET
+
+#include "LockFreeHashTable.h"
+#include "HashFun.h"
+#include "Functional.h"
+#include "Alloc.h"
+
+namespace Zyx {
+
+//--------------------------------【LockFreeHashSet class】-----------------------------------
+
+// Lookups take no locks; erased elements are reclaimed through EpochDomain.
+// Alloc defaults to malloc_alloc, as in LockFreeHashMap.
+template <typename Value, typename HashFcn = hash<Value>,
+          typename EqualKey = equal_to<Value>, typename Alloc = malloc_alloc>
+class LockFreeHashSet : NonCopyable
+{
+private:
+    typedef LockFreeHashTable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc> ht;
+
+public:
+    typedef typename ht::key_type           key_type;
+    typedef typename ht::value_type         value_type;
+    typedef typename ht::hasher             hasher;
+    typedef typename ht::key_equal          key_equal;
+    typedef typename ht::const_reference    const_reference;
+    typedef typename ht::size_type          size_type;
+
+public:
+    LockFreeHashSet() : rep(100, hasher(), key_equal()) { }
+    explicit LockFreeHashSet(size_type n) : rep(n, hasher(), key_equal()) { }
+    LockFreeHashSet(size_type n, const hasher& hf) : rep(n, hf, key_equal()) { }
+    LockFreeHashSet(size_type n, const hasher& hf, const key_equal& eql) : rep(n, hf, eql) { }
+
+public:
+    hasher hash_function() const { return rep.hash_function(); }
+    key_equal key_eq() const { return rep.key_eq(); }
+    size_type size() const { return rep.size(); }
+    bool empty() const { return rep.empty(); }
+    size_type bucket_count() const { return rep.bucket_count(); }
+
+public:
+    bool insert(const value_type& obj) { return rep.insert_unique(obj); }
+    size_type erase(const key_type& key) { return rep.erase(key); }
+
+    template <typename Function>
+    bool find_and_apply(const key_type& key, Function f) const
+    {
+        return rep.find_and_apply(key, f);
+    }
+
+    bool contains(const key_type& key) const { return rep.contains(key); }
+    size_type count(const key_type& key) const { return rep.count(key); }
+
+    template <typename Function>
+    void for_each(Function f) const { rep.for_each(f); }
+
+private:
+    ht rep;
+};
+
+}
+
+#endif
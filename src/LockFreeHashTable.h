@@ -0,0 +1,419 @@
+#ifndef ZYX_LOCK_FREE_HASH_TABLE
+#define ZYX_LOCK_FREE_HASH_TABLE
+
+#include <atomic>
+#include <climits>
+#include <new>
+#include "Alloc.h"
+#include "Construct.h"
+#include "Utility.h"
+#include "NonCopyable.h"
+#include "Epoch.h"
+
+namespace Zyx {
+
+// Split-ordered list (Shalev & Shavit): every element lives in one lock-free
+// sorted list ordered by the bit-reversed hash. Buckets are shortcuts into the
+// list, marked by dummy nodes, so doubling the bucket count never moves a node.
+// Regular nodes have the lowest bit of so_key set, dummy nodes have it clear.
+struct __split_list_node_base
+{
+    typedef __split_list_node_base* base_ptr;
+
+    std::atomic<base_ptr> next;     // lowest bit set: this node is being erased
+    size_t so_key;
+};
+
+template <typename Value>
+struct __split_list_node : public __split_list_node_base
+{
+    Value val;
+};
+
+template <typename Value, typename Key, typename HashFcn, typename ExtractKey,
+          typename EqualKey, typename Alloc = malloc_alloc>
+class LockFreeHashTable : NonCopyable
+{
+public:
+    typedef Key                  key_type;
+    typedef Value                value_type;
+    typedef HashFcn              hasher;
+    typedef EqualKey             key_equal;
+    typedef const value_type&    const_reference;
+    typedef size_t               size_type;
+
+private:
+    typedef __split_list_node_base            base_node;
+    typedef __split_list_node_base*           base_ptr;
+    typedef __split_list_node<Value>          node;
+    typedef std::atomic<base_ptr>             bucket_type;
+    typedef simple_alloc<node, Alloc>         node_allocator;
+    typedef simple_alloc<base_node, Alloc>    dummy_allocator;
+    typedef simple_alloc<bucket_type, Alloc>  segment_allocator;
+
+    // bucket b lives in segment highest_bit(b) (0 and 1 share segment 0), so
+    // segment s holds 2^s buckets and the table grows without copying
+    enum { __MAX_SEGMENTS = sizeof(size_t) * CHAR_BIT };
+    enum { __MAX_LOAD = 2 };
+
+public:
+    LockFreeHashTable(size_type n, const hasher& hf, const key_equal& eql)
+      : hash(hf), equals(eql), get_key(ExtractKey()), num_elements(0)
+    {
+        initialize_buckets(n);
+    }
+
+    LockFreeHashTable(size_type n, const hasher& hf, const key_equal& eql,
+                      const ExtractKey& ext)
+      : hash(hf), equals(eql), get_key(ext), num_elements(0)
+    {
+        initialize_buckets(n);
+    }
+
+    // must not run concurrently with any other member function
+    ~LockFreeHashTable()
+    {
+        base_ptr cur = head;
+        while (cur != nullptr) {
+            base_ptr next = unmarked(cur->next.load());
+            if (is_dummy(cur))
+                delete_dummy(cur);
+            else
+                delete_node(static_cast<node*>(cur));
+            cur = next;
+        }
+        for (size_type s = 0; s < __MAX_SEGMENTS; ++s) {
+            bucket_type* seg = segments[s].load();
+            if (seg != nullptr)
+                segment_allocator::deallocate(seg, segment_size(s));
+        }
+    }
+
+public:
+    hasher hash_function() const { return hash; }
+    key_equal key_eq() const { return equals; }
+    size_type size() const { return num_elements.load(); }
+    bool empty() const { return size() == 0; }
+    size_type bucket_count() const { return num_buckets.load(); }
+
+public:
+    // returns false (and inserts nothing) if an equal key is already present
+    bool insert_unique(const value_type& obj)
+    {
+        const key_type& key = get_key(obj);
+        const size_type code = hash(key);
+        const size_type so_key = regular_key(code);
+
+        // the node is built only once the key is known to be absent; if an
+        // equal key is linked in meanwhile it was never published, so it is
+        // freed directly instead of being retired
+        EpochGuard guard;
+        base_ptr bucket = get_bucket(code & (num_buckets.load() - 1));
+        node* n = nullptr;
+        bucket_type* prev;
+        base_ptr cur;
+        while (true) {
+            if (list_find(bucket, so_key, &key, prev, cur)) {
+                if (n != nullptr)
+                    delete_node(n);
+                return false;
+            }
+            if (n == nullptr) {
+                n = new_node(obj);
+                n->so_key = so_key;
+            }
+            n->next.store(cur);
+            base_ptr expected = cur;
+            if (prev->compare_exchange_strong(expected, n))
+                break;
+        }
+
+        size_type count = ++num_elements;
+        size_type n_buckets = num_buckets.load();
+        if (count / n_buckets > __MAX_LOAD && n_buckets < max_bucket_count())
+            num_buckets.compare_exchange_strong(n_buckets, n_buckets * 2);
+        return true;
+    }
+
+    size_type erase(const key_type& key)
+    {
+        const size_type code = hash(key);
+        const size_type so_key = regular_key(code);
+
+        EpochGuard guard;
+        base_ptr bucket = get_bucket(code & (num_buckets.load() - 1));
+        bucket_type* prev;
+        base_ptr cur;
+        while (true) {
+            if (!list_find(bucket, so_key, &key, prev, cur))
+                return 0;
+            base_ptr next = cur->next.load();
+            if (is_marked(next) || !cur->next.compare_exchange_strong(next, marked(next)))
+                continue;
+            base_ptr expected = cur;
+            if (prev->compare_exchange_strong(expected, next))
+                retire(cur);
+            else
+                list_find(bucket, so_key, &key, prev, cur);
+            --num_elements;
+            return 1;
+        }
+    }
+
+public:
+    bool contains(const key_type& key) const
+    {
+        EpochGuard guard;
+        return find_node(key) != nullptr;
+    }
+
+    size_type count(const key_type& key) const { return contains(key) ? 1 : 0; }
+
+    // calls f(const value_type&) on the element with the given key while the
+    // element is protected from reclamation; returns false if there is none
+    template <typename Function>
+    bool find_and_apply(const key_type& key, Function f) const
+    {
+        EpochGuard guard;
+        node* p = find_node(key);
+        if (p == nullptr)
+            return false;
+        f(const_cast<const value_type&>(p->val));
+        return true;
+    }
+
+    // calls f(const value_type&) on every element; elements inserted or erased
+    // concurrently may or may not be visited
+    template <typename Function>
+    void for_each(Function f) const
+    {
+        EpochGuard guard;
+        base_ptr cur = unmarked(head->next.load());
+        while (cur != nullptr) {
+            base_ptr next = cur->next.load();
+            if (!is_dummy(cur) && !is_marked(next))
+                f(const_cast<const value_type&>(static_cast<node*>(cur)->val));
+            cur = unmarked(next);
+        }
+    }
+
+    size_type max_bucket_count() const
+    {
+        return static_cast<size_type>(1) << (__MAX_SEGMENTS - 1);
+    }
+
+private:
+    void initialize_buckets(size_type n)
+    {
+        for (size_type s = 0; s < __MAX_SEGMENTS; ++s)
+            segments[s].store(nullptr);
+
+        size_type n_buckets = 2;
+        while (n_buckets < n / __MAX_LOAD && n_buckets < max_bucket_count())
+            n_buckets *= 2;
+        num_buckets.store(n_buckets);
+
+        head = new_dummy(0);
+        bucket_slot(0).store(head);
+    }
+
+    node* find_node(const key_type& key) const
+    {
+        const size_type code = hash(key);
+        base_ptr bucket = get_bucket(code & (num_buckets.load() - 1));
+        bucket_type* prev;
+        base_ptr cur;
+        if (!list_find(bucket, regular_key(code), &key, prev, cur))
+            return nullptr;
+        return static_cast<node*>(cur);
+    }
+
+private:
+    // Michael's lock-free list search. Leaves cur at the first node not ordered
+    // before (so_key, key) and prev at the link pointing to it; marked nodes met
+    // on the way are unlinked and retired. key is nullptr for dummy nodes.
+    bool list_find(base_ptr start, size_type so_key, const key_type* key,
+                   bucket_type*& prev, base_ptr& cur) const
+    {
+    retry:
+        prev = &start->next;
+        cur = prev->load();
+        while (cur != nullptr) {
+            base_ptr next = cur->next.load();
+            if (is_marked(next)) {
+                base_ptr expected = cur;
+                if (!prev->compare_exchange_strong(expected, unmarked(next)))
+                    goto retry;
+                retire(cur);
+                cur = unmarked(next);
+                continue;
+            }
+            if (prev->load() != cur)
+                goto retry;
+            if (cur->so_key > so_key)
+                return false;
+            if (cur->so_key == so_key &&
+                (key == nullptr || equals(get_key(static_cast<node*>(cur)->val), *key)))
+                return true;
+            prev = &cur->next;
+            cur = next;
+        }
+        return false;
+    }
+
+    // links n into the list after start, unless an equal node is already there;
+    // found is set to the node that ends up in the list
+    bool list_insert(base_ptr start, base_ptr n, const key_type* key, base_ptr& found) const
+    {
+        bucket_type* prev;
+        base_ptr cur;
+        while (true) {
+            if (list_find(start, n->so_key, key, prev, cur)) {
+                found = cur;
+                return false;
+            }
+            n->next.store(cur);
+            base_ptr expected = cur;
+            if (prev->compare_exchange_strong(expected, n)) {
+                found = n;
+                return true;
+            }
+        }
+    }
+
+    base_ptr get_bucket(size_type b) const
+    {
+        bucket_type& slot = bucket_slot(b);
+        base_ptr dummy = slot.load();
+        return dummy != nullptr ? dummy : initialize_bucket(b, slot);
+    }
+
+    // a new bucket is split off its parent: b with the highest bit cleared
+    base_ptr initialize_bucket(size_type b, bucket_type& slot) const
+    {
+        const size_type parent = b & ~(static_cast<size_type>(1) << highest_bit(b));
+        base_ptr start = get_bucket(parent);
+        base_ptr dummy = new_dummy(dummy_key(b));
+        base_ptr found;
+        if (!list_insert(start, dummy, nullptr, found))
+            delete_dummy(dummy);
+        slot.store(found);
+        return found;
+    }
+
+    bucket_type& bucket_slot(size_type b) const
+    {
+        const size_type s = b < 2 ? 0 : highest_bit(b);
+        bucket_type* seg = segments[s].load();
+        if (seg == nullptr) {
+            bucket_type* fresh = segment_allocator::allocate(segment_size(s));
+            for (size_type i = 0; i < segment_size(s); ++i)
+                new (fresh + i) bucket_type(nullptr);
+            if (segments[s].compare_exchange_strong(seg, fresh))
+                seg = fresh;
+            else
+                segment_allocator::deallocate(fresh, segment_size(s));
+        }
+        return seg[s == 0 ? b : b - (static_cast<size_type>(1) << s)];
+    }
+
+    static size_type segment_size(size_type s)
+    {
+        return s == 0 ? 2 : static_cast<size_type>(1) << s;
+    }
+
+private:
+    node* new_node(const value_type& obj)
+    {
+        node* n = node_allocator::allocate();
+        new (static_cast<base_node*>(n)) base_node;
+        n->next.store(nullptr);
+        construct(&n->val, obj);
+        return n;
+    }
+
+    static void delete_node(node* n)
+    {
+        destroy(&n->val);
+        node_allocator::deallocate(n);
+    }
+
+    static void delete_node(void* p) { delete_node(static_cast<node*>(p)); }
+
+    static base_ptr new_dummy(size_type so_key)
+    {
+        base_ptr n = dummy_allocator::allocate();
+        new (n) base_node;
+        n->next.store(nullptr);
+        n->so_key = so_key;
+        return n;
+    }
+
+    static void delete_dummy(base_ptr n) { dummy_allocator::deallocate(n); }
+
+    // only regular nodes are ever erased
+    static void retire(base_ptr p)
+    {
+        void (*deleter)(void*) = &LockFreeHashTable::delete_node;
+        EpochDomain::instance().retire(static_cast<node*>(p), deleter);
+    }
+
+private:
+    static bool is_dummy(base_ptr p) { return (p->so_key & 1) == 0; }
+
+    static bool is_marked(base_ptr p)
+    {
+        return (reinterpret_cast<size_t>(p) & 1) != 0;
+    }
+
+    static base_ptr marked(base_ptr p)
+    {
+        return reinterpret_cast<base_ptr>(reinterpret_cast<size_t>(p) | 1);
+    }
+
+    static base_ptr unmarked(base_ptr p)
+    {
+        return reinterpret_cast<base_ptr>(reinterpret_cast<size_t>(p) & ~size_t(1));
+    }
+
+    static size_type regular_key(size_type code) { return reverse_bits(code) | 1; }
+    static size_type dummy_key(size_type b) { return reverse_bits(b) & ~size_type(1); }
+
+    static size_type reverse_bits(size_type x)
+    {
+        size_type s = sizeof(size_type) * CHAR_BIT;
+        size_type mask = ~static_cast<size_type>(0);
+        while ((s >>= 1) > 0) {
+            mask ^= mask << s;
+            x = ((x >> s) & mask) | ((x << s) & ~mask);
+        }
+        return x;
+    }
+
+    // long is 32 bits on LLP64, so count zeros in a long long
+    static size_type highest_bit(size_type x)
+    {
+#if defined(__GNUC__)
+        return sizeof(unsigned long long) * CHAR_BIT - 1
+               - __builtin_clzll(static_cast<unsigned long long>(x));
+#else
+        size_type r = 0;
+        while (x >>= 1)
+            ++r;
+        return r;
+#endif
+    }
+
+private:
+    hasher hash;
+    key_equal equals;
+    ExtractKey get_key;
+    base_ptr head;
+    mutable std::atomic<bucket_type*> segments[__MAX_SEGMENTS];
+    std::atomic<size_type> num_buckets;
+    std::atomic<size_type> num_elements;
+};
+
+}
+
+#endif
@@ -23,6 +23,24 @@ private:
     Mutex& m;
 };
 
+template <typename Mutex>
+class SharedLockGuard : NonCopyable
+{
+public:
+    explicit SharedLockGuard(Mutex& m_) : m(m_) 
+    { 
+        m.lock_shared(); 
+    }
+
+    ~SharedLockGuard()
+    {
+        m.unlock_shared();
+    }
+
+private:
+    Mutex& m;
+};
+
 }
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef ZYX_MAP
 #define ZYX_MAP 
 
+#include <utility>
 #include "RedBlackTree.h"
 #include "Functional.h"
 
@@ -52,6 +53,7 @@ public:
     typedef typename rep_type::const_iterator     const_iterator;
     typedef typename rep_type::size_type          size_type;
     typedef typename rep_type::difference_type    difference_type;
+    typedef typename rep_type::node_type          node_type;
 
 public:
     Map() : t(Compare()) { }
@@ -100,16 +102,87 @@ public:
         t.insert_unique(first, last);
     }
 
+    iterator insert(const_iterator hint, const value_type& val)
+    {
+        return t.insert_unique(hint, val);
+    }
+
+    // the mapped value is only constructed when k is not present yet
+    Pair<iterator, bool> try_emplace(const key_type& k) 
+    { 
+        return t.try_emplace_unique(end(), k); 
+    }
+
+    template <typename M>
+    Pair<iterator, bool> try_emplace(const key_type& k, M&& obj)
+    {
+        return t.try_emplace_unique(end(), k, std::forward<M>(obj));
+    }
+
+    iterator try_emplace(const_iterator hint, const key_type& k)
+    {
+        return t.try_emplace_unique(hint, k).first;
+    }
+
+    template <typename M>
+    iterator try_emplace(const_iterator hint, const key_type& k, M&& obj)
+    {
+        return t.try_emplace_unique(hint, k, std::forward<M>(obj)).first;
+    }
+
+    template <typename M>
+    Pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+    {
+        // obj is only consumed by one of the two branches
+        Pair<iterator, bool> p = t.try_emplace_unique(end(), k, std::forward<M>(obj));
+        if (!p.second)
+            p.first->second = std::forward<M>(obj);
+        return p;
+    }
+
+    template <typename M>
+    iterator insert_or_assign(const_iterator hint, const key_type& k, M&& obj)
+    {
+        Pair<iterator, bool> p = t.try_emplace_unique(hint, k, std::forward<M>(obj));
+        if (!p.second)
+            p.first->second = std::forward<M>(obj);
+        return p.first;
+    }
+
     mapped_type& operator[](const key_type& k)
     {
-        return insert(value_type(k, Value())).first->second;
-        // return (*((insert(value_type(k, Value()))).first)).second;
+        return try_emplace(k).first->second;
     }
 
+    Pair<iterator, bool> insert(node_type&& nh) { return t.insert_unique(std::move(nh)); }
+
+    node_type extract(const_iterator pos) { return t.extract(pos); }
+    node_type extract(const key_type& k) { return t.extract(k); }
+    void merge(Map& x) { t.merge_unique(x.t); }
+
     void erase(iterator pos) { t.erase(pos); }
     void erase(iterator first, iterator last) { t.erase(first, last); }
     size_type erase(const key_type& k) { return t.erase(k); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    // full scans with prefetching; f may change mapped values
+    template <typename Function>
+    Function for_each(Function f) { return t.for_each(f); }
+
+    template <typename Function>
+    Function for_each(Function f) const { return t.for_each(f); }
+
+    // set algebra on keys in O(m log(n / m + 1)); the rvalue forms take over 
+    // x's nodes and leave it empty, and equal keys keep the element of *this
+    void union_with(Map&& x, bool parallel = false) { t.union_with(std::move(x.t), parallel); }
+    void union_with(const Map& x, bool parallel = false) { t.union_with(x.t, parallel); }
+    void intersect_with(Map&& x, bool parallel = false) { t.intersect_with(std::move(x.t), parallel); }
+    void intersect_with(const Map& x, bool parallel = false) { t.intersect_with(x.t, parallel); }
+    void difference_with(Map&& x, bool parallel = false) { t.difference_with(std::move(x.t), parallel); }
+    void difference_with(const Map& x, bool parallel = false) { t.difference_with(x.t, parallel); }
+
     void clear() { t.clear(); }
     void swap(Map& x) { t.swap(x.t); }
 
@@ -120,7 +193,7 @@ public:
     iterator lower_bound(const key_type& k) { return t.lower_bound(k); }
     const_iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
     iterator upper_bound(const key_type& k) { return t.upper_bound(k); }
-    const_iterator upper_bound(const key_type& k) const { return t.lower_bound(k); }
+    const_iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
 
     Pair<iterator, iterator> equal_range(const key_type& k) 
     { 
@@ -132,6 +205,68 @@ public:
     	return t.equal_range(k); 
     }
 
+private:
+    template <typename K, typename Result>
+    struct transparent_result : rep_type::template transparent_result<K, Result> { };
+
+public:
+    // lookups with any key type accepted by a transparent Compare
+    template <typename K>
+    typename transparent_result<K, iterator>::type find(const K& k)
+    {
+        return t.find(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type find(const K& k) const
+    {
+        return t.find(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, size_type>::type count(const K& k) const
+    {
+        return t.count(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, iterator>::type lower_bound(const K& k)
+    {
+        return t.lower_bound(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type lower_bound(const K& k) const
+    {
+        return t.lower_bound(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, iterator>::type upper_bound(const K& k)
+    {
+        return t.upper_bound(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type upper_bound(const K& k) const
+    {
+        return t.upper_bound(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<iterator, iterator> >::type 
+    equal_range(const K& k)
+    {
+        return t.equal_range(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<const_iterator, const_iterator> >::type 
+    equal_range(const K& k) const
+    { 
+        return t.equal_range(k); 
+    }
+
 private:
     rep_type t;
 };
@@ -1,6 +1,7 @@
 #ifndef ZYX_MULTI_MAP
 #define ZYX_MULTI_MAP 
 
+#include <utility>
 #include "RedBlackTree.h"
 #include "Functional.h"
 
@@ -52,6 +53,7 @@ public:
     typedef typename rep_type::const_iterator     const_iterator;
     typedef typename rep_type::size_type          size_type;
     typedef typename rep_type::difference_type    difference_type;
+    typedef typename rep_type::node_type          node_type;
 
 public:
     MultiMap() : t(Compare()) { }
@@ -60,13 +62,13 @@ public:
     template <typename InputIterator>
     MultiMap(InputIterator first, InputIterator last)
     {
-        t.insert_unique(first, last);
+        t.insert_equal(first, last);
     }
 
     template <typename InputIterator>
     MultiMap(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
     {
-        t.insert_unique(first, last);
+        t.insert_equal(first, last);
     }    
 
     MultiMap(const MultiMap& x) : t(x.t) { }
@@ -94,16 +96,37 @@ public:
         return t.insert_equal(val); 
     }
 
+    iterator insert(const_iterator hint, const value_type& val)
+    {
+        return t.insert_equal(hint, val);
+    }
+
     template <typename InputIterator>
     void insert(InputIterator first, InputIterator last)
     {
         t.insert_equal(first, last);
     }
 
+    iterator insert(node_type&& nh) { return t.insert_equal(std::move(nh)); }
+
+    node_type extract(const_iterator pos) { return t.extract(pos); }
+    node_type extract(const key_type& k) { return t.extract(k); }
+    void merge(MultiMap& x) { t.merge_equal(x.t); }
+
     void erase(iterator pos) { t.erase(pos); }
     void erase(iterator first, iterator last) { t.erase(first, last); }
     size_type erase(const key_type& k) { return t.erase(k); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    // full scans with prefetching; f may change mapped values
+    template <typename Function>
+    Function for_each(Function f) { return t.for_each(f); }
+
+    template <typename Function>
+    Function for_each(Function f) const { return t.for_each(f); }
+
     void clear() { t.clear(); }
     void swap(MultiMap& x) { t.swap(x.t); }
 
@@ -1,6 +1,7 @@
 #ifndef ZYX_MULTI_SET
 #define ZYX_MULTI_SET 
 
+#include <utility>
 #include "RedBlackTree.h"
 #include "Functional.h"
 
@@ -35,6 +36,7 @@ public:
     typedef typename rep_type::const_iterator     const_iterator;
     typedef typename rep_type::size_type          size_type;
     typedef typename rep_type::difference_type    difference_type;
+    typedef typename rep_type::node_type          node_type;
 
 public:
     MultiSet() : t(Compare()) { }
@@ -77,12 +79,23 @@ public:
         return t.insert_equal(val);
     }
 
+    iterator insert(iterator hint, const value_type& val)
+    {
+        return t.insert_equal(hint, val);
+    }
+
     template <typename InputIterator>
     void insert(InputIterator first, InputIterator last)
     {
         t.insert_equal(first, last);
     }
 
+    iterator insert(node_type&& nh) { return t.insert_equal(std::move(nh)); }
+
+    node_type extract(const_iterator pos) { return t.extract(pos); }
+    node_type extract(const key_type& k) { return t.extract(k); }
+    void merge(MultiSet& x) { t.merge_equal(x.t); }
+
     void erase(iterator pos)
     {
         typedef typename rep_type::iterator rep_iterator;
@@ -97,6 +110,13 @@ public:
 
     size_type erase(const key_type& k) { return t.erase(k); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    // full scan with prefetching
+    template <typename Function>
+    Function for_each(Function f) const { return t.for_each(f); }
+
     void clear() { t.clear(); }
     void swap(MultiSet& x) { t.swap(x.t); }
 
@@ -0,0 +1,92 @@
+#ifndef ZYX_NODE_HANDLE
+#define ZYX_NODE_HANDLE
+
+#include "Alloc.h"
+#include "Construct.h"
+
+namespace Zyx {
+
+//-------------------------------------【NodeHandle class】-----------------------------------
+
+// Owns a node extracted from a node-based container. It can be inserted into
+// another container of the same node type without allocating or copying.
+// A handle that still owns its node frees it when destroyed. Each node type
+// provides __node_value(Node*) returning its stored value.
+template <typename Node, typename Value, typename Alloc>
+class NodeHandle
+{
+public:
+    typedef Value    value_type;
+
+private:
+    typedef simple_alloc<Node, Alloc> node_allocator;
+
+    template <typename V, typename K, typename H, typename Ex, typename Eq, typename A>
+    friend class HashTable;
+    template <typename K, typename V, typename KoV, typename C, typename A, typename N>
+    friend class RedBlackTree;
+
+public:
+    NodeHandle() : ptr(nullptr) { }
+
+    NodeHandle(NodeHandle&& nh) : ptr(nh.ptr) { nh.ptr = nullptr; }
+
+    NodeHandle& operator=(NodeHandle&& nh)
+    {
+        if (this != &nh) {
+            reset();
+            ptr = nh.ptr;
+            nh.ptr = nullptr;
+        }
+        return *this;
+    }
+
+    ~NodeHandle() { reset(); }
+
+public:
+    bool empty() const { return ptr == nullptr; }
+    operator bool() const { return ptr != nullptr; }
+    value_type& value() const { return __node_value(ptr); }
+
+    void swap(NodeHandle& nh)
+    {
+        Node* tmp = ptr;
+        ptr = nh.ptr;
+        nh.ptr = tmp;
+    }
+
+private:
+    explicit NodeHandle(Node* p) : ptr(p) { }
+
+    Node* release()
+    {
+        Node* p = ptr;
+        ptr = nullptr;
+        return p;
+    }
+
+    void reset()
+    {
+        if (ptr != nullptr) {
+            destroy(&__node_value(ptr));
+            node_allocator::deallocate(ptr);
+            ptr = nullptr;
+        }
+    }
+
+    NodeHandle(const NodeHandle&);
+    NodeHandle& operator=(const NodeHandle&);
+
+private:
+    Node* ptr;
+};
+
+template <typename Node, typename Value, typename Alloc>
+inline void swap(NodeHandle<Node, Value, Alloc>& x, NodeHandle<Node, Value, Alloc>& y)
+{
+    x.swap(y);
+}
+
+}
+
+#endif
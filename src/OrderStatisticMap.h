@@ -0,0 +1,227 @@
+#ifndef ZYX_ORDER_STATISTIC_MAP
+#define ZYX_ORDER_STATISTIC_MAP
+
+#include "RedBlackTree.h"
+#include "Functional.h"
+
+namespace Zyx {
+
+//---------------------------------【OrderStatisticMap class】---------------------------------
+
+template <typename Key, typename Value, typename Compare = less<Key>, 
+          typename Alloc = alloc>
+class OrderStatisticMap
+{
+public:
+    typedef Key                                  key_type;
+    typedef Value                                data_type;
+    typedef Value                                mapped_type;
+    typedef Pair<const key_type, mapped_type>    value_type;
+    typedef Compare                              key_compare;
+
+public:
+    class value_compare
+    {
+    public:
+        friend class OrderStatisticMap;
+        typedef value_type first_argument_type;
+        typedef value_type second_argument_type;
+        typedef bool result_type;
+        bool operator()(const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+
+    private:
+        Compare comp;
+        value_compare(Compare c) : comp(c) { }
+    };
+
+private:
+    typedef RedBlackTree<key_type, value_type, select1st<value_type>, key_compare, Alloc, 
+                         __rb_tree_size_node<value_type> > 
+            rep_type;
+
+public:
+    typedef typename rep_type::pointer            pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::reference          reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::iterator           iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    OrderStatisticMap() : t(Compare()) { }
+    explicit OrderStatisticMap(const Compare& comp) : t(comp) { }
+
+    template <typename InputIterator>
+    OrderStatisticMap(InputIterator first, InputIterator last) : t(Compare())
+    {
+        t.insert_unique(first, last);
+    }
+
+    template <typename InputIterator>
+    OrderStatisticMap(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
+    {
+        t.insert_unique(first, last);
+    }
+
+    OrderStatisticMap(const OrderStatisticMap& x) : t(x.t) { }
+
+    OrderStatisticMap& operator=(const OrderStatisticMap& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    Pair<iterator, bool> insert(const value_type& val) { return t.insert_unique(val); }
+
+    iterator insert(const_iterator hint, const value_type& val)
+    {
+        return t.insert_unique(hint, val);
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_unique(first, last);
+    }
+
+    Pair<iterator, bool> try_emplace(const key_type& k) 
+    { 
+        return t.try_emplace_unique(end(), k); 
+    }
+
+    template <typename M>
+    Pair<iterator, bool> try_emplace(const key_type& k, M&& obj)
+    {
+        return t.try_emplace_unique(end(), k, std::forward<M>(obj));
+    }
+
+    template <typename M>
+    Pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+    {
+        // obj is only consumed by one of the two branches
+        Pair<iterator, bool> p = t.try_emplace_unique(end(), k, std::forward<M>(obj));
+        if (!p.second)
+            p.first->second = std::forward<M>(obj);
+        return p;
+    }
+
+    mapped_type& operator[](const key_type& k)
+    {
+        return try_emplace(k).first->second;
+    }
+
+    void erase(iterator pos) { t.erase(pos); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    void clear() { t.clear(); }
+    void swap(OrderStatisticMap& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) { return t.find(k); }
+    const_iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+    iterator lower_bound(const key_type& k) { return t.lower_bound(k); }
+    const_iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+    iterator upper_bound(const key_type& k) { return t.upper_bound(k); }
+    const_iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return t.equal_range(k);
+    }
+
+    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+public:
+    // order statistics in O(log n): the element at index k in key order, 
+    // the number of keys less than k, and positions of iterators
+    iterator nth(size_type k) { return t.nth(k); }
+    const_iterator nth(size_type k) const { return t.nth(k); }
+    size_type rank(const key_type& k) const { return t.rank(k); }
+    size_type index_of(const_iterator pos) const { return t.index_of(pos); }
+
+    difference_type distance(const_iterator first, const_iterator last) const 
+    { 
+        return t.distance(first, last); 
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator==(const OrderStatisticMap<Key, Value, Compare, Alloc>& lhs,
+                       const OrderStatisticMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator!=(const OrderStatisticMap<Key, Value, Compare, Alloc>& lhs,
+                       const OrderStatisticMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator<(const OrderStatisticMap<Key, Value, Compare, Alloc>& lhs,
+                      const OrderStatisticMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator>(const OrderStatisticMap<Key, Value, Compare, Alloc>& lhs,
+                      const OrderStatisticMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator<=(const OrderStatisticMap<Key, Value, Compare, Alloc>& lhs,
+                       const OrderStatisticMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator>=(const OrderStatisticMap<Key, Value, Compare, Alloc>& lhs,
+                       const OrderStatisticMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline void swap(OrderStatisticMap<Key, Value, Compare, Alloc>& lhs,
+                 OrderStatisticMap<Key, Value, Compare, Alloc>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
@@ -0,0 +1,331 @@
+#ifndef ZYX_ORDER_STATISTIC_SET
+#define ZYX_ORDER_STATISTIC_SET
+
+#include "RedBlackTree.h"
+#include "Functional.h"
+
+namespace Zyx {
+
+//---------------------------------【OrderStatisticSet class】---------------------------------
+
+template <typename Key, typename Compare = less<Key>, typename Alloc = alloc>
+class OrderStatisticSet
+{
+private:
+    typedef RedBlackTree<Key, Key, identity<Key>, Compare, Alloc, __rb_tree_size_node<Key> > 
+            rep_type;
+    typedef typename rep_type::iterator rep_iterator;
+
+public:
+    typedef Key        key_type;
+    typedef Key        value_type;
+    typedef Compare    key_compare;
+    typedef Compare    value_compare;
+
+    typedef typename rep_type::const_pointer      pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::const_reference    reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::const_iterator     iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    OrderStatisticSet() : t(Compare()) { }
+    explicit OrderStatisticSet(const Compare& comp) : t(comp) { }
+
+    template <typename InputIterator>
+    OrderStatisticSet(InputIterator first, InputIterator last) : t(Compare())
+    {
+        t.insert_unique(first, last);
+    }
+
+    template <typename InputIterator>
+    OrderStatisticSet(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
+    {
+        t.insert_unique(first, last);
+    }
+
+    OrderStatisticSet(const OrderStatisticSet& x) : t(x.t) { }
+
+    OrderStatisticSet& operator=(const OrderStatisticSet& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    Pair<iterator, bool> insert(const value_type& val)
+    {
+        Pair<typename rep_type::iterator, bool> p = t.insert_unique(val);
+        return Pair<iterator, bool>(p.first, p.second);
+    }
+
+    iterator insert(iterator hint, const value_type& val)
+    {
+        return t.insert_unique(hint, val);
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_unique(first, last);
+    }
+
+    void erase(iterator pos) { t.erase((rep_iterator&)pos); }
+    void erase(iterator first, iterator last) { t.erase((rep_iterator&)first, (rep_iterator&)last); }
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    void clear() { t.clear(); }
+    void swap(OrderStatisticSet& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+    iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+    iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+public:
+    // order statistics in O(log n): the element at index k in sorted order, 
+    // the number of elements less than k, and positions of iterators
+    iterator nth(size_type k) const { return t.nth(k); }
+    size_type rank(const key_type& k) const { return t.rank(k); }
+    size_type index_of(const_iterator pos) const { return t.index_of(pos); }
+
+    difference_type distance(const_iterator first, const_iterator last) const 
+    { 
+        return t.distance(first, last); 
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator==(const OrderStatisticSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticSet<Key, Compare, Alloc>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator!=(const OrderStatisticSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticSet<Key, Compare, Alloc>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator<(const OrderStatisticSet<Key, Compare, Alloc>& lhs,
+                      const OrderStatisticSet<Key, Compare, Alloc>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator>(const OrderStatisticSet<Key, Compare, Alloc>& lhs,
+                      const OrderStatisticSet<Key, Compare, Alloc>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator<=(const OrderStatisticSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticSet<Key, Compare, Alloc>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator>=(const OrderStatisticSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticSet<Key, Compare, Alloc>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline void swap(OrderStatisticSet<Key, Compare, Alloc>& lhs,
+                 OrderStatisticSet<Key, Compare, Alloc>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+//---------------------------------【OrderStatisticMultiSet class】---------------------------------
+
+template <typename Key, typename Compare = less<Key>, typename Alloc = alloc>
+class OrderStatisticMultiSet
+{
+private:
+    typedef RedBlackTree<Key, Key, identity<Key>, Compare, Alloc, __rb_tree_size_node<Key> > 
+            rep_type;
+    typedef typename rep_type::iterator rep_iterator;
+
+public:
+    typedef Key        key_type;
+    typedef Key        value_type;
+    typedef Compare    key_compare;
+    typedef Compare    value_compare;
+
+    typedef typename rep_type::const_pointer      pointer;
+    typedef typename rep_type::const_pointer      const_pointer;
+    typedef typename rep_type::const_reference    reference;
+    typedef typename rep_type::const_reference    const_reference;
+    typedef typename rep_type::const_iterator     iterator;
+    typedef typename rep_type::const_iterator     const_iterator;
+    typedef typename rep_type::size_type          size_type;
+    typedef typename rep_type::difference_type    difference_type;
+
+public:
+    OrderStatisticMultiSet() : t(Compare()) { }
+    explicit OrderStatisticMultiSet(const Compare& comp) : t(comp) { }
+
+    template <typename InputIterator>
+    OrderStatisticMultiSet(InputIterator first, InputIterator last) : t(Compare())
+    {
+        t.insert_equal(first, last);
+    }
+
+    template <typename InputIterator>
+    OrderStatisticMultiSet(InputIterator first, InputIterator last, const Compare& comp) : t(comp)
+    {
+        t.insert_equal(first, last);
+    }
+
+    OrderStatisticMultiSet(const OrderStatisticMultiSet& x) : t(x.t) { }
+
+    OrderStatisticMultiSet& operator=(const OrderStatisticMultiSet& x)
+    {
+        t = x.t;
+        return *this;
+    }
+
+public:
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+public:
+    iterator insert(const value_type& val) { return t.insert_equal(val); }
+
+    iterator insert(iterator hint, const value_type& val)
+    {
+        return t.insert_equal(hint, val);
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        t.insert_equal(first, last);
+    }
+
+    void erase(iterator pos) { t.erase((rep_iterator&)pos); }
+    void erase(iterator first, iterator last) { t.erase((rep_iterator&)first, (rep_iterator&)last); }
+    size_type erase(const key_type& k) { return t.erase(k); }
+
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    void clear() { t.clear(); }
+    void swap(OrderStatisticMultiSet& x) { t.swap(x.t); }
+
+public:
+    iterator find(const key_type& k) const { return t.find(k); }
+    size_type count(const key_type& k) const { return t.count(k); }
+    iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+    iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k) const
+    {
+        return t.equal_range(k);
+    }
+
+public:
+    // order statistics in O(log n): the element at index k in sorted order, 
+    // the number of elements less than k, and positions of iterators
+    iterator nth(size_type k) const { return t.nth(k); }
+    size_type rank(const key_type& k) const { return t.rank(k); }
+    size_type index_of(const_iterator pos) const { return t.index_of(pos); }
+
+    difference_type distance(const_iterator first, const_iterator last) const 
+    { 
+        return t.distance(first, last); 
+    }
+
+private:
+    rep_type t;
+};
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator==(const OrderStatisticMultiSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticMultiSet<Key, Compare, Alloc>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator!=(const OrderStatisticMultiSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticMultiSet<Key, Compare, Alloc>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator<(const OrderStatisticMultiSet<Key, Compare, Alloc>& lhs,
+                      const OrderStatisticMultiSet<Key, Compare, Alloc>& rhs)
+{
+    return Zyx::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator>(const OrderStatisticMultiSet<Key, Compare, Alloc>& lhs,
+                      const OrderStatisticMultiSet<Key, Compare, Alloc>& rhs)
+{
+    return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator<=(const OrderStatisticMultiSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticMultiSet<Key, Compare, Alloc>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator>=(const OrderStatisticMultiSet<Key, Compare, Alloc>& lhs,
+                       const OrderStatisticMultiSet<Key, Compare, Alloc>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline void swap(OrderStatisticMultiSet<Key, Compare, Alloc>& lhs,
+                 OrderStatisticMultiSet<Key, Compare, Alloc>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
@@ -0,0 +1,402 @@
+#ifndef ZYX_PERSISTENT_MAP
+#define ZYX_PERSISTENT_MAP
+
+#include <atomic>
+#include <new>
+#include "Algorithm.h"
+#include "Alloc.h"
+#include "Construct.h"
+#include "Functional.h"
+#include "Iterator.h"
+#include "Utility.h"
+
+namespace Zyx {
+
+template <typename Value>
+struct __persistent_node
+{
+    std::atomic<size_t> refs;
+    __persistent_node* left;
+    __persistent_node* right;
+    int height;
+    Value val;
+};
+
+// walks the tree with an explicit stack of the nodes whose right part is
+// still to be visited; the top is the current node and end() is empty
+template <typename Value>
+struct __persistent_map_iterator
+{
+    typedef __persistent_map_iterator<Value>    self;
+    typedef const __persistent_node<Value>*     node_ptr;
+
+    typedef forward_iterator_tag    iterator_category;
+    typedef Value                   value_type;
+    typedef const Value*            pointer;
+    typedef const Value&            reference;
+    typedef ptrdiff_t               difference_type;
+
+    // an AVL tree of 2^64 nodes is less than 93 levels high
+    enum { __MAX_DEPTH = 96 };
+
+    node_ptr stack[__MAX_DEPTH];
+    int depth;
+
+    __persistent_map_iterator() : depth(0) { }
+
+    bool operator==(const self& x) const
+    {
+        return depth == x.depth && (depth == 0 || stack[depth - 1] == x.stack[depth - 1]);
+    }
+
+    bool operator!=(const self& x) const { return !(*this == x); }
+
+    reference operator*() const { return stack[depth - 1]->val; }
+    pointer operator->() const { return &(operator*()); }
+
+    void push_left(node_ptr x)
+    {
+        for (; x != nullptr; x = x->left)
+            stack[depth++] = x;
+    }
+
+    self& operator++()
+    {
+        node_ptr x = stack[--depth];
+        push_left(x->right);
+        return *this;
+    }
+
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+};
+
+//------------------------------------【PersistentMap class】-----------------------------------
+
+// An immutable-node ordered map. Copying a PersistentMap takes O(1) and
+// shares every node; an update copies only the O(log n) nodes on the path
+// to the change, so earlier copies keep seeing their own version. Node
+// reference counts are atomic, so a reader can hold and drop its snapshot
+// on any thread without locks. A single PersistentMap object is still not
+// safe to update while another thread copies it.
+//
+// Nodes are freed by whichever thread drops the last version that holds
+// them, often a reader's, so Alloc defaults to malloc_alloc rather than to
+// default_alloc's per-thread free lists.
+template <typename Key, typename Value, typename Compare = less<Key>,
+          typename Alloc = malloc_alloc>
+class PersistentMap
+{
+public:
+    typedef Key                                  key_type;
+    typedef Value                                data_type;
+    typedef Value                                mapped_type;
+    typedef Pair<const key_type, mapped_type>    value_type;
+    typedef Compare                              key_compare;
+    typedef const value_type*                    const_pointer;
+    typedef const value_type&                    const_reference;
+    typedef size_t                               size_type;
+    typedef ptrdiff_t                            difference_type;
+
+    typedef __persistent_map_iterator<value_type>    const_iterator;
+    typedef const_iterator                           iterator;
+
+private:
+    typedef __persistent_node<value_type>            node;
+    typedef simple_alloc<node, Alloc>                node_allocator;
+
+public:
+    PersistentMap() : root(nullptr), node_count(0), comp(Compare()) { }
+    explicit PersistentMap(const Compare& c) : root(nullptr), node_count(0), comp(c) { }
+
+    template <typename InputIterator>
+    PersistentMap(InputIterator first, InputIterator last)
+      : root(nullptr), node_count(0), comp(Compare())
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    PersistentMap(const PersistentMap& x)
+      : root(retain(x.root)), node_count(x.node_count), comp(x.comp)
+    {
+    }
+
+    PersistentMap& operator=(const PersistentMap& x)
+    {
+        PersistentMap tmp(x);
+        swap(tmp);
+        return *this;
+    }
+
+    ~PersistentMap() { release(root); }
+
+public:
+    key_compare key_comp() const { return comp; }
+    const_iterator begin() const
+    {
+        const_iterator it;
+        it.push_left(root);
+        return it;
+    }
+    const_iterator end() const { return const_iterator(); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    size_type max_size() const { return size_type(-1); }
+
+public:
+    // updates build a new version in place; copies taken before are unchanged
+    Pair<const_iterator, bool> insert(const value_type& val)
+    {
+        if (find_node(val.first) != nullptr)
+            return Pair<const_iterator, bool>(lower_bound(val.first), false);
+        replace_root(insert_node(root, val));
+        ++node_count;
+        return Pair<const_iterator, bool>(lower_bound(val.first), true);
+    }
+
+    template <typename M>
+    Pair<const_iterator, bool> insert_or_assign(const key_type& k, const M& obj)
+    {
+        const bool inserted = find_node(k) == nullptr;
+        replace_root(insert_node(root, value_type(k, obj)));
+        if (inserted)
+            ++node_count;
+        return Pair<const_iterator, bool>(lower_bound(k), inserted);
+    }
+
+    size_type erase(const key_type& k)
+    {
+        if (find_node(k) == nullptr)
+            return 0;
+        replace_root(erase_node(root, k));
+        --node_count;
+        return 1;
+    }
+
+    void clear()
+    {
+        release(root);
+        root = nullptr;
+        node_count = 0;
+    }
+
+    void swap(PersistentMap& x)
+    {
+        Zyx::swap(root, x.root);
+        Zyx::swap(node_count, x.node_count);
+        Zyx::swap(comp, x.comp);
+    }
+
+public:
+    // iterators carry a stack of __MAX_DEPTH nodes, so one is built only
+    // for a key that is present
+    const_iterator find(const key_type& k) const
+    {
+        return find_node(k) == nullptr ? end() : lower_bound(k);
+    }
+
+    bool contains(const key_type& k) const { return find_node(k) != nullptr; }
+    size_type count(const key_type& k) const { return find_node(k) == nullptr ? 0 : 1; }
+
+    // the mapped value of k, or nullptr; a plain descent with no iterator
+    const mapped_type* get(const key_type& k) const
+    {
+        const node* x = find_node(k);
+        return x == nullptr ? nullptr : &x->val.second;
+    }
+
+    // the stack keeps the nodes where the search went left
+    const_iterator lower_bound(const key_type& k) const
+    {
+        const_iterator it;
+        for (const node* x = root; x != nullptr; ) {
+            if (comp(x->val.first, k)) {
+                x = x->right;
+            } else {
+                it.stack[it.depth++] = x;
+                x = x->left;
+            }
+        }
+        return it;
+    }
+
+    const_iterator upper_bound(const key_type& k) const
+    {
+        const_iterator it;
+        for (const node* x = root; x != nullptr; ) {
+            if (comp(k, x->val.first)) {
+                it.stack[it.depth++] = x;
+                x = x->left;
+            } else {
+                x = x->right;
+            }
+        }
+        return it;
+    }
+
+    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return Pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+
+private:
+    const node* find_node(const key_type& k) const
+    {
+        const node* x = root;
+        while (x != nullptr) {
+            if (comp(k, x->val.first))
+                x = x->left;
+            else if (comp(x->val.first, k))
+                x = x->right;
+            else
+                break;
+        }
+        return x;
+    }
+
+    // every function below takes borrowed node pointers and returns an
+    // owned reference, except create_node and balance, which take over l and r
+    static node* retain(node* x)
+    {
+        if (x != nullptr)
+            x->refs.fetch_add(1, std::memory_order_relaxed);
+        return x;
+    }
+
+    static void release(node* x)
+    {
+        while (x != nullptr && x->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            node* right = x->right;
+            release(x->left);
+            destroy(&x->val);
+            x->refs.~atomic();
+            node_allocator::deallocate(x);
+            x = right;
+        }
+    }
+
+    void replace_root(node* x)
+    {
+        release(root);
+        root = x;
+    }
+
+    static int height(const node* x) { return x == nullptr ? 0 : x->height; }
+
+    static node* create_node(const value_type& val, node* l, node* r)
+    {
+        node* x = node_allocator::allocate();
+        new (&x->refs) std::atomic<size_t>(1);
+        x->left = l;
+        x->right = r;
+        x->height = 1 + max(height(l), height(r));
+        construct(&x->val, val);
+        return x;
+    }
+
+    // builds the node (val, l, r), rotating once or twice when the
+    // heights of l and r differ by two
+    static node* balance(const value_type& val, node* l, node* r)
+    {
+        if (height(l) > height(r) + 1) {
+            node* result;
+            if (height(l->left) >= height(l->right)) {
+                result = create_node(l->val, retain(l->left),
+                                     create_node(val, retain(l->right), r));
+            } else {
+                node* lr = l->right;
+                result = create_node(lr->val,
+                                     create_node(l->val, retain(l->left), retain(lr->left)),
+                                     create_node(val, retain(lr->right), r));
+            }
+            release(l);
+            return result;
+        }
+        if (height(r) > height(l) + 1) {
+            node* result;
+            if (height(r->right) >= height(r->left)) {
+                result = create_node(r->val, create_node(val, l, retain(r->left)),
+                                     retain(r->right));
+            } else {
+                node* rl = r->left;
+                result = create_node(rl->val,
+                                     create_node(val, l, retain(rl->left)),
+                                     create_node(r->val, retain(rl->right), retain(r->right)));
+            }
+            release(r);
+            return result;
+        }
+        return create_node(val, l, r);
+    }
+
+    // inserts val, or replaces the value with an equal key
+    node* insert_node(node* x, const value_type& val)
+    {
+        if (x == nullptr)
+            return create_node(val, nullptr, nullptr);
+        if (comp(val.first, x->val.first))
+            return balance(x->val, insert_node(x->left, val), retain(x->right));
+        if (comp(x->val.first, val.first))
+            return balance(x->val, retain(x->left), insert_node(x->right, val));
+        return create_node(val, retain(x->left), retain(x->right));
+    }
+
+    // k must be present
+    node* erase_node(node* x, const key_type& k)
+    {
+        if (comp(k, x->val.first))
+            return balance(x->val, erase_node(x->left, k), retain(x->right));
+        if (comp(x->val.first, k))
+            return balance(x->val, retain(x->left), erase_node(x->right, k));
+        if (x->left == nullptr)
+            return retain(x->right);
+        if (x->right == nullptr)
+            return retain(x->left);
+        const node* successor = x->right;
+        while (successor->left != nullptr)
+            successor = successor->left;
+        return balance(successor->val, retain(x->left), erase_min(x->right));
+    }
+
+    static node* erase_min(node* x)
+    {
+        if (x->left == nullptr)
+            return retain(x->right);
+        return balance(x->val, erase_min(x->left), retain(x->right));
+    }
+
+private:
+    node* root;
+    size_type node_count;
+    Compare comp;
+};
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator==(const PersistentMap<Key, Value, Compare, Alloc>& lhs,
+                       const PersistentMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return lhs.size() == rhs.size() && Zyx::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline bool operator!=(const PersistentMap<Key, Value, Compare, Alloc>& lhs,
+                       const PersistentMap<Key, Value, Compare, Alloc>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+inline void swap(PersistentMap<Key, Value, Compare, Alloc>& lhs,
+                 PersistentMap<Key, Value, Compare, Alloc>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef ZYX_RW_LOCK
+#define ZYX_RW_LOCK
+
+#include <mutex>
+#include <condition_variable>
+#include "NonCopyable.h"
+
+namespace Zyx {
+
+// reader-writer lock: any number of readers or a single writer. Waiting writers
+// block new readers, so a steady stream of lookups cannot starve an update.
+class RWLock : NonCopyable
+{
+public:
+    RWLock() : readers(0), waiting_writers(0), writer(false) { }
+
+public:
+    void lock()
+    {
+        std::unique_lock<std::mutex> lk(m);
+        ++waiting_writers;
+        while (writer || readers != 0)
+            write_cond.wait(lk);
+        --waiting_writers;
+        writer = true;
+    }
+
+    void unlock()
+    {
+        std::unique_lock<std::mutex> lk(m);
+        writer = false;
+        if (waiting_writers != 0)
+            write_cond.notify_one();
+        else
+            read_cond.notify_all();
+    }
+
+    void lock_shared()
+    {
+        std::unique_lock<std::mutex> lk(m);
+        while (writer || waiting_writers != 0)
+            read_cond.wait(lk);
+        ++readers;
+    }
+
+    void unlock_shared()
+    {
+        std::unique_lock<std::mutex> lk(m);
+        if (--readers == 0 && waiting_writers != 0)
+            write_cond.notify_one();
+    }
+
+private:
+    std::mutex m;
+    std::condition_variable read_cond;
+    std::condition_variable write_cond;
+    size_t readers;
+    size_t waiting_writers;
+    bool writer;
+};
+
+}
+
+#endif
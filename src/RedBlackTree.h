@@ -1,11 +1,15 @@
 #ifndef ZYX_RED_BLACK_TREE
 #define ZYX_RED_BLACK_TREE 
 
+#include <thread>
+#include <utility>
+#include "TypeTraits.h"
 #include "Iterator.h"
 #include "Alloc.h"
 #include "Construct.h"
 #include "Algorithm.h"
 #include "Utility.h"
+#include "NodeHandle.h"
 
 namespace Zyx {
 
@@ -18,11 +22,32 @@ struct __rb_tree_node_base
     typedef __rb_tree_color_type color_type;
     typedef __rb_tree_node_base* base_ptr;
 
-    color_type color;
-    base_ptr parent;
+    // the color lives in the low bit of the parent link, which node 
+    // alignment leaves free. Red is 0, so the header, which is always red, 
+    // holds a plain root pointer there.
+    base_ptr tagged_parent;
     base_ptr left;
     base_ptr right;
 
+    base_ptr parent() const
+    {
+        return reinterpret_cast<base_ptr>(reinterpret_cast<size_t>(tagged_parent) & ~size_t(1));
+    }
+
+    void set_parent(base_ptr p)
+    {
+        tagged_parent = reinterpret_cast<base_ptr>(reinterpret_cast<size_t>(p) | 
+                                                   (reinterpret_cast<size_t>(tagged_parent) & 1));
+    }
+
+    color_type color() const { return (reinterpret_cast<size_t>(tagged_parent) & 1) != 0; }
+
+    void set_color(color_type c)
+    {
+        tagged_parent = reinterpret_cast<base_ptr>((reinterpret_cast<size_t>(tagged_parent) & ~size_t(1)) | 
+                                                   size_t(c));
+    }
+
     static base_ptr minimum(base_ptr x)
     {
         while (x->left != nullptr)
@@ -36,6 +61,11 @@ struct __rb_tree_node_base
             x = x->right;
         return x;
     }	
+
+    // nodes that keep data about their subtree hide these; augment(x) 
+    // recomputes x's data from its children
+    enum { augmented = false };
+    static void augment(base_ptr) { }
 };
 
 template <typename T>
@@ -45,6 +75,81 @@ struct __rb_tree_node : public __rb_tree_node_base
     T data;
 };
 
+template <typename T>
+inline T& __node_value(__rb_tree_node<T>* p)
+{
+    return p->data;
+}
+
+// counts the nodes of its subtree, which gives RedBlackTree O(log n) 
+// nth, rank and distance
+template <typename T>
+struct __rb_tree_size_node : public __rb_tree_node<T>
+{
+    typedef __rb_tree_node_base::base_ptr base_ptr;
+
+    size_t size;
+
+    enum { augmented = true };
+
+    static size_t size_of(base_ptr x)
+    {
+        return x == nullptr ? 0 : static_cast<__rb_tree_size_node*>(x)->size;
+    }
+
+    static void augment(base_ptr x)
+    {
+        static_cast<__rb_tree_size_node*>(x)->size = 1 + size_of(x->left) + size_of(x->right);
+    }
+};
+
+// keeps the node with the greatest high endpoint in its subtree, which gives 
+// RedBlackTree overlap queries in O(log n + k log(n / k)) for k results. T 
+// is Pair<const Pair<E, E>, V> holding the closed interval [first.first, 
+// first.second]; endpoints are ordered by a default constructed Compare
+template <typename T, typename Compare>
+struct __rb_tree_interval_node : public __rb_tree_node<T>
+{
+    typedef __rb_tree_node_base::base_ptr          base_ptr;
+    typedef typename T::first_type::first_type     endpoint_type;
+
+    base_ptr max_node;
+
+    enum { augmented = true };
+
+    static const endpoint_type& low(base_ptr x)
+    {
+        return static_cast<__rb_tree_interval_node*>(x)->data.first.first;
+    }
+
+    static const endpoint_type& high(base_ptr x)
+    {
+        return static_cast<__rb_tree_interval_node*>(x)->data.first.second;
+    }
+
+    static const endpoint_type& max_high(base_ptr x)
+    {
+        return high(static_cast<__rb_tree_interval_node*>(x)->max_node);
+    }
+
+    static bool before(const endpoint_type& a, const endpoint_type& b) { return Compare()(a, b); }
+
+    static bool overlaps(base_ptr x, const endpoint_type& lo, const endpoint_type& hi)
+    {
+        return !before(hi, low(x)) && !before(high(x), lo);
+    }
+
+    static void augment(base_ptr x)
+    {
+        base_ptr m = x;
+        if (x->left != nullptr && before(high(m), max_high(x->left)))
+            m = static_cast<__rb_tree_interval_node*>(x->left)->max_node;
+        if (x->right != nullptr && before(high(m), max_high(x->right)))
+            m = static_cast<__rb_tree_interval_node*>(x->right)->max_node;
+        static_cast<__rb_tree_interval_node*>(x)->max_node = m;
+    }
+};
+
 struct __rb_tree_base_iterator
 {
     typedef __rb_tree_node_base::base_ptr    base_ptr;
@@ -62,10 +167,10 @@ struct __rb_tree_base_iterator
             while (node->left != nullptr)
                 node = node->left;
         } else {
-            base_ptr y = node->parent;
+            base_ptr y = node->parent();
             while (y->right == node) {
                 node = y;
-                y = y->parent;
+                y = y->parent();
             }
             if (node->right != y) 
                 node = y;
@@ -74,17 +179,17 @@ struct __rb_tree_base_iterator
 
     void decrement()
     {
-        if (node->color == __rb_tree_red && node->parent->parent == node) {
+        if (node->color() == __rb_tree_red && node->parent()->parent() == node) {
             node = node->right;
         } else if (node->left != nullptr) {
             node = node->left;
             while (node->right != nullptr) 
                 node = node->right;
         } else {
-            base_ptr y = node->parent;
+            base_ptr y = node->parent();
             while (y->left == node) {
                 node = y;
-                y = y->parent;
+                y = y->parent();
             }
             node = y;
         }
@@ -141,15 +246,22 @@ struct __rb_tree_iterator : public __rb_tree_base_iterator
 };
 
 template <typename Key, typename Value, typename KeyOfValue, 
-          typename Compare, typename Alloc = alloc>
+          typename Compare, typename Alloc = alloc, 
+          typename Node = __rb_tree_node<Value> >
 class RedBlackTree
 {
 private:
     typedef __rb_tree_node_base*                 base_ptr;
-    typedef __rb_tree_node<Value>                rb_tree_node;
+    typedef Node                                 rb_tree_node;
     typedef simple_alloc<rb_tree_node, Alloc>    rb_tree_node_allocator;
     typedef __rb_tree_color_type                 color_type;
 
+    // the color bit needs even node addresses. Nodes hold pointers, and 
+    // every allocator here returns blocks aligned for them: malloc_alloc 
+    // through malloc, default_alloc by carving multiples of 8 bytes
+    static_assert(alignof(rb_tree_node) >= 2 && sizeof(rb_tree_node) % 2 == 0,
+                  "the red-black color bit needs even node addresses");
+
 public:
     typedef Key                  key_type;
     typedef Value                value_type;
@@ -166,6 +278,8 @@ public:
     typedef __rb_tree_iterator<value_type, const_reference, const_pointer> 
             const_iterator;
 
+    typedef NodeHandle<rb_tree_node, value_type, Alloc> node_type;
+
 public:
     RedBlackTree(const Compare& comp = Compare()) 
       : node_count(0), key_compare(comp) { empty_intialize(); }
@@ -177,7 +291,6 @@ public:
             empty_intialize();
         } else {
             header = get_node();
-            color(header) = __rb_tree_red;
             root() = __copy(x.root(), header);
             leftmost() = minimum(root());
             rightmost() = maximum(root());
@@ -228,76 +341,318 @@ public:
 public:
     iterator insert_equal(const value_type& val)
     {
-        link_type y = header;
-        link_type x = root();
-        while (x != nullptr) {
-            y = x;
-            x = key_compare(KeyOfValue()(val), key(x)) ? left(x) : right(x);
-        }
+        link_type x, y;
+        __insert_equal_pos(KeyOfValue()(val), x, y);
         return __insert(x, y, val);
     }    
 
     Pair<iterator, bool> insert_unique(const value_type& val)
     {
+        link_type x, y;
+        if (__insert_unique_pos(KeyOfValue()(val), x, y))
+            return make_pair(__insert(x, y, val), true);
+        return make_pair(iterator(y), false);
+    }
+
+    // hinted inserts cost amortized O(1) when val belongs right before hint; 
+    // end() is the right hint for appending increasing keys
+    iterator insert_equal(const_iterator hint, const value_type& val)
+    {
+        link_type x, y;
+        __insert_hint_equal_pos(hint.node, KeyOfValue()(val), x, y);
+        return __insert(x, y, val);
+    }
+
+    iterator insert_unique(const_iterator hint, const value_type& val)
+    {
+        link_type x, y;
+        if (__insert_hint_unique_pos(hint.node, KeyOfValue()(val), x, y))
+            return __insert(x, y, val);
+        return iterator(y);
+    }
+
+    // for map-like values: inserts value_type(k, arg), or value_type(k, 
+    // second_type()) without arg, only when k is absent, so nothing is 
+    // constructed for a key that already exists
+    Pair<iterator, bool> try_emplace_unique(const_iterator hint, const key_type& k)
+    {
+        link_type x, y;
+        if (!__insert_hint_unique_pos(hint.node, k, x, y))
+            return Pair<iterator, bool>(iterator(y), false);
+        link_type z = create_node(k, typename value_type::second_type());
+        return Pair<iterator, bool>(__insert_node(x, y, z), true);
+    }
+
+    // arg is forwarded, so an rvalue is moved into the new element
+    template <typename Arg>
+    Pair<iterator, bool> try_emplace_unique(const_iterator hint, const key_type& k, Arg&& arg)
+    {
+        link_type x, y;
+        if (!__insert_hint_unique_pos(hint.node, k, x, y))
+            return Pair<iterator, bool>(iterator(y), false);
+        link_type z = create_node(k, std::forward<Arg>(arg));
+        return Pair<iterator, bool>(__insert_node(x, y, z), true);
+    }
+
+    // an empty tree loaded from sorted forward iterators is built directly in O(n)
+    template <typename InputIterator>
+    void insert_equal(InputIterator first, InputIterator last)
+    {
+        __insert_range(first, last, false, iterator_category(first));
+    }
+
+    template <typename InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        __insert_range(first, last, true, iterator_category(first));
+    }
+
+    node_type extract(const_iterator pos)
+    {
+        link_type y = (link_type)__rb_tree_rebalance_for_erase(pos.node, 
+                                                               header->tagged_parent, 
+                                                               header->left, 
+                                                               header->right);
+        --node_count;
+        return node_type(y);
+    }
+
+    node_type extract(const key_type& k)
+    {
+        iterator pos = find(k);
+        return pos == end() ? node_type() : extract(pos);
+    }
+
+    // links the handle's node in unless its key is already present, in which 
+    // case the handle keeps the node
+    Pair<iterator, bool> insert_unique(node_type&& nh)
+    {
+        if (nh.empty())
+            return make_pair(end(), false);
+        link_type x, y;
+        if (!__insert_unique_pos(key(nh.ptr), x, y))
+            return make_pair(iterator(y), false);
+        return make_pair(__insert_node(x, y, nh.release()), true);
+    }
+
+    iterator insert_equal(node_type&& nh)
+    {
+        if (nh.empty())
+            return end();
+        link_type z = nh.release();
         link_type y = header;
         link_type x = root();
-        bool comp = true;
         while (x != nullptr) {
             y = x;
-            comp = key_compare(KeyOfValue()(val), key(x));
-            x = comp ? left(x) : right(x);
+            x = key_compare(key(z), key(x)) ? left(x) : right(x);
         }
+        return __insert_node(x, y, z);
+    }
 
-        iterator j = iterator(y);
-        if (comp) {
-            if (j == begin())
-                return make_pair(__insert(x, y, val), true);
-            else 
-                --j;
+    // moves every node of t whose key is not present here; nodes are relinked, 
+    // not copied
+    void merge_unique(RedBlackTree& t)
+    {
+        if (&t == this)
+            return;
+        iterator first = t.begin();
+        while (first != t.end()) {
+            iterator cur = first++;
+            link_type x, y;
+            if (__insert_unique_pos(key(cur.node), x, y))
+                __insert_node(x, y, t.extract(cur).release());
         }
+    }
 
-        if (key_compare(key(j.node), KeyOfValue()(val)))
-            return make_pair(__insert(x, y, val), true);
+    void merge_equal(RedBlackTree& t)
+    {
+        if (&t == this)
+            return;
+        while (!t.empty())
+            insert_equal(t.extract(t.begin()));
+    }
 
-        return make_pair(j, false);
+    // set algebra for unique keys by split and join, in O(m log(n / m + 1)) 
+    // for sizes m <= n. The rvalue forms relink x's nodes and leave x empty; 
+    // on equal keys the element of *this is kept. With parallel set, large 
+    // inputs work on both halves of the recursion concurrently.
+    void union_with(RedBlackTree&& x, bool parallel = false)
+    {
+        if (&x == this)
+            return;
+        link_type garbage = nullptr;
+        base_ptr r = __union(__whole(root()), __whole(x.root()), garbage, 
+                             __spawn_depth(x, parallel)).root;
+        __adopt(r, node_count + x.node_count, garbage, x);
     }
 
-    template <typename InputIterator>
-    void insert_equal(InputIterator first, InputIterator last)
+    void intersect_with(RedBlackTree&& x, bool parallel = false)
     {
-        for (; first != last; ++first)
-            insert_equal(*first);
+        if (&x == this)
+            return;
+        link_type garbage = nullptr;
+        base_ptr r = __intersect(__whole(root()), __whole(x.root()), garbage, 
+                                 __spawn_depth(x, parallel)).root;
+        __adopt(r, node_count + x.node_count, garbage, x);
     }
 
-    template <typename InputIterator>
-    void insert_unique(InputIterator first, InputIterator last)
+    void difference_with(RedBlackTree&& x, bool parallel = false)
+    {
+        if (&x == this) {
+            clear();
+            return;
+        }
+        link_type garbage = nullptr;
+        base_ptr r = __difference(__whole(root()), __whole(x.root()), garbage, 
+                                  __spawn_depth(x, parallel)).root;
+        __adopt(r, node_count + x.node_count, garbage, x);
+    }
+
+    // the const forms copy only when the result needs x's elements or the 
+    // work runs in parallel, and otherwise look up the smaller side in the 
+    // larger one
+    void union_with(const RedBlackTree& x, bool parallel = false)
+    {
+        if (&x != this) {
+            RedBlackTree tmp(x);
+            union_with(std::move(tmp), parallel);
+        }
+    }
+
+    void intersect_with(const RedBlackTree& x, bool parallel = false)
     {
-        for (; first != last; ++first)
-            insert_unique(*first);
+        if (&x == this)
+            return;
+        if (node_count <= x.node_count) {
+            for (iterator first = begin(); first != end(); ) {
+                iterator cur = first++;
+                if (x.find(key(cur.node)) == x.end())
+                    erase(cur);
+            }
+        } else {
+            RedBlackTree tmp(x);
+            intersect_with(std::move(tmp), parallel);
+        }
+    }
+
+    void difference_with(const RedBlackTree& x, bool parallel = false)
+    {
+        if (&x == this) {
+            clear();
+        } else if (__spawn_depth(x, parallel) > 0) {
+            RedBlackTree tmp(x);
+            difference_with(std::move(tmp), parallel);
+        } else if (x.node_count < node_count) {
+            for (const_iterator first = x.begin(); first != x.end(); ++first)
+                erase(key(first.node));
+        } else {
+            for (iterator first = begin(); first != end(); ) {
+                iterator cur = first++;
+                if (x.find(key(cur.node)) != x.end())
+                    erase(cur);
+            }
+        }
     }
 
     void erase(iterator pos)
     {
         link_type y = (link_type)__rb_tree_rebalance_for_erase(pos.node, 
-                                                               header->parent, 
+                                                               header->tagged_parent, 
                                                                header->left, 
                                                                header->right);
         destroy_node(y);
         --node_count;
     }
     
+    // short ranges go node by node; longer ones are cut out with two splits 
+    // and a join, in O(log n + k) with no per-node rebalancing
     void erase(iterator first, iterator last)
     {
-        if (first == begin() && last == end())
+        if (first == begin() && last == end()) {
             clear();
-        else 
-            while (first != last) erase(first++);
+            return;
+        }
+        iterator probe = first;
+        for (int i = 0; i < __SPLIT_ERASE_THRESHOLD && probe != last; ++i)
+            ++probe;
+        if (probe == last) {
+            while (first != last) 
+                erase(first++);
+            return;
+        }
+
+        link_type garbage = nullptr;
+        __subtree l, m, r;
+        if (last.node == header) {
+            __split_before(__whole(root()), first.node, l, m);
+        } else {
+            __subtree rest;
+            __split_before(__whole(root()), last.node, rest, r);
+            __split_before(rest, first.node, l, m);
+        }
+        __discard(m.root, garbage);
+        __install(__join2(l, r).root, node_count, garbage);
+    }
+
+    // removes the elements satisfying pred, calling it once per element. 
+    // The first __SPLIT_ERASE_THRESHOLD matches are erased in place; past 
+    // that, the survivors are relinked into a balanced tree in one pass and 
+    // the rest freed together. Iterators to survivors stay valid.
+    template <typename Predicate>
+    size_type erase_if(Predicate pred)
+    {
+        const size_type old_count = node_count;
+        iterator first = begin();
+        for (int erased = 0; first != end(); ) {
+            if (!pred(*first)) {
+                ++first;
+            } else if (erased < __SPLIT_ERASE_THRESHOLD) {
+                erase(first++);
+                ++erased;
+            } else {
+                break;
+            }
+        }
+        if (first == end())
+            return old_count - node_count;
+
+        // each node is threaded through its left link only after the 
+        // iterator has left it, which never reads that link again
+        base_ptr kept = nullptr;
+        base_ptr* tail = &kept;
+        link_type garbage = nullptr;
+        size_type n = 0;
+        bool passed = false;
+        for (iterator it = begin(); it != end(); ) {
+            base_ptr x = it.node;
+            bool drop = false;
+            if (x == first.node)
+                passed = drop = true;
+            else if (passed)
+                drop = pred(*it);
+            ++it;
+            if (drop) {
+                x->left = garbage;
+                garbage = (link_type)x;
+            } else {
+                *tail = x;
+                tail = &x->left;
+                ++n;
+            }
+        }
+        *tail = nullptr;
+
+        int red_depth = 0;
+        while ((size_type(2) << red_depth) - 1 <= n)
+            ++red_depth;
+        __install(__relink_subtree(kept, n, 0, red_depth), node_count, garbage);
+        return old_count - node_count;
     }
 
     size_type erase(const key_type& k)
     {
         Pair<iterator, iterator> p = equal_range(k);
-        size_type n = distance(p.first, p.second);
+        size_type n = Zyx::distance(p.first, p.second);
         erase(p.first, p.second);
         return n;
     }
@@ -320,90 +675,277 @@ public:
         Zyx::swap(key_compare, t.key_compare);
     }
 
-    iterator find(const key_type& k)
+    iterator find(const key_type& k) { return find_node(k); }
+    const_iterator find(const key_type& k) const { return find_node(k); }
+
+    size_type count(const key_type& k) const
     {
-        link_type y = header;
-        link_type x = root();
-        while (x != nullptr) {
-            if (!key_compare(key(x), k)) {
-                y = x;
-                x = left(x);
-            } else {
-                x = right(x);
+        Pair<const_iterator, const_iterator> p = equal_range(k);
+        return Zyx::distance(p.first, p.second);
+    }
+
+    iterator lower_bound(const key_type& k) { return lower_bound_node(k); }
+    const_iterator lower_bound(const key_type& k) const { return lower_bound_node(k); }
+    iterator upper_bound(const key_type& k) { return upper_bound_node(k); }
+    const_iterator upper_bound(const key_type& k) const { return upper_bound_node(k); }
+
+    Pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return make_pair(lower_bound(k), upper_bound(k));
+    }
+
+    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return make_pair(lower_bound(k), upper_bound(k));
+    }
+
+public:
+    // calls f on every element in order. The walk keeps its own stack, and 
+    // each node's right child is prefetched on the way down, long before 
+    // the walk comes back for it, so a full scan does not wait on every node.
+    template <typename Function>
+    Function for_each(Function f) { return __for_each<reference>(f); }
+
+    template <typename Function>
+    Function for_each(Function f) const { return __for_each<const_reference>(f); }
+
+private:
+    template <typename Ref, typename Function>
+    Function __for_each(Function& f) const
+    {
+        base_ptr stack[2 * 8 * sizeof(size_type)];
+        int depth = 0;
+        base_ptr x = root();
+        for (;;) {
+            for (; x != nullptr; x = x->left) {
+                __prefetch(x->right);
+                stack[depth++] = x;
             }
+            if (depth == 0)
+                return f;
+            x = stack[--depth];
+            f(static_cast<Ref>(value(x)));
+            x = x->right;
         }
-        iterator j = iterator(y);
-        return (j == end() || key_compare(k, key(j.node))) ? end() : j;
     }
 
-    const_iterator find(const key_type& k) const
+public:
+    // order statistics in O(log n); only usable with __rb_tree_size_node
+    iterator nth(size_type k) { return iterator((link_type)nth_node(k)); }
+    const_iterator nth(size_type k) const { return const_iterator((link_type)nth_node(k)); }
+
+    // number of elements whose key is less than k
+    size_type rank(const key_type& k) const
     {
-        link_type y = header;
-        link_type x = root();
+        size_type r = 0;
+        base_ptr x = root();
         while (x != nullptr) {
-            if (!key_compare(key(x), k)) {
-                y = x;
-                x = left(x);
+            if (key_compare(key(x), k)) {
+                r += rb_tree_node::size_of(x->left) + 1;
+                x = x->right;
             } else {
-                x = right(x);
+                x = x->left;
             }
         }
-        const_iterator j = const_iterator(y);
-        return (j == end() || key_compare(k, key(j.node))) ? end() : j;
-    }    
+        return r;
+    }
 
-    size_type count(const key_type& k) const
+    size_type index_of(const_iterator pos) const
     {
-        Pair<const_iterator, const_iterator> p = equal_range(k);
-        return distance(p.first, p.second);
+        if (pos.node == header)
+            return node_count;
+        base_ptr x = pos.node;
+        size_type r = rb_tree_node::size_of(x->left);
+        for (; x != root(); x = x->parent()) {
+            if (x == x->parent()->right)
+                r += rb_tree_node::size_of(x->parent()->left) + 1;
+        }
+        return r;
     }
 
-    iterator lower_bound(const key_type& k)
+    difference_type distance(const_iterator first, const_iterator last) const
     {
-        link_type y = header;
-        link_type x = root();
+        return difference_type(index_of(last)) - difference_type(index_of(first));
+    }
+
+public:
+    // interval queries; only usable with __rb_tree_interval_node. Writes an 
+    // iterator to every element whose interval meets [lo, hi], in order
+    template <typename Endpoint, typename OutputIterator>
+    OutputIterator overlapping(const Endpoint& lo, const Endpoint& hi, OutputIterator result)
+    {
+        return __overlapping<iterator>(root(), lo, hi, result);
+    }
+
+    template <typename Endpoint, typename OutputIterator>
+    OutputIterator overlapping(const Endpoint& lo, const Endpoint& hi, 
+                               OutputIterator result) const
+    {
+        return __overlapping<const_iterator>(root(), lo, hi, result);
+    }
+
+    // the first element whose interval meets [lo, hi], in O(log n)
+    template <typename Endpoint>
+    iterator find_overlapping(const Endpoint& lo, const Endpoint& hi)
+    {
+        return iterator((link_type)find_overlapping_node(lo, hi));
+    }
+
+    template <typename Endpoint>
+    const_iterator find_overlapping(const Endpoint& lo, const Endpoint& hi) const
+    {
+        return const_iterator((link_type)find_overlapping_node(lo, hi));
+    }
+
+private:
+    base_ptr nth_node(size_type k) const
+    {
+        base_ptr x = root();
         while (x != nullptr) {
-            if (!key_compare(key(x), k)) {
-                y = x;
-                x = left(x);
+            size_type l = rb_tree_node::size_of(x->left);
+            if (k < l) {
+                x = x->left;
+            } else if (k == l) {
+                return x;
             } else {
-                x = right(x);
+                k -= l + 1;
+                x = x->right;
             }
         }
-        return iterator(y);
+        return header;
     }
 
-    const_iterator lower_bound(const key_type& k) const
+    // skips subtrees that end before lo, and right parts that start after hi;
+    // a subtree entered for one result may hold no others, hence the 
+    // k log(n / k) term
+    template <typename Iter, typename Endpoint, typename OutputIterator>
+    static OutputIterator __overlapping(base_ptr x, const Endpoint& lo, const Endpoint& hi, 
+                                        OutputIterator result)
     {
-        link_type y = header;
-        link_type x = root();
+        while (x != nullptr && !rb_tree_node::before(rb_tree_node::max_high(x), lo)) {
+            result = __overlapping<Iter>(x->left, lo, hi, result);
+            if (rb_tree_node::before(hi, rb_tree_node::low(x)))
+                break;
+            if (!rb_tree_node::before(rb_tree_node::high(x), lo))
+                *result++ = Iter((link_type)x);
+            x = x->right;
+        }
+        return result;
+    }
+
+    // if the left subtree reaches lo but holds no overlap, nothing does:
+    // every interval there ending at or after lo starts after hi
+    template <typename Endpoint>
+    base_ptr find_overlapping_node(const Endpoint& lo, const Endpoint& hi) const
+    {
+        base_ptr x = root();
         while (x != nullptr) {
-            if (!key_compare(key(x), k)) {
-                y = x;
-                x = left(x);
-            } else {
-                x = right(x);
-            }
+            if (x->left != nullptr && !rb_tree_node::before(rb_tree_node::max_high(x->left), lo))
+                x = x->left;
+            else if (rb_tree_node::overlaps(x, lo, hi))
+                return x;
+            else if (rb_tree_node::before(hi, rb_tree_node::low(x)))
+                break;
+            else
+                x = x->right;
         }
-        return const_iterator(y);
+        return header;
     }
 
-    iterator upper_bound(const key_type& k)
+public:
+    // Result when Compare is transparent, otherwise no type; the wrappers 
+    // constrain their own heterogeneous lookups with it too
+    template <typename K, typename Result>
+    struct transparent_result : _enable_if<_is_transparent<Compare>::value, Result> 
+    { 
+    };
+
+    // heterogeneous lookup: only available when Compare is transparent, 
+    // so that no key_type has to be built
+    template <typename K>
+    typename transparent_result<K, iterator>::type find(const K& k)
+    {
+        return find_node(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type find(const K& k) const
+    {
+        return find_node(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, size_type>::type count(const K& k) const
+    {
+        return Zyx::distance(const_iterator(lower_bound_node(k)), 
+                             const_iterator(upper_bound_node(k)));
+    }
+
+    template <typename K>
+    typename transparent_result<K, iterator>::type lower_bound(const K& k)
+    {
+        return lower_bound_node(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type lower_bound(const K& k) const
+    {
+        return lower_bound_node(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, iterator>::type upper_bound(const K& k)
+    {
+        return upper_bound_node(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, const_iterator>::type upper_bound(const K& k) const
+    {
+        return upper_bound_node(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<iterator, iterator> >::type 
+    equal_range(const K& k)
+    {
+        return make_pair(iterator(lower_bound_node(k)), iterator(upper_bound_node(k)));
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<const_iterator, const_iterator> >::type 
+    equal_range(const K& k) const
+    {
+        return make_pair(const_iterator(lower_bound_node(k)), 
+                         const_iterator(upper_bound_node(k)));
+    }
+
+private:
+    template <typename K>
+    link_type find_node(const K& k) const
+    {
+        link_type j = lower_bound_node(k);
+        return (j == header || key_compare(k, key(j))) ? header : j;
+    }
+
+    template <typename K>
+    link_type lower_bound_node(const K& k) const
     {
         link_type y = header;
         link_type x = root();
         while (x != nullptr) {
-            if (key_compare(k, key(x))) {
+            if (!key_compare(key(x), k)) {
                 y = x;
                 x = left(x);
             } else {
                 x = right(x);
             }
         }
-        return iterator(y);
+        return y;
     }
 
-    const_iterator upper_bound(const key_type& k) const
+    template <typename K>
+    link_type upper_bound_node(const K& k) const
     {
         link_type y = header;
         link_type x = root();
@@ -415,24 +957,13 @@ public:
                 x = right(x);
             }
         }
-        return const_iterator(y);
-    }
-
-    Pair<iterator, iterator> equal_range(const key_type& k)
-    {
-        return make_pair(lower_bound(k), upper_bound(k));
-    }
-
-    Pair<const_iterator, const_iterator> equal_range(const key_type& k) const
-    {
-        return make_pair(lower_bound(k), upper_bound(k));
+        return y;
     }
 
 private:
     void empty_intialize()
     {
         header = get_node();
-        color(header) = __rb_tree_red;
         root() = nullptr;
         leftmost() = header;
         rightmost() = header;		
@@ -441,7 +972,7 @@ private:
     link_type __copy(link_type x, link_type p)
     {
         link_type top = clone_node(x);
-        top->parent = p;
+        top->set_parent(p);
         if (x->right)
             top->right = __copy(right(x), top);
         p = top;
@@ -450,18 +981,25 @@ private:
         while (x != nullptr) {
             link_type y = clone_node(x);
             p->left = y;
-            y->parent = p;
+            y->set_parent(p);
             if (x->right)
                 y->right = __copy(right(x), y);
             p = y;
             x = left(x);
         }
 
+        // right subtrees are done; fill in the left spine bottom-up
+        if (rb_tree_node::augmented) {
+            for (base_ptr y = p; y != top; y = y->parent())
+                rb_tree_node::augment(y);
+            rb_tree_node::augment(top);
+        }
+
         return top;
 
         // another way:
         // link_type top = clone_node(x);
-        // top->parent = p;
+        // top->set_parent(p);
         // if (x->left) 
         //     top->left = __copy(left(x), top);
         // if (x->right) 
@@ -469,14 +1007,227 @@ private:
         // return top;
     }
 
-    iterator __insert(base_ptr x_, base_ptr y_, const value_type& val)
+    template <typename InputIterator>
+    void __insert_range(InputIterator first, InputIterator last, bool unique, 
+                        input_iterator_tag)
+    {
+        for (; first != last; ++first) {
+            if (unique)
+                insert_unique(end(), *first);
+            else
+                insert_equal(end(), *first);
+        }
+    }
+
+    template <typename ForwardIterator>
+    void __insert_range(ForwardIterator first, ForwardIterator last, bool unique, 
+                        forward_iterator_tag)
+    {
+        size_type n = 0;
+        if (root() == nullptr && __sorted_count(first, last, unique, n))
+            __build_sorted(first, n, unique);
+        else
+            __insert_range(first, last, unique, input_iterator_tag());
+    }
+
+    // counts the elements to insert, or returns false if [first, last) is 
+    // not sorted; equal keys are counted once when unique
+    template <typename ForwardIterator>
+    bool __sorted_count(ForwardIterator first, ForwardIterator last, bool unique, 
+                        size_type& n)
+    {
+        n = 0;
+        if (first == last)
+            return true;
+        ForwardIterator prev = first;
+        for (n = 1; ++first != last; prev = first) {
+            if (key_compare(KeyOfValue()(*first), KeyOfValue()(*prev)))
+                return false;
+            if (!unique || key_compare(KeyOfValue()(*prev), KeyOfValue()(*first)))
+                ++n;
+        }
+        return true;
+    }
+
+    // every level but the deepest is complete: nodes there are colored red 
+    // and all others black, which keeps the black height equal on every path
+    template <typename ForwardIterator>
+    void __build_sorted(ForwardIterator first, size_type n, bool unique)
+    {
+        if (n == 0)
+            return;
+        int red_depth = 0;
+        while ((size_type(2) << red_depth) - 1 <= n)
+            ++red_depth;
+        link_type prev = nullptr;
+        root() = __build_subtree(first, n, 0, red_depth, unique, prev);
+        root()->set_parent(header);
+        leftmost() = minimum(root());
+        rightmost() = maximum(root());
+        node_count = n;
+    }
+
+    // shapes the n nodes of list, threaded in order through their left 
+    // links, like __build_subtree
+    base_ptr __relink_subtree(base_ptr& list, size_type n, int depth, int red_depth)
+    {
+        if (n == 0)
+            return nullptr;
+        const size_type half = (n - 1) / 2;
+        base_ptr l = __relink_subtree(list, half, depth + 1, red_depth);
+        base_ptr x = list;
+        list = x->left;
+        x->set_color(depth == red_depth ? __rb_tree_red : __rb_tree_black);
+        x->left = l;
+        if (l != nullptr)
+            l->set_parent(x);
+        x->right = __relink_subtree(list, n - 1 - half, depth + 1, red_depth);
+        if (x->right != nullptr)
+            x->right->set_parent(x);
+        rb_tree_node::augment(x);
+        return x;
+    }
+
+    // prev is the node built last; with unique keys the copies of its key 
+    // are skipped before the next node is taken from first
+    template <typename ForwardIterator>
+    link_type __build_subtree(ForwardIterator& first, size_type n, int depth, 
+                              int red_depth, bool unique, link_type& prev)
+    {
+        if (n == 0)
+            return nullptr;
+        const size_type half = (n - 1) / 2;
+        link_type l = __build_subtree(first, half, depth + 1, red_depth, unique, prev);
+        if (unique && prev != nullptr) {
+            while (!key_compare(key(prev), KeyOfValue()(*first)))
+                ++first;
+        }
+        link_type x = create_node(*first);
+        ++first;
+        prev = x;
+        x->set_color(depth == red_depth ? __rb_tree_red : __rb_tree_black);
+        x->left = l;
+        if (l != nullptr)
+            l->set_parent(x);
+        x->right = __build_subtree(first, n - 1 - half, depth + 1, red_depth, unique, prev);
+        if (x->right != nullptr)
+            x->right->set_parent(x);
+        rb_tree_node::augment(x);
+        return x;
+    }
+
+    // on success x and y are the arguments for __insert, otherwise y is the 
+    // node holding an equal key
+    bool __insert_unique_pos(const key_type& k, link_type& x, link_type& y)
+    {
+        y = header;
+        x = root();
+        bool comp = true;
+        while (x != nullptr) {
+            y = x;
+            comp = key_compare(k, key(x));
+            x = comp ? left(x) : right(x);
+        }
+
+        iterator j = iterator(y);
+        if (comp) {
+            if (j == begin())
+                return true;
+            else 
+                --j;
+        }
+
+        if (key_compare(key(j.node), k))
+            return true;
+
+        y = (link_type)j.node;
+        return false;
+    }
+
+    void __insert_equal_pos(const key_type& k, link_type& x, link_type& y)
+    {
+        y = header;
+        x = root();
+        while (x != nullptr) {
+            y = x;
+            x = key_compare(k, key(x)) ? left(x) : right(x);
+        }
+    }
+
+    // checks the slot between hint and its predecessor before falling back 
+    // to a search from the root
+    bool __insert_hint_unique_pos(base_ptr hint, const key_type& k, link_type& x, 
+                                  link_type& y)
+    {
+        if (hint == header) {
+            if (node_count > 0 && key_compare(key(rightmost()), k)) {
+                x = nullptr;
+                y = rightmost();
+                return true;
+            }
+        } else if (key_compare(k, key(hint))) {
+            if (hint == leftmost()) {
+                x = y = (link_type)hint;
+                return true;
+            }
+            iterator before = iterator((link_type)hint);
+            --before;
+            if (key_compare(key(before.node), k)) {
+                if (before.node->right == nullptr) {
+                    x = nullptr;
+                    y = (link_type)before.node;
+                } else {
+                    x = y = (link_type)hint;
+                }
+                return true;
+            }
+        } else if (!key_compare(key(hint), k)) {
+            y = (link_type)hint;
+            return false;
+        }
+        return __insert_unique_pos(k, x, y);
+    }
+
+    void __insert_hint_equal_pos(base_ptr hint, const key_type& k, link_type& x, 
+                                 link_type& y)
+    {
+        if (hint == header) {
+            if (node_count > 0 && !key_compare(k, key(rightmost()))) {
+                x = nullptr;
+                y = rightmost();
+                return;
+            }
+        } else if (!key_compare(key(hint), k)) {
+            if (hint == leftmost()) {
+                x = y = (link_type)hint;
+                return;
+            }
+            iterator before = iterator((link_type)hint);
+            --before;
+            if (!key_compare(k, key(before.node))) {
+                if (before.node->right == nullptr) {
+                    x = nullptr;
+                    y = (link_type)before.node;
+                } else {
+                    x = y = (link_type)hint;
+                }
+                return;
+            }
+        }
+        __insert_equal_pos(k, x, y);
+    }
+
+    iterator __insert(base_ptr x, base_ptr y, const value_type& val)
+    {
+        return __insert_node(x, y, create_node(val));
+    }
+
+    iterator __insert_node(base_ptr x_, base_ptr y_, link_type z)
     {
         link_type x = (link_type) x_;
         link_type y = (link_type) y_;    
-        link_type z;
 
-        if (y == header || x != nullptr || key_compare(KeyOfValue()(val), key(y))) {
-            z = create_node(val);
+        if (y == header || x != nullptr || key_compare(key(z), key(y))) {
             left(y) = z;
             if (y == header) {
                 root() = z;
@@ -485,23 +1236,23 @@ private:
                 leftmost() = z;
             }
         } else {
-            z = create_node(val);
             right(y) = z;
             if (y == rightmost()) 
                 rightmost() = z;
         }
         
-        parent(z) = y;
+        z->set_parent(y);
         left(z) = nullptr;
         right(z) = nullptr;
-        __rb_tree_rebalance(z, header->parent);
+        __augment_path(z);
+        __rb_tree_rebalance(z, header->tagged_parent);
         ++node_count;
         return iterator(z);
     }
 
     void __erase(link_type x)
     {
-        if (x != nullptr) {
+        while (x != nullptr) {
             __erase(right(x));
             link_type y = left(x);
             destroy_node(x);
@@ -510,22 +1261,365 @@ private:
     }
 
 private:
+    // refreshes the augmented data from x up to the root; detached 
+    // subtrees built by __join have no header above them
+    void __augment_path(base_ptr x)
+    {
+        if (rb_tree_node::augmented) {
+            for (; x != nullptr && x != header; x = x->parent())
+                rb_tree_node::augment(x);
+        }
+    }
+
+    // The set operations below work on detached subtrees: roots have a null 
+    // parent and may be red, and each carries its black height (the black 
+    // nodes on a path down from the root, the root included) so that joins 
+    // cost O(height difference). Nodes that leave the result are chained 
+    // through their left link into garbage and freed by __adopt, so 
+    // concurrent halves never touch the allocator.
+    enum { __PARALLEL_SET_THRESHOLD = 1 << 15 };
+    enum { __SPLIT_ERASE_THRESHOLD = 64 };
+
+    struct __subtree
+    {
+        base_ptr root;
+        int height;
+
+        __subtree(base_ptr r = nullptr, int h = 0) : root(r), height(h) { }
+    };
+
+    static __subtree __whole(base_ptr x)
+    {
+        int h = 0;
+        for (base_ptr y = x; y != nullptr; y = y->left) {
+            if (y->color() == __rb_tree_black)
+                ++h;
+        }
+        return __subtree(__detach(x), h);
+    }
+
+    static __subtree __left(const __subtree& t)
+    {
+        return __subtree(__detach(t.root->left), 
+                         t.height - (t.root->color() == __rb_tree_black ? 1 : 0));
+    }
+
+    static __subtree __right(const __subtree& t)
+    {
+        return __subtree(__detach(t.root->right), 
+                         t.height - (t.root->color() == __rb_tree_black ? 1 : 0));
+    }
+
+    static base_ptr __detach(base_ptr x)
+    {
+        if (x != nullptr)
+            x->set_parent(nullptr);
+        return x;
+    }
+
+    // joins l, the single node k and r, where every key in l precedes k and 
+    // every key in r follows it. k is hung on the spine of the taller tree 
+    // where the black heights match, then fixed up like an insert.
+    __subtree __join(__subtree l, base_ptr k, __subtree r)
+    {
+        if (l.root != nullptr && l.root->color() == __rb_tree_red) {
+            l.root->set_color(__rb_tree_black);
+            ++l.height;
+        }
+        if (r.root != nullptr && r.root->color() == __rb_tree_red) {
+            r.root->set_color(__rb_tree_black);
+            ++r.height;
+        }
+
+        if (l.height == r.height) {
+            k->left = l.root;
+            k->right = r.root;
+            k->set_parent(nullptr);
+            if (l.root != nullptr)
+                l.root->set_parent(k);
+            if (r.root != nullptr)
+                r.root->set_parent(k);
+            k->set_color(__rb_tree_black);
+            rb_tree_node::augment(k);
+            return __subtree(k, l.height + 1);
+        }
+
+        const bool left_taller = l.height > r.height;
+        __subtree& tall = left_taller ? l : r;
+        const int target = left_taller ? r.height : l.height;
+        base_ptr p = nullptr;
+        base_ptr c = tall.root;
+        for (int h = tall.height; h > target || (c != nullptr && c->color() == __rb_tree_red); ) {
+            if (c->color() == __rb_tree_black)
+                --h;
+            p = c;
+            c = left_taller ? c->right : c->left;
+        }
+
+        if (left_taller) {
+            k->left = c;
+            k->right = r.root;
+            p->right = k;
+        } else {
+            k->left = l.root;
+            k->right = c;
+            p->left = k;
+        }
+        k->set_parent(p);
+        if (k->left != nullptr)
+            k->left->set_parent(k);
+        if (k->right != nullptr)
+            k->right->set_parent(k);
+        __augment_path(k);
+        if (__rb_tree_rebalance(k, tall.root))
+            ++tall.height;
+        return tall;
+    }
+
+    // joins l and r without a middle node, by taking out the last node of l
+    __subtree __join2(const __subtree& l, const __subtree& r)
+    {
+        if (l.root == nullptr)
+            return r;
+        __subtree rest;
+        base_ptr last;
+        __split_last(l, rest, last);
+        return __join(rest, last, r);
+    }
+
+    void __split_last(const __subtree& t, __subtree& rest, base_ptr& last)
+    {
+        if (t.root->right == nullptr) {
+            rest = __left(t);
+            last = t.root;
+            return;
+        }
+        __subtree r_rest;
+        __split_last(__right(t), r_rest, last);
+        rest = __join(__left(t), t.root, r_rest);
+    }
+
+    // splits t into the keys less than k, the node equal to k if any, and 
+    // the keys greater than k
+    void __split(const __subtree& t, const key_type& k, __subtree& l, base_ptr& m, 
+                 __subtree& r)
+    {
+        if (t.root == nullptr) {
+            l = r = __subtree();
+            m = nullptr;
+            return;
+        }
+        __subtree tl = __left(t);
+        __subtree tr = __right(t);
+        if (key_compare(k, key(t.root))) {
+            __subtree rl;
+            __split(tl, k, l, m, rl);
+            r = __join(rl, t.root, tr);
+        } else if (key_compare(key(t.root), k)) {
+            __subtree lr;
+            __split(tr, k, lr, m, r);
+            l = __join(tl, t.root, lr);
+        } else {
+            l = tl;
+            m = t.root;
+            r = tr;
+            m->tagged_parent = m->left = m->right = nullptr;
+        }
+    }
+
+    // splits t into the nodes before x and the nodes from x on, by position, 
+    // so equal keys are no obstacle. went_left lists the turns from t's root 
+    // down to x.
+    void __split_before(const __subtree& t, base_ptr x, __subtree& l, __subtree& r)
+    {
+        bool went_left[2 * 8 * sizeof(size_type)];
+        int n = 0;
+        for (base_ptr y = x; y->parent() != nullptr; y = y->parent())
+            ++n;
+        int i = n;
+        for (base_ptr y = x; y->parent() != nullptr; y = y->parent())
+            went_left[--i] = y == y->parent()->left;
+        __split_path(t, went_left, n, l, r);
+    }
+
+    void __split_path(const __subtree& t, const bool* went_left, int n, 
+                      __subtree& l, __subtree& r)
+    {
+        __subtree tl = __left(t);
+        __subtree tr = __right(t);
+        if (n == 0) {
+            l = tl;
+            r = __join(__subtree(), t.root, tr);
+        } else if (*went_left) {
+            __subtree rl;
+            __split_path(tl, went_left + 1, n - 1, l, rl);
+            r = __join(rl, t.root, tr);
+        } else {
+            __subtree lr;
+            __split_path(tr, went_left + 1, n - 1, lr, r);
+            l = __join(tl, t.root, lr);
+        }
+    }
+
+    static void __discard(base_ptr x, link_type& garbage)
+    {
+        if (x != nullptr) {
+            __discard(x->left, garbage);
+            __discard(x->right, garbage);
+            x->left = garbage;
+            garbage = (link_type)x;
+        }
+    }
+
+    static void __splice_garbage(link_type& garbage, link_type other)
+    {
+        if (other != nullptr) {
+            link_type tail = other;
+            while (tail->left != nullptr)
+                tail = (link_type)tail->left;
+            tail->left = garbage;
+            garbage = other;
+        }
+    }
+
+    int __spawn_depth(const RedBlackTree& x, bool parallel) const
+    {
+        if (!parallel || node_count + x.node_count < __PARALLEL_SET_THRESHOLD)
+            return 0;
+        int depth = 0;
+        for (unsigned n = std::thread::hardware_concurrency(); n > 1; n >>= 1)
+            ++depth;
+        return depth;
+    }
+
+    typedef __subtree (RedBlackTree::*__set_op)(const __subtree&, const __subtree&, 
+                                                link_type&, int);
+
+    // runs l = op(l1, l2) and r = op(r1, r2), the first on a new thread while 
+    // depth allows it
+    void __recurse(__set_op op, const __subtree& l1, const __subtree& l2, 
+                   const __subtree& r1, const __subtree& r2, 
+                   __subtree& l, __subtree& r, link_type& garbage, int depth)
+    {
+        if (depth > 0 && l1.root != nullptr && l2.root != nullptr && 
+            r1.root != nullptr && r2.root != nullptr) {
+            link_type left_garbage = nullptr;
+            std::thread worker([&]() { l = (this->*op)(l1, l2, left_garbage, depth - 1); });
+            r = (this->*op)(r1, r2, garbage, depth - 1);
+            worker.join();
+            __splice_garbage(garbage, left_garbage);
+        } else {
+            l = (this->*op)(l1, l2, garbage, 0);
+            r = (this->*op)(r1, r2, garbage, 0);
+        }
+    }
+
+    __subtree __union(const __subtree& t1, const __subtree& t2, link_type& garbage, int depth)
+    {
+        if (t1.root == nullptr)
+            return t2;
+        if (t2.root == nullptr)
+            return t1;
+        __subtree l2, r2, l, r;
+        base_ptr m2;
+        __split(t2, key(t1.root), l2, m2, r2);
+        __discard(m2, garbage);
+        __recurse(&RedBlackTree::__union, __left(t1), l2, __right(t1), r2, l, r, garbage, depth);
+        return __join(l, t1.root, r);
+    }
+
+    __subtree __intersect(const __subtree& t1, const __subtree& t2, link_type& garbage, 
+                          int depth)
+    {
+        if (t1.root == nullptr || t2.root == nullptr) {
+            __discard(t1.root, garbage);
+            __discard(t2.root, garbage);
+            return __subtree();
+        }
+        __subtree l2, r2, l, r;
+        base_ptr m2;
+        __split(t2, key(t1.root), l2, m2, r2);
+        __recurse(&RedBlackTree::__intersect, __left(t1), l2, __right(t1), r2, l, r, 
+                  garbage, depth);
+        if (m2 != nullptr) {
+            __discard(m2, garbage);
+            return __join(l, t1.root, r);
+        }
+        t1.root->left = t1.root->right = nullptr;
+        __discard(t1.root, garbage);
+        return __join2(l, r);
+    }
+
+    __subtree __difference(const __subtree& t1, const __subtree& t2, link_type& garbage, 
+                           int depth)
+    {
+        if (t1.root == nullptr || t2.root == nullptr) {
+            __discard(t2.root, garbage);
+            return t1;
+        }
+        __subtree l1, r1, l, r;
+        base_ptr m1;
+        __split(t1, key(t2.root), l1, m1, r1);
+        __discard(m1, garbage);
+        __subtree l2 = __left(t2);
+        __subtree r2 = __right(t2);
+        t2.root->left = t2.root->right = nullptr;
+        __recurse(&RedBlackTree::__difference, l1, l2, r1, r2, l, r, garbage, depth);
+        __discard(t2.root, garbage);
+        return __join2(l, r);
+    }
+
+    // installs r as the tree, frees the garbage and empties x, whose nodes 
+    // now belong to r or the garbage
+    void __adopt(base_ptr r, size_type total, link_type garbage, RedBlackTree& x)
+    {
+        x.root() = nullptr;
+        x.leftmost() = x.header;
+        x.rightmost() = x.header;
+        x.node_count = 0;
+        __install(r, total, garbage);
+    }
+
+    // makes the detached subtree r the tree; total counts r and the garbage
+    void __install(base_ptr r, size_type total, link_type garbage)
+    {
+        while (garbage != nullptr) {
+            link_type next = (link_type)garbage->left;
+            destroy_node(garbage);
+            garbage = next;
+            --total;
+        }
+        root() = (link_type)r;
+        node_count = total;
+        if (r == nullptr) {
+            leftmost() = header;
+            rightmost() = header;
+        } else {
+            r->set_parent(header);
+            r->set_color(__rb_tree_black);
+            leftmost() = minimum(root());
+            rightmost() = maximum(root());
+        }
+    }
+
     void __rb_tree_rotate_left(base_ptr x, base_ptr& root)
     {
         base_ptr y = x->right;
         x->right = y->left;
         if (y->left != nullptr)
-            y->left->parent = x;
-        y->parent = x->parent;
+            y->left->set_parent(x);
+        y->set_parent(x->parent());
 
         if (x == root)
             root = y;
-        else if (x == x->parent->left)
-            x->parent->left = y;
+        else if (x == x->parent()->left)
+            x->parent()->left = y;
         else
-            x->parent->right = y;
+            x->parent()->right = y;
         y->left = x;
-        x->parent = y;
+        x->set_parent(y);
+        rb_tree_node::augment(x);
+        rb_tree_node::augment(y);
     }
 
     void __rb_tree_rotate_right(base_ptr x, base_ptr& root)
@@ -533,58 +1627,63 @@ private:
         base_ptr y = x->left;
         x->left = y->right;
         if (y->right != nullptr)
-            y->right->parent = x;
-        y->parent = x->parent;
+            y->right->set_parent(x);
+        y->set_parent(x->parent());
 
         if (x == root)
             root = y;
-        else if (x == x->parent->left)
-            x->parent->left = y;
+        else if (x == x->parent()->left)
+            x->parent()->left = y;
         else
-            x->parent->right = y;
+            x->parent()->right = y;
         y->right = x;
-        x->parent = y;
+        x->set_parent(y);
+        rb_tree_node::augment(x);
+        rb_tree_node::augment(y);
     }
 
-    void __rb_tree_rebalance(base_ptr x, base_ptr& root)
+    // returns true when the root had turned red, i.e. the black height grew
+    bool __rb_tree_rebalance(base_ptr x, base_ptr& root)
     {
-        x->color = __rb_tree_red;
-        while (x != root && x->parent->color == __rb_tree_red) {
-            if (x->parent == x->parent->parent->left) {
-                base_ptr y = x->parent->parent->right;
-                if (y != nullptr && y->color == __rb_tree_red) {
-                    x->parent->color = __rb_tree_black;
-                    y->color = __rb_tree_black;
-                    x->parent->parent->color = __rb_tree_red;
-                    x = x->parent->parent;
+        x->set_color(__rb_tree_red);
+        while (x != root && x->parent()->color() == __rb_tree_red) {
+            if (x->parent() == x->parent()->parent()->left) {
+                base_ptr y = x->parent()->parent()->right;
+                if (y != nullptr && y->color() == __rb_tree_red) {
+                    x->parent()->set_color(__rb_tree_black);
+                    y->set_color(__rb_tree_black);
+                    x->parent()->parent()->set_color(__rb_tree_red);
+                    x = x->parent()->parent();
                 } else {
-                    if (x == x->parent->right) {
-                        x = x->parent;
+                    if (x == x->parent()->right) {
+                        x = x->parent();
                         __rb_tree_rotate_left(x, root);
                     }
-                    x->parent->color = __rb_tree_black;
-                    x->parent->parent->color = __rb_tree_red;
-                    __rb_tree_rotate_right(x->parent->parent, root);
+                    x->parent()->set_color(__rb_tree_black);
+                    x->parent()->parent()->set_color(__rb_tree_red);
+                    __rb_tree_rotate_right(x->parent()->parent(), root);
                 }
             } else {
-                base_ptr y = x->parent->parent->left;
-                if (y != nullptr && y->color == __rb_tree_red) {
-                    x->parent->color = __rb_tree_black;
-                    y->color =  __rb_tree_black;
-                    x->parent->parent->color = __rb_tree_red;
-                    x = x->parent->parent;
+                base_ptr y = x->parent()->parent()->left;
+                if (y != nullptr && y->color() == __rb_tree_red) {
+                    x->parent()->set_color(__rb_tree_black);
+                    y->set_color(__rb_tree_black);
+                    x->parent()->parent()->set_color(__rb_tree_red);
+                    x = x->parent()->parent();
                 } else {
-                    if (x == x->parent->left) {
-                        x = x->parent;
+                    if (x == x->parent()->left) {
+                        x = x->parent();
                         __rb_tree_rotate_right(x, root);
                     }
-                    x->parent->color = __rb_tree_black;
-                    x->parent->parent->color = __rb_tree_red;
-                    __rb_tree_rotate_left(x->parent->parent, root);
+                    x->parent()->set_color(__rb_tree_black);
+                    x->parent()->parent()->set_color(__rb_tree_red);
+                    __rb_tree_rotate_left(x->parent()->parent(), root);
                 }
             }
         }
-        root->color = __rb_tree_black;
+        const bool grew = root->color() == __rb_tree_red;
+        root->set_color(__rb_tree_black);
+        return grew;
     }
 
     base_ptr __rb_tree_rebalance_for_erase(base_ptr z, base_ptr& root, 
@@ -608,130 +1707,202 @@ private:
         }
 
         if (y != z) {
-            z->left->parent = y;
+            z->left->set_parent(y);
             y->left = z->left;
             if (z->right != y) {
-                x_parent = y->parent;
-                if (x != nullptr) x->parent = x_parent;
+                x_parent = y->parent();
+                if (x != nullptr) x->set_parent(x_parent);
                 x_parent->left = x;
                 y->right = z->right;
-                z->right->parent = y;
+                z->right->set_parent(y);
             } else {
                 x_parent = y;
             }
 
             if (root == z) 
                 root = y;
-            else if (z->parent->left == z) 
-                z->parent->left = y;
+            else if (z->parent()->left == z) 
+                z->parent()->left = y;
             else
-                z->parent->right = y;
-            y->parent = z->parent;
-            Zyx::swap(y->color, z->color);
+                z->parent()->right = y;
+            y->set_parent(z->parent());
+            const color_type c = y->color();
+            y->set_color(z->color());
+            z->set_color(c);
             y = z;
         } else {
-            x_parent = y->parent;
-            if (x != nullptr) x->parent = y->parent;
+            x_parent = y->parent();
+            if (x != nullptr) x->set_parent(y->parent());
             if (root == z)
                 root = x;
-            else if (z->parent->left == z)
-                z->parent->left = x;
+            else if (z->parent()->left == z)
+                z->parent()->left = x;
             else
-                z->parent->right = x;
+                z->parent()->right = x;
 
             if (z == leftmost) {
                 if (z->right == nullptr)
-                    leftmost = z->parent;
+                    leftmost = z->parent();
                 else
                     leftmost = __rb_tree_node_base::minimum(x);
             }
 
             if (z == rightmost) {
                 if (z->left == nullptr)
-                    rightmost = z->parent;
+                    rightmost = z->parent();
                 else
                     rightmost = __rb_tree_node_base::maximum(x);
             }
         }
 
-        if (y->color != __rb_tree_red) {
-            while (x != root && (x == nullptr || x->color == __rb_tree_black)) {
+        __augment_path(x_parent);
+        if (y->color() != __rb_tree_red) {
+            while (x != root && (x == nullptr || x->color() == __rb_tree_black)) {
                 if (x == x_parent->left) {
                     base_ptr w = x_parent->right;
 
-                    if (w->color == __rb_tree_red) {
-                        w->color = __rb_tree_black;
-                        x_parent->color = __rb_tree_red;
+                    if (w->color() == __rb_tree_red) {
+                        w->set_color(__rb_tree_black);
+                        x_parent->set_color(__rb_tree_red);
                         __rb_tree_rotate_left(x_parent, root);
                         w = x_parent->right;
                     }
 
-                    if ((w->left == nullptr || w->left->color == __rb_tree_black) &&
-                        (w->right == nullptr || w->right->color == __rb_tree_black)) {
-                        w->color = __rb_tree_red;
+                    if ((w->left == nullptr || w->left->color() == __rb_tree_black) &&
+                        (w->right == nullptr || w->right->color() == __rb_tree_black)) {
+                        w->set_color(__rb_tree_red);
                         x = x_parent;
-                        x_parent = x_parent->parent;
+                        x_parent = x_parent->parent();
                     } else {
-                        if (w->right == nullptr || w->right->color == __rb_tree_black) {
+                        if (w->right == nullptr || w->right->color() == __rb_tree_black) {
                             if (w->left != nullptr) 
-                                w->left->color = __rb_tree_black;
-                            w->color = __rb_tree_red;
+                                w->left->set_color(__rb_tree_black);
+                            w->set_color(__rb_tree_red);
                             __rb_tree_rotate_right(w, root);
                             w = x_parent->right;
                         }
-                        w->color = x_parent->color;
-                        x_parent->color = __rb_tree_black;
+                        w->set_color(x_parent->color());
+                        x_parent->set_color(__rb_tree_black);
                         if (w->right != nullptr)
-                            w->right->color = __rb_tree_black;
+                            w->right->set_color(__rb_tree_black);
                         __rb_tree_rotate_left(x_parent, root);
                         break;
                     }
                 } else {
                     base_ptr w = x_parent->left;
 
-                    if (w->color == __rb_tree_red) {
-                        w->color = __rb_tree_black;
-                        x_parent->color = __rb_tree_red;
+                    if (w->color() == __rb_tree_red) {
+                        w->set_color(__rb_tree_black);
+                        x_parent->set_color(__rb_tree_red);
                         __rb_tree_rotate_right(x_parent, root);
                         w = x_parent->left;
                     }
 
-                    if ((w->right == nullptr || w->right->color == __rb_tree_black) &&
-                        (w->left == nullptr || w->left->color == __rb_tree_black)) {
-                        w->color = __rb_tree_red;
+                    if ((w->right == nullptr || w->right->color() == __rb_tree_black) &&
+                        (w->left == nullptr || w->left->color() == __rb_tree_black)) {
+                        w->set_color(__rb_tree_red);
                         x = x_parent;
-                        x_parent = x_parent->parent;
+                        x_parent = x_parent->parent();
                     } else {
-                        if (w->left == nullptr || w->left->color == __rb_tree_black) {
+                        if (w->left == nullptr || w->left->color() == __rb_tree_black) {
                             if (w->right != nullptr) 
-                                w->right->color = __rb_tree_black;
-                            w->color = __rb_tree_red;
+                                w->right->set_color(__rb_tree_black);
+                            w->set_color(__rb_tree_red);
                             __rb_tree_rotate_left(w, root);
                             w = x_parent->left;
                         }
-                        w->color = x_parent->color;
-                        x_parent->color = __rb_tree_black;
+                        w->set_color(x_parent->color());
+                        x_parent->set_color(__rb_tree_black);
                         if (w->left != nullptr)
-                            w->left->color = __rb_tree_black;
+                            w->left->set_color(__rb_tree_black);
                         __rb_tree_rotate_right(x_parent, root);
                         break;
                     }
                 }
             }
             if (x != nullptr)
-                x->color = __rb_tree_black;
+                x->set_color(__rb_tree_black);
         }
         return y;
     }
 
+public:
+    // checks the parent links, the element order, node_count, leftmost and 
+    // rightmost, and the red-black rules: the header and the children of 
+    // red nodes are red and black respectively, the root is black and every 
+    // path down has the same number of black nodes
+    bool __rb_verify() const
+    {
+        if (header->color() != __rb_tree_red || header->tagged_parent != root())
+            return false;
+        if (root() == nullptr)
+            return node_count == 0 && leftmost() == header && rightmost() == header;
+        if (root()->parent() != header || color(root()) != __rb_tree_black ||
+            __black_height(root()) < 0)
+            return false;
+        if (leftmost() != minimum(root()) || rightmost() != maximum(root()))
+            return false;
+        size_type n = 1;
+        for (const_iterator prev = begin(), it = ++begin(); it != end(); prev = it++, ++n) {
+            if (key_compare(key(it.node), key(prev.node)))
+                return false;
+        }
+        return n == node_count;
+    }
+
 private:
-    link_type get_node() { return rb_tree_node_allocator::allocate(); }
+    // the number of black nodes on every path down from x, or -1
+    static int __black_height(base_ptr x)
+    {
+        if (x == nullptr)
+            return 0;
+        if (x->left != nullptr && x->left->parent() != x)
+            return -1;
+        if (x->right != nullptr && x->right->parent() != x)
+            return -1;
+        if (x->color() == __rb_tree_red &&
+            ((x->left != nullptr && x->left->color() == __rb_tree_red) ||
+             (x->right != nullptr && x->right->color() == __rb_tree_red)))
+            return -1;
+        const int l = __black_height(x->left);
+        if (l < 0 || l != __black_height(x->right))
+            return -1;
+        return l + (x->color() == __rb_tree_black ? 1 : 0);
+    }
+
+private:
+    link_type get_node()
+    {
+        link_type p = rb_tree_node_allocator::allocate();
+        p->tagged_parent = nullptr;
+        return p;
+    }
     void put_node(link_type p) { rb_tree_node_allocator::deallocate(p); }
 
+    // both give the node back if the value's constructor throws
     link_type create_node(const value_type& x)
     {
         link_type p = get_node();
-        construct(&p->data, x);
+        try {
+            construct(&p->data, x);
+        } catch (...) {
+            put_node(p);
+            throw;
+        }
+        return p;
+    }
+
+    // value_type(k, arg) for map-like values
+    template <typename Arg>
+    link_type create_node(const key_type& k, Arg&& arg)
+    {
+        link_type p = get_node();
+        try {
+            new (&p->data) value_type(k, std::forward<Arg>(arg));
+        } catch (...) {
+            put_node(p);
+            throw;
+        }
         return p;
     }
 
@@ -744,30 +1915,30 @@ private:
     link_type clone_node(link_type x)
     {
         link_type tmp = create_node(x->data);
-        tmp->color = x->color;
+        tmp->set_color(x->color());
         tmp->left = nullptr;
         tmp->right = nullptr;
         return tmp;
     }
 
 private:
-    link_type& root() const { return (link_type&)header->parent; }
+    link_type& root() const { return (link_type&)header->tagged_parent; }
     link_type& leftmost() const { return (link_type&)header->left; }
     link_type& rightmost() const { return (link_type&)header->right; }
 
     static link_type& left(link_type x) { return (link_type&)x->left; }
     static link_type& right(link_type x) { return (link_type&)x->right; }
-    static link_type& parent(link_type x) { return (link_type&)x->parent; }
+    static link_type parent(link_type x) { return (link_type)x->parent(); }
     static reference value(link_type x) { return x->data; }
     static const key_type& key(link_type x) { return KeyOfValue()(value(x)); } //????
-    static color_type& color(link_type x) { return (color_type&)x->color; }
+    static color_type color(link_type x) { return x->color(); }
 
     static link_type& left(base_ptr x) { return (link_type&)x->left; }
     static link_type& right(base_ptr x) { return (link_type&)x->right; }
-    static link_type& parent(base_ptr x) { return (link_type&)x->parent; }
+    static link_type parent(base_ptr x) { return (link_type)x->parent(); }
     static reference value(base_ptr x) { return ((link_type)x)->data; }
     static const key_type& key(base_ptr x) { return KeyOfValue()(value(x)); } //????
-    static color_type& color(base_ptr x) { return (color_type&)x->color; }
+    static color_type color(base_ptr x) { return x->color(); }
 
     static link_type minimum(link_type x) { return (link_type)__rb_tree_node_base::minimum(x); }
     static link_type maximum(link_type x) { return (link_type)__rb_tree_node_base::maximum(x); }
@@ -778,51 +1949,58 @@ private:
     Compare key_compare;
 };
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator==(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                       const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& rhs)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, typename Node>
+inline bool operator==(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& lhs,
+                       const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& rhs)
 {
     return lhs.size() == rhs.size() && equal(lhs.begin(), lhs.end(), rhs.begin()); 
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator!=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                       const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& rhs)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, typename Node>
+inline bool operator!=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& lhs,
+                       const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& rhs)
 {
     return !(lhs == rhs);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator<(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& rhs)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, typename Node>
+inline bool operator<(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& lhs,
+                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& rhs)
 {
     return lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());  
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator>(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& rhs)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, typename Node>
+inline bool operator>(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& lhs,
+                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& rhs)
 {
     return rhs < lhs; 
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator<=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& rhs)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, typename Node>
+inline bool operator<=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& lhs,
+                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& rhs)
 {
     return !(rhs < lhs); 
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline bool operator>=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& lhs,
-                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& rhs)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, typename Node>
+inline bool operator>=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& lhs,
+                      const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& rhs)
 {
     return !(lhs < rhs);
 }
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-inline void swap(RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& x,
-                 RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>& y)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, 
+          typename Alloc, typename Node>
+inline void swap(RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& x,
+                 RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, Node>& y)
 {
     x.swap(y);
 }
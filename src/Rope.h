@@ -0,0 +1,478 @@
+#ifndef ZYX_ROPE
+#define ZYX_ROPE
+
+#include <cstring>
+#include "Alloc.h"
+#include "Algorithm.h"
+#include "Iterator.h"
+#include "Utility.h"
+#include "StringView.h"
+#include "String.h"
+
+namespace Zyx {
+
+// Internal nodes concatenate their two children; leaves have no children
+// and keep their characters right after the node, in a block of fixed
+// size. length counts the characters below a node and a leaf's height is 1.
+struct __rope_node
+{
+    __rope_node* left;
+    __rope_node* right;
+    size_t length;
+    int height;
+
+    bool is_leaf() const { return left == nullptr; }
+    char* chars() { return reinterpret_cast<char*>(this + 1); }
+    const char* chars() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+// visits the leaves in order with an explicit stack: the top is the
+// current leaf, the rest are internal nodes whose right part is still to
+// come, and end() is empty
+struct __rope_chunk_iterator
+{
+    typedef __rope_chunk_iterator    self;
+    typedef const __rope_node*       node_ptr;
+
+    typedef forward_iterator_tag    iterator_category;
+    typedef StringView              value_type;
+    typedef const StringView*       pointer;
+    typedef StringView              reference;
+    typedef ptrdiff_t               difference_type;
+
+    // an AVL tree of 2^64 leaves is less than 93 levels high
+    enum { __MAX_DEPTH = 96 };
+
+    node_ptr stack[__MAX_DEPTH];
+    int depth;
+
+    __rope_chunk_iterator() : depth(0) { }
+
+    bool operator==(const self& x) const
+    {
+        return depth == x.depth && (depth == 0 || stack[depth - 1] == x.stack[depth - 1]);
+    }
+
+    bool operator!=(const self& x) const { return !(*this == x); }
+
+    reference operator*() const
+    {
+        return StringView(stack[depth - 1]->chars(), stack[depth - 1]->length);
+    }
+
+    void push_left(node_ptr x)
+    {
+        if (x == nullptr)
+            return;
+        for (; !x->is_leaf(); x = x->left)
+            stack[depth++] = x;
+        stack[depth++] = x;
+    }
+
+    self& operator++()
+    {
+        --depth;
+        if (depth > 0)
+            push_left(stack[--depth]->right);
+        return *this;
+    }
+
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+};
+
+//---------------------------------------【Rope class】---------------------------------------
+
+// A string kept as a height-balanced tree of chunks, for large texts that
+// are edited in the middle. insert, erase and concatenation take O(log n)
+// plus the characters written, where String moves the whole tail; random
+// access takes O(log n). Edits that fit in the chunk they land in are done
+// in place, anything else splits the tree at the edit and joins the pieces
+// back. The chunks can be walked in order without copying, for example to
+// fill an iovec array, and flatten() builds a String when one is needed.
+class Rope
+{
+public:
+    typedef char                      value_type;
+    typedef size_t                    size_type;
+    typedef ptrdiff_t                 difference_type;
+    typedef __rope_chunk_iterator     chunk_iterator;
+
+private:
+    typedef __rope_node    node;
+
+    // every leaf is one block of __LEAF_BYTES holding up to __CHUNK_SIZE
+    // characters
+    enum { __LEAF_BYTES = 512 };
+    enum { __CHUNK_SIZE = __LEAF_BYTES - sizeof(__rope_node) };
+
+public:
+    static const size_type npos = static_cast<size_type>(-1);
+
+public:
+    Rope() : root(nullptr) { }
+    explicit Rope(const char* s) : root(build(s, strlen(s))) { }
+    Rope(const char* s, size_type n) : root(build(s, n)) { }
+    explicit Rope(StringView v) : root(build(v.data(), v.size())) { }
+    Rope(const Rope& x) : root(copy_node(x.root)) { }
+    Rope(Rope&& x) : root(x.root) { x.root = nullptr; }
+
+    Rope& operator=(Rope x)
+    {
+        swap(x);
+        return *this;
+    }
+
+    ~Rope() { destroy_node(root); }
+
+public:
+    size_type size() const { return root == nullptr ? 0 : root->length; }
+    size_type length() const { return size(); }
+    bool empty() const { return root == nullptr; }
+
+    char operator[](size_type pos) const
+    {
+        const node* x = root;
+        while (!x->is_leaf()) {
+            if (pos < x->left->length) {
+                x = x->left;
+            } else {
+                pos -= x->left->length;
+                x = x->right;
+            }
+        }
+        return x->chars()[pos];
+    }
+
+    chunk_iterator chunk_begin() const
+    {
+        chunk_iterator it;
+        it.push_left(root);
+        return it;
+    }
+
+    chunk_iterator chunk_end() const { return chunk_iterator(); }
+
+    template <typename Function>
+    Function for_each_chunk(Function f) const
+    {
+        for (chunk_iterator it = chunk_begin(); it != chunk_end(); ++it)
+            f(*it);
+        return f;
+    }
+
+    String flatten() const
+    {
+        String result(size());
+        for (chunk_iterator it = chunk_begin(); it != chunk_end(); ++it)
+            result.append(*it);
+        return result;
+    }
+
+    // copies of the characters in [pos, pos + n)
+    Rope substr(size_type pos = 0, size_type n = npos) const
+    {
+        Rope result;
+        copy_range(root, pos, min(n, size() - pos), result);
+        return result;
+    }
+
+public:
+    Rope& insert(size_type pos, StringView v)
+    {
+        if (v.empty())
+            return *this;
+        if (!insert_in_leaf(pos, v)) {
+            node* l;
+            node* r;
+            split(root, pos, l, r);
+            root = join(join(l, build(v.data(), v.size())), r);
+        }
+        return *this;
+    }
+
+    // moves the contents of x into this rope at pos, leaving x empty
+    Rope& insert(size_type pos, Rope&& x)
+    {
+        node* l;
+        node* r;
+        split(root, pos, l, r);
+        root = join(join(l, x.root), r);
+        x.root = nullptr;
+        return *this;
+    }
+
+    Rope& insert(size_type pos, const Rope& x) { return insert(pos, Rope(x)); }
+
+    Rope& append(StringView v) { return insert(size(), v); }
+    Rope& append(Rope&& x) { return insert(size(), static_cast<Rope&&>(x)); }
+    Rope& append(const Rope& x) { return insert(size(), Rope(x)); }
+
+    Rope& operator+=(StringView v) { return append(v); }
+    Rope& operator+=(const Rope& x) { return append(x); }
+    Rope& operator+=(Rope&& x) { return append(static_cast<Rope&&>(x)); }
+
+    void push_back(char c) { append(StringView(&c, 1)); }
+
+    Rope& erase(size_type pos = 0, size_type n = npos)
+    {
+        n = min(n, size() - pos);
+        if (n == 0 || erase_in_leaf(pos, n))
+            return *this;
+        node* l;
+        node* m;
+        node* r;
+        split(root, pos, l, r);
+        split(r, n, m, r);
+        destroy_node(m);
+        root = join(l, r);
+        return *this;
+    }
+
+    void clear()
+    {
+        destroy_node(root);
+        root = nullptr;
+    }
+
+    void swap(Rope& x) { Zyx::swap(root, x.root); }
+
+private:
+    static node* create_leaf(const char* s, size_type n)
+    {
+        node* x = static_cast<node*>(alloc::allocate(__LEAF_BYTES));
+        x->left = nullptr;
+        x->right = nullptr;
+        x->length = n;
+        x->height = 1;
+        memcpy(x->chars(), s, n);
+        return x;
+    }
+
+    static node* create_internal(node* l, node* r)
+    {
+        node* x = static_cast<node*>(alloc::allocate(sizeof(node)));
+        x->left = l;
+        x->right = r;
+        update(x);
+        return x;
+    }
+
+    static void free_node(node* x)
+    {
+        alloc::deallocate(x, x->is_leaf() ? static_cast<size_type>(__LEAF_BYTES) : sizeof(node));
+    }
+
+    static void destroy_node(node* x)
+    {
+        while (x != nullptr) {
+            node* right = x->right;
+            destroy_node(x->left);
+            free_node(x);
+            x = right;
+        }
+    }
+
+    static node* copy_node(const node* x)
+    {
+        if (x == nullptr)
+            return nullptr;
+        if (x->is_leaf())
+            return create_leaf(x->chars(), x->length);
+        node* l = copy_node(x->left);
+        return create_internal(l, copy_node(x->right));
+    }
+
+    static void update(node* x)
+    {
+        x->length = x->left->length + x->right->length;
+        x->height = 1 + max(x->left->height, x->right->height);
+    }
+
+    // a perfectly balanced tree of full chunks, the last one partial
+    static node* build(const char* s, size_type n)
+    {
+        if (n == 0)
+            return nullptr;
+        if (n <= __CHUNK_SIZE)
+            return create_leaf(s, n);
+        const size_type chunks = (n + __CHUNK_SIZE - 1) / __CHUNK_SIZE;
+        const size_type half = chunks / 2 * __CHUNK_SIZE;
+        node* l = build(s, half);
+        return create_internal(l, build(s + half, n - half));
+    }
+
+    static node* rotate_left(node* x)
+    {
+        node* y = x->right;
+        x->right = y->left;
+        update(x);
+        y->left = x;
+        update(y);
+        return y;
+    }
+
+    static node* rotate_right(node* x)
+    {
+        node* y = x->left;
+        x->left = y->right;
+        update(x);
+        y->right = x;
+        update(y);
+        return y;
+    }
+
+    // restores the AVL condition at x when its children differ by two
+    static node* rebalance(node* x)
+    {
+        update(x);
+        if (x->left->height > x->right->height + 1) {
+            if (x->left->left->height < x->left->right->height)
+                x->left = rotate_left(x->left);
+            return rotate_right(x);
+        }
+        if (x->right->height > x->left->height + 1) {
+            if (x->right->right->height < x->right->left->height)
+                x->right = rotate_right(x->right);
+            return rotate_left(x);
+        }
+        return x;
+    }
+
+    // the concatenation of l and r, taking over both; the shorter tree is
+    // hung where the taller one has a subtree of about its height, so the
+    // cost is the difference of the heights
+    static node* join(node* l, node* r)
+    {
+        if (l == nullptr)
+            return r;
+        if (r == nullptr)
+            return l;
+        if (l->is_leaf() && r->is_leaf() && l->length + r->length <= __CHUNK_SIZE) {
+            memcpy(l->chars() + l->length, r->chars(), r->length);
+            l->length += r->length;
+            free_node(r);
+            return l;
+        }
+        if (l->height > r->height + 1) {
+            l->right = join(l->right, r);
+            return rebalance(l);
+        }
+        if (r->height > l->height + 1) {
+            r->left = join(l, r->left);
+            return rebalance(r);
+        }
+        return create_internal(l, r);
+    }
+
+    // splits x into its first pos characters and the rest, taking it over
+    static void split(node* x, size_type pos, node*& l, node*& r)
+    {
+        if (x == nullptr || pos == 0) {
+            l = nullptr;
+            r = x;
+        } else if (pos >= x->length) {
+            l = x;
+            r = nullptr;
+        } else if (x->is_leaf()) {
+            r = create_leaf(x->chars() + pos, x->length - pos);
+            x->length = pos;
+            l = x;
+        } else {
+            node* a = x->left;
+            node* b = x->right;
+            free_node(x);
+            node* m;
+            if (pos < a->length) {
+                split(a, pos, l, m);
+                r = join(m, b);
+            } else {
+                split(b, pos - a->length, m, r);
+                l = join(a, m);
+            }
+        }
+    }
+
+    // the leaf holding position pos, or ending at it, with pos made relative
+    // to the leaf; when add is non-zero the lengths on the way are raised by it
+    node* find_leaf(size_type& pos, difference_type add)
+    {
+        node* x = root;
+        for (;;) {
+            x->length += add;
+            if (x->is_leaf())
+                return x;
+            if (pos <= x->left->length) {
+                x = x->left;
+            } else {
+                pos -= x->left->length;
+                x = x->right;
+            }
+        }
+    }
+
+    bool insert_in_leaf(size_type pos, StringView v)
+    {
+        if (root == nullptr)
+            return false;
+        size_type offset = pos;
+        node* leaf = find_leaf(offset, 0);
+        if (leaf->length + v.size() > __CHUNK_SIZE)
+            return false;
+        offset = pos;
+        find_leaf(offset, v.size());
+        char* p = leaf->chars() + offset;
+        memmove(p + v.size(), p, leaf->length - v.size() - offset);
+        memcpy(p, v.data(), v.size());
+        return true;
+    }
+
+    // only when [pos, pos + n) lies inside one leaf and does not empty it
+    bool erase_in_leaf(size_type pos, size_type n)
+    {
+        size_type offset = pos + 1;
+        const node* leaf = find_leaf(offset, 0);
+        --offset;
+        if (n >= leaf->length || offset + n > leaf->length)
+            return false;
+        offset = pos + 1;
+        node* x = find_leaf(offset, -static_cast<difference_type>(n));
+        --offset;
+        char* p = x->chars() + offset;
+        memmove(p, p + n, x->length - offset);
+        return true;
+    }
+
+    static void copy_range(const node* x, size_type pos, size_type n, Rope& out)
+    {
+        if (n == 0)
+            return;
+        if (x->is_leaf()) {
+            out.append(StringView(x->chars() + pos, n));
+        } else if (pos + n <= x->left->length) {
+            copy_range(x->left, pos, n, out);
+        } else if (pos >= x->left->length) {
+            copy_range(x->right, pos - x->left->length, n, out);
+        } else {
+            const size_type k = x->left->length - pos;
+            copy_range(x->left, pos, k, out);
+            copy_range(x->right, 0, n - k, out);
+        }
+    }
+
+private:
+    node* root;
+};
+
+inline void swap(Rope& lhs, Rope& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
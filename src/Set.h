@@ -1,6 +1,7 @@
 #ifndef ZYX_SET
 #define ZYX_SET 
 
+#include <utility>
 #include "RedBlackTree.h"
 #include "Functional.h"
 
@@ -35,6 +36,7 @@ public:
     typedef typename rep_type::const_iterator     const_iterator;
     typedef typename rep_type::size_type          size_type;
     typedef typename rep_type::difference_type    difference_type;
+    typedef typename rep_type::node_type          node_type;
 
 public:
     Set() : t(Compare()) { }
@@ -78,12 +80,27 @@ public:
         return Pair<iterator, bool>(p.first, p.second);
     }
 
+    iterator insert(iterator hint, const value_type& val)
+    {
+        return t.insert_unique(hint, val);
+    }
+
     template <typename InputIterator>
     void insert(InputIterator first, InputIterator last)
     {
         t.insert_unique(first, last);
     }
 
+    Pair<iterator, bool> insert(node_type&& nh)
+    {
+        Pair<typename rep_type::iterator, bool> p = t.insert_unique(std::move(nh));
+        return Pair<iterator, bool>(p.first, p.second);
+    }
+
+    node_type extract(const_iterator pos) { return t.extract(pos); }
+    node_type extract(const key_type& k) { return t.extract(k); }
+    void merge(Set& x) { t.merge_unique(x.t); }
+
     void erase(iterator pos)
     {
         typedef typename rep_type::iterator rep_iterator;
@@ -98,6 +115,22 @@ public:
 
     size_type erase(const key_type& k) { return t.erase(k); }
 
+    template <typename Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+
+    // full scan with prefetching
+    template <typename Function>
+    Function for_each(Function f) const { return t.for_each(f); }
+
+    // set algebra on keys in O(m log(n / m + 1)); the rvalue forms take over 
+    // x's nodes and leave it empty, and equal keys keep the element of *this
+    void union_with(Set&& x, bool parallel = false) { t.union_with(std::move(x.t), parallel); }
+    void union_with(const Set& x, bool parallel = false) { t.union_with(x.t, parallel); }
+    void intersect_with(Set&& x, bool parallel = false) { t.intersect_with(std::move(x.t), parallel); }
+    void intersect_with(const Set& x, bool parallel = false) { t.intersect_with(x.t, parallel); }
+    void difference_with(Set&& x, bool parallel = false) { t.difference_with(std::move(x.t), parallel); }
+    void difference_with(const Set& x, bool parallel = false) { t.difference_with(x.t, parallel); }
+
     void clear() { t.clear(); }
     void swap(Set& x) { t.swap(x.t); }
 
@@ -112,6 +145,43 @@ public:
         return t.equal_range(val); 
     }
 
+private:
+    template <typename K, typename Result>
+    struct transparent_result : rep_type::template transparent_result<K, Result> { };
+
+public:
+    // lookups with any key type accepted by a transparent Compare
+    template <typename K>
+    typename transparent_result<K, iterator>::type find(const K& k) const
+    {
+        return t.find(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, size_type>::type count(const K& k) const
+    {
+        return t.count(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, iterator>::type lower_bound(const K& k) const
+    {
+        return t.lower_bound(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, iterator>::type upper_bound(const K& k) const
+    {
+        return t.upper_bound(k);
+    }
+
+    template <typename K>
+    typename transparent_result<K, Pair<iterator, iterator> >::type 
+    equal_range(const K& k) const
+    {
+        return t.equal_range(k);
+    }
+
 private:
     rep_type t;
 };
@@ -0,0 +1,221 @@
+#ifndef ZYX_SHARED_STRING
+#define ZYX_SHARED_STRING
+
+#include <atomic>
+#include <new>
+#include <cstring>
+#include "Alloc.h"
+#include "Utility.h"
+#include "HashFun.h"
+#include "Functional.h"
+#include "StringView.h"
+#include "String.h"
+
+namespace Zyx {
+
+// the buffer header; the characters follow it in the same block
+struct __shared_string_rep
+{
+    std::atomic<size_t> refs;
+    size_t capacity;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+// An immutable string whose characters live in a reference-counted buffer.
+// Copying takes O(1) and shares the buffer, and substr returns a slice of
+// the same buffer, so one large payload can be handed to many consumers
+// without duplicating it. The count is atomic: copies may be made and
+// dropped on different threads. The buffer is freed with malloc_alloc,
+// which is safe to call from whichever thread drops the last reference.
+//
+// A slice is not null-terminated, so there is no c_str(); convert to
+// StringView to search or compare, or to String for a mutable copy.
+class SharedString
+{
+public:
+    typedef char           value_type;
+    typedef const char&    reference;
+    typedef const char&    const_reference;
+    typedef const char*    pointer;
+    typedef const char*    const_pointer;
+    typedef const char*    iterator;
+    typedef const char*    const_iterator;
+    typedef size_t         size_type;
+    typedef ptrdiff_t      difference_type;
+
+    typedef reverse_iterator<const_iterator>    const_reverse_iterator;
+    typedef const_reverse_iterator              reverse_iterator;
+
+private:
+    typedef __shared_string_rep    rep_type;
+
+public:
+    static const size_type npos = static_cast<size_type>(-1);
+
+public:
+    SharedString() : rep(nullptr), ptr(nullptr), len(0) { }
+    SharedString(const char* s) { initialize(s, strlen(s)); }
+    SharedString(const char* s, size_type n) { initialize(s, n); }
+    explicit SharedString(StringView v) { initialize(v.data(), v.size()); }
+    explicit SharedString(const String& s) { initialize(s.data(), s.size()); }
+
+    SharedString(const SharedString& s) : rep(retain(s.rep)), ptr(s.ptr), len(s.len) { }
+
+    SharedString(SharedString&& s) : rep(s.rep), ptr(s.ptr), len(s.len)
+    {
+        s.rep = nullptr;
+        s.ptr = nullptr;
+        s.len = 0;
+    }
+
+    SharedString& operator=(SharedString s)
+    {
+        swap(s);
+        return *this;
+    }
+
+    ~SharedString() { release(rep); }
+
+public:
+    const_iterator begin() const { return ptr; }
+    const_iterator end() const { return ptr + len; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    const_reference operator[](size_type n) const { return ptr[n]; }
+    const_reference front() const { return ptr[0]; }
+    const_reference back() const { return ptr[len - 1]; }
+    const char* data() const { return ptr; }
+
+    size_type size() const { return len; }
+    size_type length() const { return len; }
+    bool empty() const { return len == 0; }
+
+    operator StringView() const { return StringView(ptr, len); }
+
+    // strings sharing this buffer, this one included; 0 when empty
+    size_type use_count() const
+    {
+        return rep == nullptr ? 0 : rep->refs.load(std::memory_order_relaxed);
+    }
+
+    // a slice that shares this buffer
+    SharedString substr(size_type pos = 0, size_type n = npos) const
+    {
+        return SharedString(rep, ptr + pos, min(n, len - pos));
+    }
+
+    void swap(SharedString& s)
+    {
+        Zyx::swap(rep, s.rep);
+        Zyx::swap(ptr, s.ptr);
+        Zyx::swap(len, s.len);
+    }
+
+public:
+    size_type find(StringView v, size_type pos = 0) const
+    {
+        return StringView(*this).find(v, pos);
+    }
+
+    size_type find(char c, size_type pos = 0) const { return StringView(*this).find(c, pos); }
+
+    size_type rfind(StringView v, size_type pos = npos) const
+    {
+        return StringView(*this).rfind(v, pos);
+    }
+
+    size_type rfind(char c, size_type pos = npos) const
+    {
+        return StringView(*this).rfind(c, pos);
+    }
+
+    int compare(StringView v) const { return StringView(*this).compare(v); }
+
+private:
+    SharedString(rep_type* r, const char* p, size_type n) : rep(retain(r)), ptr(p), len(n) { }
+
+    // empty strings share nothing
+    void initialize(const char* s, size_type n)
+    {
+        if (n == 0) {
+            rep = nullptr;
+            ptr = nullptr;
+        } else {
+            rep = static_cast<rep_type*>(malloc_alloc::allocate(sizeof(rep_type) + n));
+            new (&rep->refs) std::atomic<size_t>(1);
+            rep->capacity = n;
+            memcpy(rep->data(), s, n);
+            ptr = rep->data();
+        }
+        len = n;
+    }
+
+    static rep_type* retain(rep_type* r)
+    {
+        if (r != nullptr)
+            r->refs.fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+
+    static void release(rep_type* r)
+    {
+        if (r != nullptr && r->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            const size_type n = sizeof(rep_type) + r->capacity;
+            r->refs.~atomic();
+            malloc_alloc::deallocate(r, n);
+        }
+    }
+
+private:
+    rep_type* rep;
+    const char* ptr;
+    size_type len;
+};
+
+inline void swap(SharedString& lhs, SharedString& rhs)
+{
+    lhs.swap(rhs);
+}
+
+// comparisons are the StringView operators; hashing and equality are
+// transparent, as for String
+template <>
+struct hash<SharedString>
+{
+    typedef void is_transparent;
+    size_t operator()(StringView v) const { return hash_string(v.data(), v.size()); }
+};
+
+template <>
+struct equal_to<SharedString>
+{
+    typedef SharedString first_argument_type;
+    typedef SharedString second_argument_type;
+    typedef bool result_type;
+    typedef void is_transparent;
+
+    bool operator()(StringView x, StringView y) const { return x == y; }
+};
+
+template <>
+struct less<SharedString>
+{
+    typedef SharedString first_argument_type;
+    typedef SharedString second_argument_type;
+    typedef bool result_type;
+    typedef void is_transparent;
+
+    bool operator()(StringView x, StringView y) const { return x < y; }
+};
+
+template <>
+struct cache_hash_code<hash<SharedString> >
+{
+    typedef _true_type type;
+};
+
+}
+
+#endif
@@ -8,9 +8,18 @@
 #include "Construct.h"
 #include "Algorithm.h"
 #include "Utility.h"
+#include "HashFun.h"
+#include "Functional.h"
+#include "StringView.h"
+#include "CharConv.h"
 
 namespace Zyx {
 
+// Strings of up to __LOCAL_CAPACITY characters live inside the object, in 
+// the space the heap representation uses for its finish and end pointers, 
+// so short and empty strings never allocate. start always points at the 
+// characters. In local form the last byte of the buffer holds the number of 
+// unused characters, which turns into the terminator when the buffer is full.
 class String
 {
 public:
@@ -30,54 +39,38 @@ public:
 private:
     typedef simple_alloc<value_type, alloc> data_allocator;
 
+    enum { __LOCAL_CAPACITY = 2 * sizeof(char*) - 1 };
+
 public:
     static const size_type npos = static_cast<size_type>(-1);
 
 public:
-    String() : start(nullptr), finish(nullptr), end_of_storage(nullptr) 
-    {
-        allocate_block(8);
-        terminate_string();
-    }
+    String() { local_initialize(); }
 
-    String(size_type n) : start(nullptr), finish(nullptr), end_of_storage(nullptr) 
+    // an empty string with room for n characters
+    String(size_type n)
     {
-        allocate_block(n + 1);
-        terminate_string();
+        allocate_block(n);
+        terminate_string(start);
     }
 
-    String(const String& s) : start(nullptr), finish(nullptr), end_of_storage(nullptr)
-    {
-        range_initialize(s.begin(), s.end());
-    }
+    String(const String& s) { range_initialize(s.begin(), s.end()); }
 
     String(const String& s, size_type pos, size_type len = npos)
-      : start(nullptr), finish(nullptr), end_of_storage(nullptr)
     {
         range_initialize(s.begin() + pos, s.begin() + pos + min(len, s.size() - pos));
     }
 
-    String(const char* s) : start(nullptr), finish(nullptr), end_of_storage(nullptr)
-    {
-        range_initialize(s, s + strlen(s));
-    }
+    String(const char* s) { range_initialize(s, s + strlen(s)); }
 
-    String(const char* s, size_type n) 
-      : start(nullptr), finish(nullptr), end_of_storage(nullptr)
-    {
-        range_initialize(s, s + n);
-    }
+    String(const char* s, size_type n) { range_initialize(s, s + n); }
 
-    String(size_type n, char c) : start(nullptr), finish(nullptr), end_of_storage(nullptr)
-    {
-        allocate_block(n + 1);
-        finish = uninitialized_fill_n(start, n, c);
-        terminate_string();
-    }
+    explicit String(StringView v) { range_initialize(v.begin(), v.end()); }
+
+    String(size_type n, char c) { fill_initialize(n, c); }
 
     template <typename InputIterator>
     String(InputIterator first, InputIterator last)
-      : start(nullptr), finish(nullptr), end_of_storage(nullptr)
     {
         typedef typename _is_integer<InputIterator>::integral integral;
         initialize_dispatch(first, last, integral());
@@ -94,17 +87,15 @@ public:
 
     String& operator=(char c) { return assign(static_cast<size_type>(1), c); }
 
-    ~String() 
-    {
-        destroy(start, finish + 1);
-        deallocate_block(); 
-    }
+    String& operator=(StringView v) { return assign(v); }
+
+    ~String() { deallocate_block(); }
 
 public:
     iterator begin() { return start; }
     const_iterator begin() const { return start; }
-    iterator end() { return finish; }
-    const_iterator end() const { return finish; }
+    iterator end() { return get_finish(); }
+    const_iterator end() const { return get_finish(); }
 
     reverse_iterator rbegin() { return reverse_iterator(end()); }
     const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
@@ -113,17 +104,24 @@ public:
 
     reference front() { return *start; }
     const_reference front() const { return *start; }
-    reference back() { return *(finish - 1); }
-    const_reference back() const { return *(finish - 1); }
+    reference back() { return *(get_finish() - 1); }
+    const_reference back() const { return *(get_finish() - 1); }
 
-    size_type size() const { return	finish - start; }
+    size_type size() const { return get_finish() - start; }
     size_type length() const { return size(); }
     size_type max_size() const { return static_cast<size_type>(-1) / sizeof(char) - 1; }
-    size_type capacity() const { return end_of_storage - start; }
-    bool empty() const { return start == finish; }
+    bool empty() const { return size() == 0; }
+
+    // characters that fit without reallocating, not counting the terminator
+    size_type capacity() const
+    {
+        return is_local() ? static_cast<size_type>(__LOCAL_CAPACITY) 
+                          : rep.heap.end_of_storage - start - 1;
+    }
 
     const char* c_str() const { return start; }
     const char* data() const { return start; }
+    operator StringView() const { return StringView(start, size()); }
 
 public:
     void resize(size_type n) { resize(n, null()); }
@@ -136,55 +134,70 @@ public:
             append(n - size(), c);
     }
 
+    // makes the capacity max(n, size()); strings that fit move back inside 
+    // the object
     void reserve(size_type n = 0)
     {
-        size_type len = max(n, size()) + 1;
-        char* new_start = allocate(len);
-        char* new_finish = uninitialized_copy(start, finish, new_start);
-        construct_null(new_finish);
-        destroy(start, finish + 1);
-        deallocate_block();
-        start = new_start;
-        finish = new_finish;
-        end_of_storage = new_start + len;
+        const size_type len = max(n, size());
+        if (len <= __LOCAL_CAPACITY) {
+            if (!is_local()) {
+                char* old_start = start;
+                const size_type old_len = rep.heap.end_of_storage - start;
+                const size_type old_size = size();
+                start = rep.local;
+                memcpy(start, old_start, old_size);
+                terminate_string(start + old_size);
+                set_finish(start + old_size);
+                deallocate(old_start, old_len);
+            }
+        } else if (is_local() || len != capacity()) {
+            char* new_start = allocate(len + 1);
+            char* new_finish = uninitialized_copy(start, get_finish(), new_start);
+            terminate_string(new_finish);
+            replace_block(new_start, new_finish, len + 1);
+        }
     }
 
     void push_back(char c)
     {
-        if (finish + 1 == end_of_storage)
+        if (size() == capacity())
             reserve(size() + max(size(), static_cast<size_type>(1)));
-        construct_null(finish + 1);
+        char* finish = get_finish();
+        terminate_string(finish + 1);
         *finish = c;
-        ++finish;
+        set_finish(finish + 1);
     }
 
     void pop_back()
     {
-        *(finish - 1) = null();
-        destroy(finish);
-        --finish;
+        char* finish = get_finish() - 1;
+        terminate_string(finish);
+        set_finish(finish);
     }
 
     void clear()
     {
-        if (!empty()) {
-            *start = null();
-            destroy(start + 1, finish + 1);
-            finish = start;
-        }
+        terminate_string(start);
+        set_finish(start);
     }
 
     void swap(String& s)
     {
+        const bool local = is_local();
+        const bool s_local = s.is_local();
         Zyx::swap(start, s.start);
-        Zyx::swap(finish, s.finish);
-        Zyx::swap(end_of_storage, s.end_of_storage);
+        Zyx::swap(rep, s.rep);
+        if (s_local)
+            start = rep.local;
+        if (local)
+            s.start = s.rep.local;
     }
 
 public:
     String& operator+=(const String& s) { return append(s); }
     String& operator+=(const char* s) { return append(s); }
     String& operator+=(char c) { push_back(c); return *this; }
+    String& operator+=(StringView v) { return append(v); }
 
     String& append(const String& s) { return append(s.begin(), s.end()); }
 
@@ -197,15 +210,17 @@ public:
 
     String& append(const char* s, size_type n) { return append(s, s + n); }  
 
+    String& append(StringView v) { return append(v.begin(), v.end()); }
+
     String& append(size_type n, char c)
     {
-        if (size() + n > capacity())
-            reserve(size() + max(size(), n));
         if (n > 0) {
-            uninitialized_fill_n(finish + 1, n - 1, c);
-            construct_null(finish + n);
-            *finish = c;
-            finish += n;
+            if (size() + n > capacity())
+                reserve(size() + max(size(), n));
+            char* finish = get_finish();
+            fill_n(finish, n, c);
+            terminate_string(finish + n);
+            set_finish(finish + n);
         }
         return *this;
     }
@@ -217,6 +232,23 @@ public:
         return append_dispatch(first, last, integral());        
     }
 
+    // decimal text of v, written straight into the buffer when it has room
+    String& append_int(int v) { return append_integer(v); }
+    String& append_int(long v) { return append_integer(v); }
+    String& append_int(long long v) { return append_integer(v); }
+    String& append_int(unsigned int v) { return append_integer(v); }
+    String& append_int(unsigned long v) { return append_integer(v); }
+    String& append_int(unsigned long long v) { return append_integer(v); }
+
+    // the shortest text that reads back as v, as Zyx::to_chars writes it
+    String& append_double(double v)
+    {
+        if (capacity() - size() >= __MAX_NUMBER_CHARS)
+            return commit_finish(__write_double(get_finish(), v));
+        char buffer[__MAX_NUMBER_CHARS];
+        return append(buffer, __write_double(buffer, v));
+    }
+
 public:
     String& assign(const String& s) { return assign(s.begin(), s.end()); }
 
@@ -229,16 +261,12 @@ public:
 
     String& assign(const char* s, size_type n) { return assign(s, s + n); }
 
+    String& assign(StringView v) { return assign(v.begin(), v.end()); }
+
     String& assign(size_type n, char c)
     {
-        if (n <= size()) {
-            fill_n(start, n, c);
-            erase(start + n, finish);        
-        } else {
-            fill_n(start, size(), c);
-            append(n - size(), c);
-        }
-        return *this;
+        clear();
+        return append(n, c);
     }
 
     template <typename InputIterator>
@@ -274,6 +302,12 @@ public:
         return *this;
     }
 
+    String& insert(size_type pos, StringView v)
+    {
+        insert(start + pos, v.begin(), v.end());
+        return *this;
+    }
+
     String& insert(size_type pos, size_type n, char c)
     {
         insert(start + pos, n, c);
@@ -282,9 +316,9 @@ public:
 
     iterator insert(iterator p, char c)
     {
-        if (p == finish) {
+        if (p == get_finish()) {
             push_back(c);
-            return finish - 1;
+            return get_finish() - 1;
         } else {
             return insert_aux(p, c);
         }
@@ -293,21 +327,11 @@ public:
     void insert(iterator p, size_type n, char c)
     {
         if (n != 0) {
-            if (end_of_storage - finish >= n + 1) {
-                const size_type elems_after = finish - p;
-                iterator old_finish = finish;
-                if (elems_after >= n) {
-                    uninitialized_copy((finish - n) + 1, finish + 1, finish + 1);
-                    finish += n;
-                    memmove(p + n, p, elems_after - n + 1);
-                    fill_n(p, n, c);
-                } else {
-                    uninitialized_fill_n(finish + 1, n - elems_after - 1, c);
-                    finish += n - elems_after;
-                    uninitialized_copy(p, old_finish + 1, finish);
-                    finish += elems_after;
-                    fill_n(p, elems_after + 1, c);
-                }
+            char* finish = get_finish();
+            if (capacity() - size() >= n) {
+                memmove(p + n, p, (finish - p) + 1);
+                fill_n(p, n, c);
+                set_finish(finish + n);
             } else {
                 const size_type old_size = size();
                 const size_type len = old_size + max(old_size, n) + 1;
@@ -315,12 +339,8 @@ public:
                 iterator new_finish = uninitialized_copy(start, p, new_start);
                 new_finish = uninitialized_fill_n(new_finish, n, c);
                 new_finish = uninitialized_copy(p, finish, new_finish);
-                construct_null(new_finish);
-                destroy(start, finish + 1);
-                deallocate_block();
-                start = new_start;
-                finish = new_finish;
-                end_of_storage = new_start + len;
+                terminate_string(new_finish);
+                replace_block(new_start, new_finish, len);
             }
         }
     }
@@ -341,23 +361,136 @@ public:
 
     iterator erase(iterator pos)
     {
+        char* finish = get_finish();
         memmove(pos, pos + 1, finish - pos);
-        destroy(finish);
-        --finish;
+        set_finish(finish - 1);
         return pos;
     }
 
     iterator erase(iterator first, iterator last)
     {
         if (first != last) {
+            char* finish = get_finish();
             memmove(first, last, (finish - last) + 1);
-            const iterator new_finish = finish - (last - first);
-            destroy(new_finish + 1, finish + 1);
-            finish = new_finish;
+            set_finish(finish - (last - first));
         }
         return first;
     }
 
+public:
+    // searches and comparisons go through StringView, whose find family
+    // uses the SSE2 kernels in StringScan.h; <, >, <= and >= between
+    // strings are the StringView operators
+    size_type find(StringView v, size_type pos = 0) const
+    {
+        return StringView(*this).find(v, pos);
+    }
+
+    size_type find(const char* s, size_type pos, size_type n) const
+    {
+        return find(StringView(s, n), pos);
+    }
+
+    size_type find(char c, size_type pos = 0) const { return StringView(*this).find(c, pos); }
+
+    size_type rfind(StringView v, size_type pos = npos) const
+    {
+        return StringView(*this).rfind(v, pos);
+    }
+
+    size_type rfind(const char* s, size_type pos, size_type n) const
+    {
+        return rfind(StringView(s, n), pos);
+    }
+
+    size_type rfind(char c, size_type pos = npos) const
+    {
+        return StringView(*this).rfind(c, pos);
+    }
+
+    size_type find_first_of(StringView set, size_type pos = 0) const
+    {
+        return StringView(*this).find_first_of(set, pos);
+    }
+
+    size_type find_first_of(char c, size_type pos = 0) const { return find(c, pos); }
+
+    size_type find_last_of(StringView set, size_type pos = npos) const
+    {
+        return StringView(*this).find_last_of(set, pos);
+    }
+
+    size_type find_last_of(char c, size_type pos = npos) const { return rfind(c, pos); }
+
+    size_type find_first_not_of(StringView set, size_type pos = 0) const
+    {
+        return StringView(*this).find_first_not_of(set, pos);
+    }
+
+    size_type find_first_not_of(char c, size_type pos = 0) const
+    {
+        return StringView(*this).find_first_not_of(c, pos);
+    }
+
+    size_type find_last_not_of(StringView set, size_type pos = npos) const
+    {
+        return StringView(*this).find_last_not_of(set, pos);
+    }
+
+    size_type find_last_not_of(char c, size_type pos = npos) const
+    {
+        return StringView(*this).find_last_not_of(c, pos);
+    }
+
+    int compare(StringView v) const { return StringView(*this).compare(v); }
+
+    int compare(size_type pos, size_type len, StringView v) const
+    {
+        return StringView(*this).compare(pos, len, v);
+    }
+
+    int compare(size_type pos1, size_type len1, StringView v,
+                size_type pos2, size_type len2) const
+    {
+        return StringView(*this).compare(pos1, len1, v, pos2, len2);
+    }
+
+private:
+    bool is_local() const { return start == rep.local; }
+
+    char* get_finish() const
+    {
+        return is_local() ? start + (__LOCAL_CAPACITY - rep.local[__LOCAL_CAPACITY]) 
+                          : rep.heap.finish;
+    }
+
+    // callers write the characters and the terminator first: in local form 
+    // this overwrites the byte after the last possible character
+    void set_finish(char* p)
+    {
+        if (is_local())
+            rep.local[__LOCAL_CAPACITY] = static_cast<char>(__LOCAL_CAPACITY - (p - start));
+        else
+            rep.heap.finish = p;
+    }
+
+    // for characters written past the old finish, within the capacity
+    String& commit_finish(char* p)
+    {
+        terminate_string(p);
+        set_finish(p);
+        return *this;
+    }
+
+    template <typename Integer>
+    String& append_integer(Integer v)
+    {
+        if (capacity() - size() >= __MAX_NUMBER_CHARS)
+            return commit_finish(to_chars(get_finish(), get_finish() + __MAX_NUMBER_CHARS, v));
+        char buffer[__MAX_NUMBER_CHARS];
+        return append(buffer, to_chars(buffer, buffer + __MAX_NUMBER_CHARS, v));
+    }
+
 private:
     char* allocate(size_type n) { return data_allocator::allocate(n); }
 
@@ -367,20 +500,42 @@ private:
             data_allocator::deallocate(p, n); 
     }
 
+    void local_initialize()
+    {
+        start = rep.local;
+        terminate_string(start);
+        set_finish(start);
+    }
+
+    // room for n characters and the terminator; the string is left empty
     void allocate_block(size_type n)
     {
-        if (n <= max_size()) {
-            start = allocate(n);
-            finish = start;
-            end_of_storage = start + n;
+        if (n <= __LOCAL_CAPACITY) {
+            local_initialize();
+        } else if (n < max_size()) {
+            start = allocate(n + 1);
+            rep.heap.finish = start;
+            rep.heap.end_of_storage = start + n + 1;
         }
     }
 
-    void deallocate_block() { deallocate(start, end_of_storage - start); }
+    void deallocate_block()
+    {
+        if (!is_local())
+            deallocate(start, rep.heap.end_of_storage - start);
+    }
+
+    // frees the current block and adopts [new_start, new_start + len)
+    void replace_block(char* new_start, char* new_finish, size_type len)
+    {
+        deallocate_block();
+        start = new_start;
+        rep.heap.finish = new_finish;
+        rep.heap.end_of_storage = new_start + len;
+    }
 
 private:
-    void construct_null(char* p) { construct(p, '\0'); }
-    void terminate_string() { construct_null(finish); }
+    static void terminate_string(char* p) { construct(p, null()); }
     static char null() { return '\0'; }
 
 private:
@@ -393,26 +548,32 @@ private:
     template <typename InputIterator>
     void range_initialize(InputIterator first, InputIterator last, input_iterator_tag)
     {
-        allocate_block(8);
-        construct_null(finish);
+        local_initialize();
         append(first, last);
     }
 
     template <typename ForwardIterator>
     void range_initialize(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
     {
-        difference_type n = distance(first, last);
-        allocate_block(n + 1);
-        finish = uninitialized_copy(first, last, start);
-        terminate_string();
+        difference_type n = Zyx::distance(first, last);
+        allocate_block(n);
+        char* finish = uninitialized_copy(first, last, start);
+        terminate_string(finish);
+        set_finish(finish);
+    }
+
+    void fill_initialize(size_type n, char c)
+    {
+        allocate_block(n);
+        char* finish = uninitialized_fill_n(start, n, c);
+        terminate_string(finish);
+        set_finish(finish);
     }
 
     template <typename Integer>
     void initialize_dispatch(Integer n, Integer x, _true_type)
     {
-        allocate_block(n + 1);
-        finish = uninitialized_fill_n(start, n, x);
-        terminate_string();
+        fill_initialize(static_cast<size_type>(n), static_cast<char>(x));
     }
 
     template <typename InputIterator>
@@ -446,25 +607,18 @@ private:
     {
         if (first != last) {
             const size_type old_size = size();
-            difference_type n = distance(first, last);
+            const size_type n = Zyx::distance(first, last);
             if (old_size + n > capacity()) {
-                const size_type len = old_size + max(old_size, static_cast<size_type>(n)) + 1;
+                const size_type len = old_size + max(old_size, n) + 1;
                 char* new_start = allocate(len);
-                char* new_finish = uninitialized_copy(start, finish, new_start);
+                char* new_finish = uninitialized_copy(start, get_finish(), new_start);
                 new_finish = uninitialized_copy(first, last, new_finish);
-                construct_null(new_finish);
-                destroy(start, finish + 1);
-                deallocate_block();
-                start = new_start;
-                finish = new_finish;
-                end_of_storage = new_start + len;
+                terminate_string(new_finish);
+                replace_block(new_start, new_finish, len);
             } else {
-                ForwardIterator f = first;
-                ++f;
-                uninitialized_copy(f, last, finish + 1);
-                construct_null(finish + n);
-                *finish = *first;
-                finish += n;
+                char* finish = uninitialized_copy(first, last, get_finish());
+                terminate_string(finish);
+                set_finish(finish);
             }
         }
         return *this;
@@ -480,6 +634,7 @@ private:
     String& assign_dispatch(InputIterator first, InputIterator last, _false_type)
     {
         char* cur = start;
+        char* finish = get_finish();
         while (cur != finish && first != last) {
             *cur = *first;
             ++cur;
@@ -494,35 +649,29 @@ private:
 
     iterator insert_aux(iterator p, char c)
     {
-        iterator new_pos = p;
-        if (finish + 1 < end_of_storage) {
-            construct_null(finish + 1);
-            memmove(p + 1, p, finish - p);
+        char* finish = get_finish();
+        if (size() < capacity()) {
+            memmove(p + 1, p, (finish - p) + 1);
             *p = c;
-            ++finish;
+            set_finish(finish + 1);
+            return p;
         } else {
             const size_type old_len = size();
             const size_type len = old_len + max(old_len, static_cast<size_type>(1)) + 1;
             iterator new_start = allocate(len);
-            iterator new_finish = new_start;
-            new_pos = uninitialized_copy(start, p, new_start);
+            iterator new_pos = uninitialized_copy(start, p, new_start);
             construct(new_pos, c);
-            new_finish = new_pos + 1;
-            new_finish = uninitialized_copy(p, finish, new_finish);
-            construct_null(new_finish);
-            destroy(start, finish + 1);
-            deallocate_block();
-            start = new_start;
-            finish = new_finish;
-            end_of_storage = new_start + len;
+            iterator new_finish = uninitialized_copy(p, finish, new_pos + 1);
+            terminate_string(new_finish);
+            replace_block(new_start, new_finish, len);
+            return new_pos;
         }
-        return new_pos;
     }
 
     template <typename Integer>
     void insert_dispatch(iterator p, Integer n, Integer x, _true_type)
     {
-        return insert(p, static_cast<size_type>(n), static_cast<size_type>(x));
+        return insert(p, static_cast<size_type>(n), static_cast<char>(x));
     }
 
     template <typename InputIterator>
@@ -544,45 +693,111 @@ private:
     void insert(iterator p, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
     {
         if (first != last) {
-            difference_type n = distance(first, last);
-            if (end_of_storage - finish >= n + 1) {
-                const size_type elems_after = finish - p;
-                iterator old_finish = finish;
-                if (elems_after >= n) {
-                    uninitialized_copy((finish - n) + 1, finish + 1, finish + 1);
-                    finish += n;
-                    memmove(p + n, p, elems_after - n + 1);
-                    copy(first, last, p);
-                } else {
-                    ForwardIterator mid = first;
-                    advance(mid, elems_after + 1);
-                    uninitialized_copy(mid, last, finish + 1);
-                    finish += n - elems_after;
-                    uninitialized_copy(p, old_finish + 1, finish);
-                    finish += elems_after;
-                    copy(first, mid, p);
-                }
+            const size_type n = Zyx::distance(first, last);
+            char* finish = get_finish();
+            if (capacity() - size() >= n) {
+                memmove(p + n, p, (finish - p) + 1);
+                copy(first, last, p);
+                set_finish(finish + n);
             } else {
                 const size_type old_size = size();
-                const size_type len = old_size + max(old_size, static_cast<size_type>(n)) + 1;
+                const size_type len = old_size + max(old_size, n) + 1;
                 iterator new_start = allocate(len);
                 iterator new_finish = uninitialized_copy(start, p, new_start);
                 new_finish = uninitialized_copy(first, last, new_finish);
                 new_finish = uninitialized_copy(p, finish, new_finish);
-                construct_null(new_finish);
-                destroy(start, finish + 1);
-                deallocate_block();
-                start = new_start;
-                finish = new_finish;
-                end_of_storage = new_start + len;
+                terminate_string(new_finish);
+                replace_block(new_start, new_finish, len);
             }
         }
     }
 
 private:
+    struct heap_rep
+    {
+        char* finish;
+        char* end_of_storage;
+    };
+
+    union local_or_heap
+    {
+        heap_rep heap;
+        char local[__LOCAL_CAPACITY + 1];
+    };
+
     char* start;
-    char* finish;
-    char* end_of_storage;
+    local_or_heap rep;
+};
+
+inline bool operator==(const String& lhs, const String& rhs)
+{
+    return lhs.size() == rhs.size() && memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+inline bool operator!=(const String& lhs, const String& rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator==(const String& lhs, const char* rhs)
+{
+    return strlen(rhs) == lhs.size() && memcmp(lhs.data(), rhs, lhs.size()) == 0;
+}
+
+inline bool operator==(const char* lhs, const String& rhs)
+{
+    return rhs == lhs;
+}
+
+inline bool operator!=(const String& lhs, const char* rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator!=(const char* lhs, const String& rhs)
+{
+    return !(rhs == lhs);
+}
+
+// hash<String> and equal_to<String> are transparent, so a HashMap<String, T>
+// can be searched with a const char* or a StringView without building a String
+template <>
+struct hash<String>
+{
+    typedef void is_transparent;
+    size_t operator()(const String& s) const { return hash_string(s.data(), s.size()); }
+    size_t operator()(const char* s) const { return hash_string(s); }
+    size_t operator()(StringView v) const { return hash_string(v.data(), v.size()); }
+};
+
+template <>
+struct equal_to<String>
+{
+    typedef String first_argument_type;
+    typedef String second_argument_type;
+    typedef bool result_type;
+    typedef void is_transparent;
+
+    template <typename T, typename U>
+    bool operator()(const T& x, const U& y) const { return x == y; }
+};
+
+// likewise for Map<String, T> and Set<String>
+template <>
+struct less<String>
+{
+    typedef String first_argument_type;
+    typedef String second_argument_type;
+    typedef bool result_type;
+    typedef void is_transparent;
+
+    bool operator()(StringView x, StringView y) const { return x < y; }
+};
+
+template <>
+struct cache_hash_code<hash<String> >
+{
+    typedef _true_type type;
 };
 
 }
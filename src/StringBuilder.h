@@ -0,0 +1,252 @@
+#ifndef ZYX_STRING_BUILDER
+#define ZYX_STRING_BUILDER
+
+#include <cstring>
+#include <cerrno>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+#include "Alloc.h"
+#include "Algorithm.h"
+#include "Utility.h"
+#include "NonCopyable.h"
+#include "CharConv.h"
+#include "StringView.h"
+#include "String.h"
+
+namespace Zyx {
+
+// a block of the builder; the characters follow the header
+struct __string_builder_chunk
+{
+    __string_builder_chunk* next;
+    size_t size;
+    size_t capacity;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+//--------------------------------【StringBuilder class】-------------------------------------
+
+// Collects text in a chain of chunks instead of one growing buffer: an
+// append copies its characters once and never moves earlier ones. Chunks
+// start small and grow with the text up to __MAX_CHUNK. The result is
+// materialized once, either as a String of exactly size() characters or
+// written straight to a file descriptor. clear() keeps the chunks for the
+// next use of the builder.
+class StringBuilder : NonCopyable
+{
+public:
+    typedef size_t    size_type;
+
+private:
+    typedef __string_builder_chunk    chunk;
+
+    enum { __MIN_CHUNK = 256 - sizeof(__string_builder_chunk) };
+    enum { __MAX_CHUNK = 64 * 1024 - sizeof(__string_builder_chunk) };
+    enum { __IOV_BATCH = 64 };
+
+public:
+    StringBuilder() : head(nullptr), tail(nullptr), spare(nullptr), total(0) { }
+
+    ~StringBuilder()
+    {
+        free_chunks(head);
+        free_chunks(spare);
+    }
+
+public:
+    size_type size() const { return total; }
+    size_type length() const { return total; }
+    bool empty() const { return total == 0; }
+
+    StringBuilder& append(const char* s, size_type n)
+    {
+        while (n != 0) {
+            if (tail == nullptr || tail->size == tail->capacity)
+                add_chunk(n);
+            const size_type k = min(n, tail->capacity - tail->size);
+            memcpy(tail->data() + tail->size, s, k);
+            tail->size += k;
+            total += k;
+            s += k;
+            n -= k;
+        }
+        return *this;
+    }
+
+    StringBuilder& append(StringView v) { return append(v.data(), v.size()); }
+    StringBuilder& append(const char* s) { return append(s, strlen(s)); }
+    StringBuilder& append(size_type n, char c)
+    {
+        while (n != 0) {
+            if (tail == nullptr || tail->size == tail->capacity)
+                add_chunk(n);
+            const size_type k = min(n, tail->capacity - tail->size);
+            memset(tail->data() + tail->size, c, k);
+            tail->size += k;
+            total += k;
+            n -= k;
+        }
+        return *this;
+    }
+
+    void push_back(char c)
+    {
+        if (tail == nullptr || tail->size == tail->capacity)
+            add_chunk(1);
+        tail->data()[tail->size++] = c;
+        ++total;
+    }
+
+    StringBuilder& operator+=(StringView v) { return append(v); }
+    StringBuilder& operator+=(const char* s) { return append(s); }
+    StringBuilder& operator+=(char c) { push_back(c); return *this; }
+
+    StringBuilder& append_int(int v) { return append_number(v); }
+    StringBuilder& append_int(long v) { return append_number(v); }
+    StringBuilder& append_int(long long v) { return append_number(v); }
+    StringBuilder& append_int(unsigned int v) { return append_number(v); }
+    StringBuilder& append_int(unsigned long v) { return append_number(v); }
+    StringBuilder& append_int(unsigned long long v) { return append_number(v); }
+    StringBuilder& append_double(double v) { return append_number(v); }
+
+    // empties the builder but keeps its chunks for reuse
+    void clear()
+    {
+        if (tail != nullptr) {
+            tail->next = spare;
+            spare = head;
+            head = tail = nullptr;
+        }
+        total = 0;
+    }
+
+    void swap(StringBuilder& x)
+    {
+        Zyx::swap(head, x.head);
+        Zyx::swap(tail, x.tail);
+        Zyx::swap(spare, x.spare);
+        Zyx::swap(total, x.total);
+    }
+
+public:
+    // one allocation of exactly size() characters
+    String str() const
+    {
+        String result(total);
+        for (const chunk* c = head; c != nullptr; c = c->next)
+            result.append(c->data(), c->size);
+        return result;
+    }
+
+    // calls f(StringView) on each chunk in order
+    template <typename Function>
+    Function for_each_chunk(Function f) const
+    {
+        for (const chunk* c = head; c != nullptr; c = c->next)
+            f(StringView(c->data(), c->size));
+        return f;
+    }
+
+    // Writes the text to fd, gathering up to __IOV_BATCH chunks per writev
+    // call and resuming after short writes. Returns false on a write error,
+    // with errno set; the text may then be partly written.
+    bool write_to(int fd) const
+    {
+        const chunk* c = head;
+        size_type offset = 0;
+        while (c != nullptr) {
+#if defined(_WIN32)
+            const int n = _write(fd, c->data() + offset, static_cast<unsigned>(c->size - offset));
+#else
+            struct iovec iov[__IOV_BATCH];
+            int count = 0;
+            for (const chunk* p = c; p != nullptr && count < __IOV_BATCH; p = p->next, ++count) {
+                iov[count].iov_base = const_cast<char*>(p->data()) + (p == c ? offset : 0);
+                iov[count].iov_len = p->size - (p == c ? offset : 0);
+            }
+            const ssize_t n = writev(fd, iov, count);
+#endif
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            size_type written = static_cast<size_type>(n);
+            while (c != nullptr && written >= c->size - offset) {
+                written -= c->size - offset;
+                offset = 0;
+                c = c->next;
+            }
+            offset += written;
+        }
+        return true;
+    }
+
+private:
+    // chunks grow with the text, so there are O(log n) small ones and the
+    // rest are __MAX_CHUNK
+    void add_chunk(size_type n)
+    {
+        chunk* c = spare;
+        if (c != nullptr) {
+            spare = c->next;
+        } else {
+            const size_type cap = min(max(max(total, n), static_cast<size_type>(__MIN_CHUNK)),
+                                      static_cast<size_type>(__MAX_CHUNK));
+            c = static_cast<chunk*>(alloc::allocate(sizeof(chunk) + cap));
+            c->capacity = cap;
+        }
+        c->next = nullptr;
+        c->size = 0;
+        if (tail == nullptr)
+            head = c;
+        else
+            tail->next = c;
+        tail = c;
+    }
+
+    static void free_chunks(chunk* c)
+    {
+        while (c != nullptr) {
+            chunk* next = c->next;
+            alloc::deallocate(c, sizeof(chunk) + c->capacity);
+            c = next;
+        }
+    }
+
+    // formats in place when the last chunk has room
+    template <typename T>
+    StringBuilder& append_number(T v)
+    {
+        if (tail != nullptr && tail->capacity - tail->size >= __MAX_NUMBER_CHARS) {
+            char* first = tail->data() + tail->size;
+            const size_type n = to_chars(first, first + __MAX_NUMBER_CHARS, v) - first;
+            tail->size += n;
+            total += n;
+            return *this;
+        }
+        char buffer[__MAX_NUMBER_CHARS];
+        return append(buffer, to_chars(buffer, buffer + __MAX_NUMBER_CHARS, v) - buffer);
+    }
+
+private:
+    chunk* head;
+    chunk* tail;
+    chunk* spare;    // chunks kept by clear()
+    size_type total;
+};
+
+inline void swap(StringBuilder& lhs, StringBuilder& rhs)
+{
+    lhs.swap(rhs);
+}
+
+}
+
+#endif
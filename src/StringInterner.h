@@ -0,0 +1,269 @@
+#ifndef ZYX_STRING_INTERNER
+#define ZYX_STRING_INTERNER
+
+#include <atomic>
+#include <new>
+#include <cstring>
+#include <stdexcept>
+#include "HashTable.h"
+#include "HashFun.h"
+#include "Functional.h"
+#include "Alloc.h"
+#include "Construct.h"
+#include "Utility.h"
+#include "NonCopyable.h"
+#include "LockGuard.h"
+#include "RWLock.h"
+#include "StringView.h"
+#include "StringScan.h"
+
+namespace Zyx {
+
+// Bump allocator for string bytes. Blocks are only freed with the arena, so
+// everything stored stays at the same address. Strings too large to share a
+// block get one of their own.
+class __string_arena : NonCopyable
+{
+private:
+    struct block
+    {
+        block* next;
+        size_t size;
+
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    enum { __BLOCK_BYTES = 64 * 1024 };
+    enum { __BLOCK_CAPACITY = __BLOCK_BYTES - sizeof(block) };
+
+public:
+    __string_arena() : blocks(nullptr), cur(nullptr), left(0) { }
+
+    ~__string_arena()
+    {
+        while (blocks != nullptr) {
+            block* next = blocks->next;
+            malloc_alloc::deallocate(blocks, sizeof(block) + blocks->size);
+            blocks = next;
+        }
+    }
+
+    // a null-terminated copy of v
+    const char* store(StringView v)
+    {
+        const size_t n = v.size() + 1;
+        char* result;
+        if (n > __BLOCK_CAPACITY / 4) {
+            result = new_block(n)->data();
+        } else {
+            if (n > left) {
+                cur = new_block(__BLOCK_CAPACITY)->data();
+                left = __BLOCK_CAPACITY;
+            }
+            result = cur;
+            cur += n;
+            left -= n;
+        }
+        memcpy(result, v.data(), v.size());
+        result[v.size()] = '\0';
+        return result;
+    }
+
+private:
+    block* new_block(size_t n)
+    {
+        block* b = static_cast<block*>(malloc_alloc::allocate(sizeof(block) + n));
+        b->next = blocks;
+        b->size = n;
+        blocks = b;
+        return b;
+    }
+
+private:
+    block* blocks;
+    char* cur;
+    size_t left;
+};
+
+//---------------------------------【StringInterner class】-----------------------------------
+
+// Maps each distinct string to a dense 32-bit id, so that containers can
+// hold and compare ids instead of strings: equality and hash<unsigned int>
+// on ids take O(1), and every distinct string is stored once. The bytes
+// live in arenas and keep their address, so str(id) returns a view that
+// stays valid, null-terminated, for the life of the interner.
+//
+// Strings are spread over independently locked HashTable shards, as in
+// ConcurrentHashMap, each with its own arena; a string already present is
+// found under the shard's read lock. str(id) takes no lock: ids index a
+// directory of pages that never move. Nothing is ever removed.
+class StringInterner : NonCopyable
+{
+public:
+    typedef unsigned int    id_type;
+    typedef size_t          size_type;
+
+    static const id_type invalid_id = static_cast<id_type>(-1);
+
+private:
+    typedef Pair<const StringView, id_type>    value_type;
+    typedef HashTable<value_type, StringView, hash<StringView>, select1st<value_type>,
+                      equal_to<StringView>, malloc_alloc>
+            table_type;
+
+    struct shard
+    {
+        explicit shard(size_type n)
+          : table(n, hash<StringView>(), equal_to<StringView>()) { }
+
+        mutable RWLock lock;
+        table_type table;
+        __string_arena arena;
+    };
+
+    typedef simple_alloc<shard, malloc_alloc> shard_allocator;
+
+    // page k of the directory holds 2^(k + __FIRST_PAGE_BITS) entries, so
+    // __PAGES pages cover every id below 2^32 - 2^__FIRST_PAGE_BITS
+    enum { __FIRST_PAGE_BITS = 10 };
+    enum { __PAGES = 32 - __FIRST_PAGE_BITS };
+
+public:
+    explicit StringInterner(size_type n_shards = 16, size_type n = 100) : next_id(0)
+    {
+        shard_bits = 0;
+        while ((static_cast<size_type>(1) << shard_bits) < n_shards)
+            ++shard_bits;
+        num_shards = static_cast<size_type>(1) << shard_bits;
+        shards = shard_allocator::allocate(num_shards);
+        for (size_type i = 0; i < num_shards; ++i)
+            new (shards + i) shard(n / num_shards + 1);
+        for (int k = 0; k < __PAGES; ++k)
+            pages[k].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~StringInterner()
+    {
+        for (size_type i = 0; i < num_shards; ++i)
+            destroy(shards + i);
+        shard_allocator::deallocate(shards, num_shards);
+        for (int k = 0; k < __PAGES; ++k) {
+            StringView* page = pages[k].load(std::memory_order_relaxed);
+            if (page != nullptr)
+                malloc_alloc::deallocate(page, page_size(k) * sizeof(StringView));
+        }
+    }
+
+public:
+    // ids handed out so far; they are 0 .. size() - 1
+    size_type size() const { return next_id.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+
+    // the directory ends at 2^32 - 2^__FIRST_PAGE_BITS ids, which also keeps
+    // invalid_id from being handed out
+    size_type max_size() const { return static_cast<id_type>(0u - (1u << __FIRST_PAGE_BITS)); }
+
+    // the id of s, giving it the next free id if it is new; throws
+    // std::length_error once max_size() strings are interned
+    id_type intern(StringView s)
+    {
+        shard& sh = shard_of(s);
+        {
+            SharedLockGuard<RWLock> guard(sh.lock);
+            table_type::const_iterator it = sh.table.find(s);
+            if (it != sh.table.end())
+                return it->second;
+        }
+        LockGuard<RWLock> guard(sh.lock);
+        table_type::const_iterator it = sh.table.find(s);
+        if (it != sh.table.end())
+            return it->second;
+        const id_type id = new_id();
+        const StringView stored(sh.arena.store(s), s.size());
+        entry(id) = stored;
+        sh.table.insert_unique(value_type(stored, id));
+        return id;
+    }
+
+    // the id of s, or invalid_id if s was never interned
+    id_type find(StringView s) const
+    {
+        const shard& sh = shard_of(s);
+        SharedLockGuard<RWLock> guard(sh.lock);
+        table_type::const_iterator it = sh.table.find(s);
+        return it == sh.table.end() ? invalid_id : it->second;
+    }
+
+    // id must come from intern() or find()
+    StringView str(id_type id) const
+    {
+        size_type offset;
+        const int k = page_of(id, offset);
+        return pages[k].load(std::memory_order_acquire)[offset];
+    }
+
+private:
+    id_type new_id()
+    {
+        id_type id = next_id.load(std::memory_order_relaxed);
+        do {
+            if (id >= max_size())
+                throw std::length_error("Zyx::StringInterner: too many strings");
+        } while (!next_id.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+        return id;
+    }
+
+    static size_type page_size(int k)
+    {
+        return static_cast<size_type>(1) << (k + __FIRST_PAGE_BITS);
+    }
+
+    static int page_of(id_type id, size_type& offset)
+    {
+        const id_type j = id + (1u << __FIRST_PAGE_BITS);
+        const int k = static_cast<int>(__highest_bit(j)) - __FIRST_PAGE_BITS;
+        offset = j - (1u << (k + __FIRST_PAGE_BITS));
+        return k;
+    }
+
+    // shards may create the same page at once; the loser frees its copy
+    StringView& entry(id_type id)
+    {
+        size_type offset;
+        const int k = page_of(id, offset);
+        StringView* page = pages[k].load(std::memory_order_acquire);
+        if (page == nullptr) {
+            const size_type bytes = page_size(k) * sizeof(StringView);
+            StringView* fresh = static_cast<StringView*>(malloc_alloc::allocate(bytes));
+            if (pages[k].compare_exchange_strong(page, fresh, std::memory_order_acq_rel))
+                page = fresh;
+            else
+                malloc_alloc::deallocate(fresh, bytes);
+        }
+        return page[offset];
+    }
+
+    size_type shard_index(StringView s) const
+    {
+        if (shard_bits == 0)
+            return 0;
+        const size_type golden = sizeof(size_type) > 4
+                               ? static_cast<size_type>(0x9E3779B97F4A7C15ull)
+                               : static_cast<size_type>(0x9E3779B9ul);
+        return (hash<StringView>()(s) * golden) >> (sizeof(size_type) * 8 - shard_bits);
+    }
+
+    shard& shard_of(StringView s) { return shards[shard_index(s)]; }
+    const shard& shard_of(StringView s) const { return shards[shard_index(s)]; }
+
+private:
+    shard* shards;
+    size_type num_shards;
+    size_type shard_bits;
+    std::atomic<id_type> next_id;
+    std::atomic<StringView*> pages[__PAGES];
+};
+
+}
+
+#endif
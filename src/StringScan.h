@@ -0,0 +1,406 @@
+#ifndef ZYX_STRING_SCAN
+#define ZYX_STRING_SCAN
+
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZYX_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Zyx {
+
+// Byte-scanning kernels behind the StringView and String search members.
+// They work on raw ranges and return a pointer to the match or nullptr.
+// The SSE2 paths examine 16 candidate positions per step and fall back to
+// scalar loops for the tail; without SSE2 only the scalar loops remain.
+
+// index of the lowest and the highest set bit of a non-zero mask
+inline unsigned __lowest_bit(unsigned x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#elif defined(_MSC_VER)
+    unsigned long r;
+    _BitScanForward(&r, x);
+    return r;
+#else
+    unsigned r = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        ++r;
+    }
+    return r;
+#endif
+}
+
+inline unsigned __highest_bit(unsigned x)
+{
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(x);
+#elif defined(_MSC_VER)
+    unsigned long r;
+    _BitScanReverse(&r, x);
+    return r;
+#else
+    unsigned r = 0;
+    while (x >>= 1)
+        ++r;
+    return r;
+#endif
+}
+
+// the last c in [s, s + n)
+inline const char* __scan_byte_reverse(const char* s, size_t n, char c)
+{
+    const char* cur = s + n;
+#if ZYX_SSE2
+    const __m128i pattern = _mm_set1_epi8(c);
+    while (cur - s >= 16) {
+        cur -= 16;
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+        const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern));
+        if (mask != 0)
+            return cur + __highest_bit(mask);
+    }
+#endif
+    while (cur != s) {
+        if (*--cur == c)
+            return cur;
+    }
+    return nullptr;
+}
+
+// Byte access for the two-way search, which reads both strings through
+// the same policy: forwards from the start, or backwards from the end.
+struct __bytes_forward
+{
+    const unsigned char* first;
+
+    explicit __bytes_forward(const char* p) : first(reinterpret_cast<const unsigned char*>(p)) { }
+
+    unsigned char operator[](ptrdiff_t i) const { return first[i]; }
+};
+
+struct __bytes_backward
+{
+    const unsigned char* last;
+
+    explicit __bytes_backward(const char* p) : last(reinterpret_cast<const unsigned char*>(p)) { }
+
+    unsigned char operator[](ptrdiff_t i) const { return last[-1 - i]; }
+};
+
+// the start, less one, of the maximal suffix of x[0, m) under the byte
+// order or its reverse, and the period of that suffix
+template <typename Bytes>
+inline ptrdiff_t __maximal_suffix(Bytes x, ptrdiff_t m, ptrdiff_t& period, bool reversed)
+{
+    ptrdiff_t ms = -1, j = 0, k = 1;
+    period = 1;
+    while (j + k < m) {
+        const unsigned char a = x[j + k];
+        const unsigned char b = x[ms + k];
+        if (reversed ? a > b : a < b) {
+            j += k;
+            k = 1;
+            period = j - ms;
+        } else if (a == b) {
+            if (k != period) {
+                ++k;
+            } else {
+                j += period;
+                k = 1;
+            }
+        } else {
+            ms = j++;
+            k = period = 1;
+        }
+    }
+    return ms;
+}
+
+// Crochemore and Perrin's two-way search: the index of the first x[0, m)
+// in y[0, n), or -1. It splits the needle at a critical factorization,
+// matches the right part left to right and then the left part right to
+// left, and shifts so that no byte of y is compared more than twice.
+// O(n + m) time and O(1) space, whatever the inputs.
+template <typename Bytes>
+inline ptrdiff_t __two_way(Bytes y, ptrdiff_t n, Bytes x, ptrdiff_t m)
+{
+    ptrdiff_t p, q;
+    const ptrdiff_t i1 = __maximal_suffix(x, m, p, false);
+    const ptrdiff_t i2 = __maximal_suffix(x, m, q, true);
+    const ptrdiff_t ell = i1 > i2 ? i1 : i2;
+    ptrdiff_t per = i1 > i2 ? p : q;
+
+    bool periodic = per < m;
+    for (ptrdiff_t i = 0; periodic && i <= ell; ++i)
+        periodic = x[i] == x[i + per];
+
+    ptrdiff_t j = 0;
+    if (periodic) {
+        // the part of the needle before memory is known to match
+        ptrdiff_t memory = -1;
+        while (j <= n - m) {
+            ptrdiff_t i = (ell > memory ? ell : memory) + 1;
+            while (i < m && x[i] == y[i + j])
+                ++i;
+            if (i >= m) {
+                i = ell;
+                while (i > memory && x[i] == y[i + j])
+                    --i;
+                if (i <= memory)
+                    return j;
+                j += per;
+                memory = m - per - 1;
+            } else {
+                j += i - ell;
+                memory = -1;
+            }
+        }
+    } else {
+        per = (ell + 1 > m - ell - 1 ? ell + 1 : m - ell - 1) + 1;
+        while (j <= n - m) {
+            ptrdiff_t i = ell + 1;
+            while (i < m && x[i] == y[i + j])
+                ++i;
+            if (i >= m) {
+                i = ell;
+                while (i >= 0 && x[i] == y[i + j])
+                    --i;
+                if (i < 0)
+                    return j;
+                j += per;
+            } else {
+                j += i - ell;
+            }
+        }
+    }
+    return -1;
+}
+
+// the filters below hand over to the two-way search when needles of at
+// least __TWO_WAY_SIZE bytes need more verification than the text they
+// have scanned, as on periodic text, which keeps them linear
+enum { __TWO_WAY_SIZE = 32 };
+
+inline bool __over_budget(size_t m, size_t checks, size_t scanned)
+{
+    return m >= __TWO_WAY_SIZE && checks > 8 + 2 * scanned / m;
+}
+
+inline const char* __scan_two_way(const char* s, size_t n, const char* p, size_t m)
+{
+    const ptrdiff_t i = __two_way(__bytes_forward(s), n, __bytes_forward(p), m);
+    return i < 0 ? nullptr : s + i;
+}
+
+inline const char* __scan_two_way_reverse(const char* s, size_t n, const char* p, size_t m)
+{
+    const ptrdiff_t i = __two_way(__bytes_backward(s + n), n, __bytes_backward(p + m), m);
+    return i < 0 ? nullptr : s + n - i - m;
+}
+
+// The first occurrence of [p, p + m) in [s, s + n). Each step compares the
+// first and the last byte of the needle against 16 candidate positions at
+// once, and memcmp only checks the middle of the candidates where both
+// agree, which is rare for text.
+inline const char* __scan_substring(const char* s, size_t n, const char* p, size_t m)
+{
+    if (m == 0)
+        return s;
+    if (m > n)
+        return nullptr;
+    if (m == 1)
+        return static_cast<const char*>(memchr(s, p[0], n));
+    const char* cur = s;
+    const char* last = s + n - m + 1;    // one past the last candidate
+    size_t checks = 0;                   // candidates passed to memcmp
+#if ZYX_SSE2
+    const __m128i head = _mm_set1_epi8(p[0]);
+    const __m128i tail = _mm_set1_epi8(p[m - 1]);
+    for (; last - cur >= 16; cur += 16) {
+        if (__over_budget(m, checks, cur - s))
+            return __scan_two_way(cur, s + n - cur, p, m);
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + m - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, head),
+                                                        _mm_cmpeq_epi8(b, tail)));
+        for (; mask != 0; mask &= mask - 1) {
+            const char* candidate = cur + __lowest_bit(mask);
+            ++checks;
+            if (memcmp(candidate + 1, p + 1, m - 2) == 0)
+                return candidate;
+        }
+    }
+#endif
+    for (; cur != last; ++cur) {
+        cur = static_cast<const char*>(memchr(cur, p[0], last - cur));
+        if (cur == nullptr)
+            return nullptr;
+        if (cur[m - 1] == p[m - 1]) {
+            if (__over_budget(m, ++checks, cur - s))
+                return __scan_two_way(cur, s + n - cur, p, m);
+            if (memcmp(cur + 1, p + 1, m - 2) == 0)
+                return cur;
+        }
+    }
+    return nullptr;
+}
+
+// the last occurrence of [p, p + m) in [s, s + n)
+inline const char* __scan_substring_reverse(const char* s, size_t n, const char* p, size_t m)
+{
+    if (m == 0)
+        return s + n;
+    if (m > n)
+        return nullptr;
+    if (m == 1)
+        return __scan_byte_reverse(s, n, p[0]);
+    const char* last = s + n - m + 1;    // one past the last candidate
+    const char* cur = last;
+    size_t checks = 0;
+#if ZYX_SSE2
+    const __m128i head = _mm_set1_epi8(p[0]);
+    const __m128i tail = _mm_set1_epi8(p[m - 1]);
+    while (cur - s >= 16) {
+        if (__over_budget(m, checks, last - cur))
+            return __scan_two_way_reverse(s, cur - s + m - 1, p, m);
+        cur -= 16;
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + m - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, head),
+                                                        _mm_cmpeq_epi8(b, tail)));
+        while (mask != 0) {
+            const unsigned i = __highest_bit(mask);
+            ++checks;
+            if (memcmp(cur + i + 1, p + 1, m - 2) == 0)
+                return cur + i;
+            mask &= ~(1u << i);
+        }
+    }
+#endif
+    while (cur != s) {
+        --cur;
+        if (cur[0] == p[0] && cur[m - 1] == p[m - 1]) {
+            if (__over_budget(m, ++checks, last - cur))
+                return __scan_two_way_reverse(s, cur - s + m, p, m);
+            if (memcmp(cur + 1, p + 1, m - 2) == 0)
+                return cur;
+        }
+    }
+    return nullptr;
+}
+
+// a 256-bit membership table for the find_first_of family
+struct __byte_set
+{
+    unsigned char bits[32];
+
+    __byte_set(const char* set, size_t m)
+    {
+        memset(bits, 0, sizeof(bits));
+        for (size_t i = 0; i < m; ++i) {
+            const unsigned char c = static_cast<unsigned char>(set[i]);
+            bits[c >> 3] |= static_cast<unsigned char>(1 << (c & 7));
+        }
+    }
+
+    bool contains(char ch) const
+    {
+        const unsigned char c = static_cast<unsigned char>(ch);
+        return (bits[c >> 3] & (1 << (c & 7))) != 0;
+    }
+};
+
+// sets up to this size are matched with one vector compare per member;
+// larger ones go through the table
+enum { __SIMD_SET_SIZE = 8 };
+
+#if ZYX_SSE2
+inline unsigned __set_mask(const char* block, const char* set, size_t m)
+{
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    __m128i hits = _mm_setzero_si128();
+    for (size_t i = 0; i < m; ++i)
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(x, _mm_set1_epi8(set[i])));
+    return _mm_movemask_epi8(hits);
+}
+#endif
+
+inline bool __in_small_set(char c, const char* set, size_t m)
+{
+    for (size_t i = 0; i < m; ++i) {
+        if (set[i] == c)
+            return true;
+    }
+    return false;
+}
+
+// the first byte in [first, last) whose membership in table is in
+inline const char* __scan_table(const char* first, const char* last,
+                                const __byte_set& table, bool in)
+{
+    for (; first != last; ++first) {
+        if (table.contains(*first) == in)
+            return first;
+    }
+    return nullptr;
+}
+
+// the first byte in [first, last) whose membership in [set, set + m) is
+// in; in == false gives find_first_not_of
+inline const char* __scan_set(const char* first, const char* last,
+                              const char* set, size_t m, bool in)
+{
+    if (m > __SIMD_SET_SIZE)
+        return __scan_table(first, last, __byte_set(set, m), in);
+#if ZYX_SSE2
+    const unsigned flip = in ? 0 : 0xFFFF;
+    for (; last - first >= 16; first += 16) {
+        const unsigned mask = __set_mask(first, set, m) ^ flip;
+        if (mask != 0)
+            return first + __lowest_bit(mask);
+    }
+#endif
+    for (; first != last; ++first) {
+        if (__in_small_set(*first, set, m) == in)
+            return first;
+    }
+    return nullptr;
+}
+
+// the last such byte in [first, last)
+inline const char* __scan_set_reverse(const char* first, const char* last,
+                                      const char* set, size_t m, bool in)
+{
+    if (m > __SIMD_SET_SIZE) {
+        const __byte_set table(set, m);
+        while (last != first) {
+            if (table.contains(*--last) == in)
+                return last;
+        }
+        return nullptr;
+    }
+#if ZYX_SSE2
+    const unsigned flip = in ? 0 : 0xFFFF;
+    while (last - first >= 16) {
+        last -= 16;
+        const unsigned mask = __set_mask(last, set, m) ^ flip;
+        if (mask != 0)
+            return last + __highest_bit(mask);
+    }
+#endif
+    while (last != first) {
+        if (__in_small_set(*--last, set, m) == in)
+            return last;
+    }
+    return nullptr;
+}
+
+}
+
+#endif
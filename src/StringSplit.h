@@ -0,0 +1,250 @@
+#ifndef ZYX_STRING_SPLIT
+#define ZYX_STRING_SPLIT
+
+#include <cstring>
+#include "Iterator.h"
+#include "StringView.h"
+#include "StringScan.h"
+
+namespace Zyx {
+
+// Delimiter policies for SplitIterator. find returns the start of the next
+// delimiter in [first, last) or nullptr, and size its length.
+
+struct __char_delimiter
+{
+    char c;
+
+    explicit __char_delimiter(char c_) : c(c_) { }
+
+    const char* find(const char* first, const char* last) const
+    {
+        return static_cast<const char*>(memchr(first, c, last - first));
+    }
+
+    size_t size() const { return 1; }
+};
+
+// any one byte of set; large sets keep their table between tokens
+struct __set_delimiter
+{
+    StringView set;
+    __byte_set table;
+
+    explicit __set_delimiter(StringView s) : set(s), table(s.data(), s.size()) { }
+
+    const char* find(const char* first, const char* last) const
+    {
+        if (set.size() > __SIMD_SET_SIZE)
+            return __scan_table(first, last, table, true);
+        return __scan_set(first, last, set.data(), set.size(), true);
+    }
+
+    // the first byte not in the set, for skipping runs of delimiters
+    const char* skip(const char* first, const char* last) const
+    {
+        if (set.size() > __SIMD_SET_SIZE)
+            return __scan_table(first, last, table, false);
+        return __scan_set(first, last, set.data(), set.size(), false);
+    }
+
+    size_t size() const { return 1; }
+};
+
+// an empty delimiter string never matches
+struct __string_delimiter
+{
+    StringView delim;
+
+    explicit __string_delimiter(StringView d) : delim(d) { }
+
+    const char* find(const char* first, const char* last) const
+    {
+        if (delim.empty())
+            return nullptr;
+        return __scan_substring(first, last - first, delim.data(), delim.size());
+    }
+
+    size_t size() const { return delim.size(); }
+};
+
+// Yields the pieces of a character range between delimiters as StringViews
+// into the range, finding each delimiter only when it is reached. Empty
+// pieces are kept, so n delimiters always give n + 1 pieces and an empty
+// range gives one empty piece. The range, and a delimiter string or set,
+// must outlive the iterators.
+template <typename Delimiter>
+class SplitIterator
+{
+public:
+    typedef forward_iterator_tag    iterator_category;
+    typedef StringView              value_type;
+    typedef const StringView*       pointer;
+    typedef StringView              reference;
+    typedef ptrdiff_t               difference_type;
+
+    typedef SplitIterator<Delimiter>    self;
+
+public:
+    // the end iterator
+    explicit SplitIterator(const Delimiter& d)
+      : piece_first(nullptr), piece_last(nullptr), last(nullptr), delim(d) { }
+
+    // a null range, as in an empty StringView, still has one empty piece
+    SplitIterator(const char* first, const char* last_, const Delimiter& d)
+      : piece_first(first), last(last_), delim(d)
+    {
+        if (first == nullptr)
+            piece_first = last = "";
+        find_piece_end();
+    }
+
+public:
+    bool operator==(const self& x) const { return piece_first == x.piece_first; }
+    bool operator!=(const self& x) const { return piece_first != x.piece_first; }
+
+    reference operator*() const { return StringView(piece_first, piece_last); }
+
+    self& operator++()
+    {
+        if (piece_last == last) {
+            piece_first = nullptr;
+        } else {
+            piece_first = piece_last + delim.size();
+            find_piece_end();
+        }
+        return *this;
+    }
+
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+private:
+    void find_piece_end()
+    {
+        const char* p = delim.find(piece_first, last);
+        piece_last = p == nullptr ? last : p;
+    }
+
+private:
+    const char* piece_first;    // nullptr at the end
+    const char* piece_last;
+    const char* last;
+    Delimiter delim;
+};
+
+// Yields the maximal runs of bytes outside a set, like strtok without the
+// writes: runs of delimiters, also at either end, produce no empty tokens.
+class TokenIterator
+{
+public:
+    typedef forward_iterator_tag    iterator_category;
+    typedef StringView              value_type;
+    typedef const StringView*       pointer;
+    typedef StringView              reference;
+    typedef ptrdiff_t               difference_type;
+
+    typedef TokenIterator    self;
+
+public:
+    // the end iterator
+    explicit TokenIterator(const __set_delimiter& d)
+      : token_first(nullptr), token_last(nullptr), last(nullptr), delim(d) { }
+
+    TokenIterator(const char* first, const char* last_, const __set_delimiter& d)
+      : token_last(first), last(last_), delim(d)
+    {
+        next_token();
+    }
+
+public:
+    bool operator==(const self& x) const { return token_first == x.token_first; }
+    bool operator!=(const self& x) const { return token_first != x.token_first; }
+
+    reference operator*() const { return StringView(token_first, token_last); }
+
+    self& operator++()
+    {
+        next_token();
+        return *this;
+    }
+
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+private:
+    void next_token()
+    {
+        token_first = delim.skip(token_last, last);
+        if (token_first != nullptr) {
+            const char* p = delim.find(token_first, last);
+            token_last = p == nullptr ? last : p;
+        }
+    }
+
+private:
+    const char* token_first;    // nullptr at the end
+    const char* token_last;
+    const char* last;
+    __set_delimiter delim;
+};
+
+// a begin/end pair for range-based for
+template <typename Iterator>
+class SplitRange
+{
+public:
+    typedef Iterator    iterator;
+
+    SplitRange(const Iterator& first_, const Iterator& last_) : first(first_), last(last_) { }
+
+    iterator begin() const { return first; }
+    iterator end() const { return last; }
+
+private:
+    Iterator first;
+    Iterator last;
+};
+
+// the pieces of s between occurrences of c
+inline SplitRange<SplitIterator<__char_delimiter> > split(StringView s, char c)
+{
+    typedef SplitIterator<__char_delimiter> iterator;
+    const __char_delimiter d(c);
+    return SplitRange<iterator>(iterator(s.begin(), s.end(), d), iterator(d));
+}
+
+// the pieces of s between occurrences of delim
+inline SplitRange<SplitIterator<__string_delimiter> > split(StringView s, StringView delim)
+{
+    typedef SplitIterator<__string_delimiter> iterator;
+    const __string_delimiter d(delim);
+    return SplitRange<iterator>(iterator(s.begin(), s.end(), d), iterator(d));
+}
+
+// the pieces of s between single bytes of set
+inline SplitRange<SplitIterator<__set_delimiter> > split_any(StringView s, StringView set)
+{
+    typedef SplitIterator<__set_delimiter> iterator;
+    const __set_delimiter d(set);
+    return SplitRange<iterator>(iterator(s.begin(), s.end(), d), iterator(d));
+}
+
+// the non-empty runs of s outside set
+inline SplitRange<TokenIterator> tokenize(StringView s, StringView set)
+{
+    const __set_delimiter d(set);
+    return SplitRange<TokenIterator>(TokenIterator(s.begin(), s.end(), d), TokenIterator(d));
+}
+
+}
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef ZYX_STRING_VIEW
+#define ZYX_STRING_VIEW
+
+#include <cstring>
+#include "Iterator.h"
+#include "Algorithm.h"
+#include "HashFun.h"
+#include "Functional.h"
+#include "StringScan.h"
+
+namespace Zyx {
+
+// A read-only window onto characters owned elsewhere: a pointer and a
+// length, cheap to copy and never allocating. The characters must outlive
+// the view and need not be null-terminated. String converts to StringView
+// implicitly, so functions taking a StringView accept String, const char*
+// and slices of raw buffers alike.
+class StringView
+{
+public:
+    typedef char           value_type;
+    typedef const char&    reference;
+    typedef const char&    const_reference;
+    typedef const char*    pointer;
+    typedef const char*    const_pointer;
+    typedef const char*    iterator;
+    typedef const char*    const_iterator;
+    typedef size_t         size_type;
+    typedef ptrdiff_t      difference_type;
+
+    typedef reverse_iterator<const_iterator>    const_reverse_iterator;
+    typedef const_reverse_iterator              reverse_iterator;
+
+public:
+    static const size_type npos = static_cast<size_type>(-1);
+
+public:
+    StringView() : ptr(nullptr), len(0) { }
+    StringView(const char* s) : ptr(s), len(strlen(s)) { }
+    StringView(const char* s, size_type n) : ptr(s), len(n) { }
+    StringView(const char* first, const char* last) : ptr(first), len(last - first) { }
+
+public:
+    const_iterator begin() const { return ptr; }
+    const_iterator end() const { return ptr + len; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    const_reference operator[](size_type n) const { return ptr[n]; }
+    const_reference front() const { return ptr[0]; }
+    const_reference back() const { return ptr[len - 1]; }
+    const char* data() const { return ptr; }
+
+    size_type size() const { return len; }
+    size_type length() const { return len; }
+    size_type max_size() const { return static_cast<size_type>(-1) / sizeof(char) - 1; }
+    bool empty() const { return len == 0; }
+
+public:
+    void remove_prefix(size_type n) { ptr += n; len -= n; }
+    void remove_suffix(size_type n) { len -= n; }
+
+    void swap(StringView& v)
+    {
+        Zyx::swap(ptr, v.ptr);
+        Zyx::swap(len, v.len);
+    }
+
+    // copies at most n characters from pos into dest, without a terminator
+    size_type copy(char* dest, size_type n, size_type pos = 0) const
+    {
+        const size_type count = min(n, len - pos);
+        if (count != 0)
+            memcpy(dest, ptr + pos, count);
+        return count;
+    }
+
+    StringView substr(size_type pos = 0, size_type n = npos) const
+    {
+        return StringView(ptr + pos, min(n, len - pos));
+    }
+
+public:
+    int compare(StringView v) const
+    {
+        const size_type n = min(len, v.len);
+        const int r = n == 0 ? 0 : memcmp(ptr, v.ptr, n);
+        if (r != 0)
+            return r;
+        return len < v.len ? -1 : (len > v.len ? 1 : 0);
+    }
+
+    int compare(size_type pos, size_type n, StringView v) const
+    {
+        return substr(pos, n).compare(v);
+    }
+
+    int compare(size_type pos1, size_type n1, StringView v, size_type pos2, size_type n2) const
+    {
+        return substr(pos1, n1).compare(v.substr(pos2, n2));
+    }
+
+    bool starts_with(StringView v) const
+    {
+        return len >= v.len && (v.len == 0 || memcmp(ptr, v.ptr, v.len) == 0);
+    }
+
+    bool starts_with(char c) const { return len != 0 && ptr[0] == c; }
+
+    bool ends_with(StringView v) const
+    {
+        return len >= v.len && (v.len == 0 || memcmp(ptr + len - v.len, v.ptr, v.len) == 0);
+    }
+
+    bool ends_with(char c) const { return len != 0 && ptr[len - 1] == c; }
+
+public:
+    // the search members run on the kernels in StringScan.h
+    size_type find(StringView v, size_type pos = 0) const
+    {
+        if (pos > len)
+            return npos;
+        if (v.len == 0)    // also when ptr is null
+            return pos;
+        return to_index(__scan_substring(ptr + pos, len - pos, v.ptr, v.len));
+    }
+
+    size_type find(char c, size_type pos = 0) const
+    {
+        if (pos >= len)
+            return npos;
+        return to_index(static_cast<const char*>(memchr(ptr + pos, c, len - pos)));
+    }
+
+    size_type rfind(StringView v, size_type pos = npos) const
+    {
+        if (v.len > len)
+            return npos;
+        if (v.len == 0)
+            return min(pos, len);
+        return to_index(__scan_substring_reverse(ptr, min(pos, len - v.len) + v.len,
+                                                 v.ptr, v.len));
+    }
+
+    size_type rfind(char c, size_type pos = npos) const
+    {
+        if (len == 0)
+            return npos;
+        return to_index(__scan_byte_reverse(ptr, min(pos, len - 1) + 1, c));
+    }
+
+    size_type find_first_of(StringView set, size_type pos = 0) const
+    {
+        if (pos >= len)
+            return npos;
+        return to_index(__scan_set(ptr + pos, ptr + len, set.ptr, set.len, true));
+    }
+
+    size_type find_first_of(char c, size_type pos = 0) const { return find(c, pos); }
+
+    size_type find_last_of(StringView set, size_type pos = npos) const
+    {
+        if (len == 0)
+            return npos;
+        return to_index(__scan_set_reverse(ptr, ptr + min(pos, len - 1) + 1,
+                                           set.ptr, set.len, true));
+    }
+
+    size_type find_last_of(char c, size_type pos = npos) const { return rfind(c, pos); }
+
+    size_type find_first_not_of(StringView set, size_type pos = 0) const
+    {
+        if (pos >= len)
+            return npos;
+        return to_index(__scan_set(ptr + pos, ptr + len, set.ptr, set.len, false));
+    }
+
+    size_type find_first_not_of(char c, size_type pos = 0) const
+    {
+        return find_first_not_of(StringView(&c, 1), pos);
+    }
+
+    size_type find_last_not_of(StringView set, size_type pos = npos) const
+    {
+        if (len == 0)
+            return npos;
+        return to_index(__scan_set_reverse(ptr, ptr + min(pos, len - 1) + 1,
+                                           set.ptr, set.len, false));
+    }
+
+    size_type find_last_not_of(char c, size_type pos = npos) const
+    {
+        return find_last_not_of(StringView(&c, 1), pos);
+    }
+
+    bool contains(StringView v) const { return find(v) != npos; }
+    bool contains(char c) const { return len != 0 && memchr(ptr, c, len) != nullptr; }
+
+private:
+    size_type to_index(const char* p) const { return p == nullptr ? npos : p - ptr; }
+
+private:
+    const char* ptr;
+    size_type len;
+};
+
+inline bool operator==(StringView lhs, StringView rhs)
+{
+    // an empty view may have a null data(), which memcmp must not see
+    return lhs.size() == rhs.size()
+           && (lhs.size() == 0 || memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+inline bool operator!=(StringView lhs, StringView rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator<(StringView lhs, StringView rhs)
+{
+    return lhs.compare(rhs) < 0;
+}
+
+inline bool operator>(StringView lhs, StringView rhs)
+{
+    return rhs < lhs;
+}
+
+inline bool operator<=(StringView lhs, StringView rhs)
+{
+    return !(rhs < lhs);
+}
+
+inline bool operator>=(StringView lhs, StringView rhs)
+{
+    return !(lhs < rhs);
+}
+
+inline void swap(StringView& lhs, StringView& rhs)
+{
+    lhs.swap(rhs);
+}
+
+template <>
+struct hash<StringView>
+{
+    size_t operator()(StringView v) const { return hash_string(v.data(), v.size()); }
+};
+
+}
+
+#endif
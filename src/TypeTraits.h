@@ -342,6 +342,33 @@ struct _is_integer<unsigned long long>
     typedef _true_type integral;
 };
 
+template <bool Cond, typename T = void>
+struct _enable_if
+{
+};
+
+template <typename T>
+struct _enable_if<true, T>
+{
+    typedef T type;
+};
+
+// a function object is transparent when it declares a nested is_transparent type;
+// associative containers then accept any key type the functor can handle
+template <typename F>
+struct _is_transparent
+{
+private:
+    typedef char yes;
+    typedef char (&no)[2];
+
+    template <typename U> static yes test(typename U::is_transparent*);
+    template <typename U> static no test(...);
+
+public:
+    static const bool value = sizeof(test<F>(0)) == sizeof(yes);
+};
+
 }
 
 #endif
\ No newline at end of file
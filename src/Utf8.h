@@ -0,0 +1,494 @@
+#ifndef ZYX_UTF8
+#define ZYX_UTF8
+
+#include <cstring>
+#include "Iterator.h"
+#include "StringView.h"
+#include "StringScan.h"
+// the SSSE3 validator is compiled whenever the compiler can target it and
+// chosen at run time, so it needs no -mssse3 or /arch flag
+#if ZYX_SSE2 && (defined(__GNUC__) || defined(_MSC_VER))
+#define ZYX_SSSE3 1
+#include <tmmintrin.h>
+#if defined(__GNUC__) && !defined(__SSSE3__)
+#define __ZYX_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define __ZYX_TARGET_SSSE3
+#endif
+#endif
+
+namespace Zyx {
+
+// UTF-8 validation, transcoding to and from UTF-16 and UTF-32, and
+// iteration over code points. Valid UTF-8 here is RFC 3629: no overlong
+// forms, no surrogates, nothing above U+10FFFF.
+//
+// The transcoders write to a caller's buffer and, like to_chars, return
+// the end of the output or nullptr if the input is invalid. Output never
+// needs more than s.size() UTF-16 or UTF-32 units for UTF-8 input, nor
+// more than 3 bytes per UTF-16 unit or 4 per UTF-32 unit for UTF-8 output.
+
+// Decodes the sequence at p into cp and returns the byte after it, or
+// nullptr if the sequence is truncated, overlong, a surrogate or too large.
+inline const char* __utf8_decode(const char* p, const char* last, char32_t& cp)
+{
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(p);
+    const unsigned c = s[0];
+    if (c < 0x80) {
+        cp = c;
+        return p + 1;
+    }
+    if (c < 0xC2)    // a continuation byte or an overlong two-byte lead
+        return nullptr;
+    if (c < 0xE0) {
+        if (last - p < 2 || (s[1] & 0xC0) != 0x80)
+            return nullptr;
+        cp = ((c & 0x1F) << 6) | (s[1] & 0x3F);
+        return p + 2;
+    }
+    if (c < 0xF0) {
+        if (last - p < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80)
+            return nullptr;
+        cp = ((c & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        if (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))
+            return nullptr;
+        return p + 3;
+    }
+    if (c < 0xF5) {
+        if (last - p < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80
+                         || (s[3] & 0xC0) != 0x80)
+            return nullptr;
+        cp = ((c & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        if (cp < 0x10000 || cp > 0x10FFFF)
+            return nullptr;
+        return p + 4;
+    }
+    return nullptr;
+}
+
+// writes the encoding of cp, which must be a scalar value, at out
+inline char* __utf8_encode(char32_t cp, char* out)
+{
+    if (cp < 0x80) {
+        *out++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (cp >> 6));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (cp >> 18));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+// true if the 16 bytes at p are all ASCII
+inline bool __ascii_block(const char* p)
+{
+#if ZYX_SSE2
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0;
+#else
+    unsigned char bits = 0;
+    for (int i = 0; i < 16; ++i)
+        bits |= static_cast<unsigned char>(p[i]);
+    return bits < 0x80;
+#endif
+}
+
+// validation one sequence at a time, skipping ASCII blocks
+inline bool __utf8_valid_scalar(const char* p, const char* last)
+{
+    while (p != last) {
+        if (last - p >= 16 && __ascii_block(p)) {
+            p += 16;
+            continue;
+        }
+        const char* stop = last - p > 16 ? p + 16 : last;
+        while (p < stop) {
+            char32_t cp;
+            p = __utf8_decode(p, last, cp);
+            if (p == nullptr)
+                return false;
+        }
+    }
+    return true;
+}
+
+#if ZYX_SSSE3
+
+// The lookup method of Keiser and Lemire ("Validating UTF-8 in less than
+// one instruction per byte"). Every error shows up in some pair of adjacent
+// bytes, given by the high nibble of the first, its low nibble and the high
+// nibble of the second. Three 16-entry tables, applied with pshufb, map
+// each nibble to the set of errors it allows; the AND of the three is the
+// set of errors the pair actually has. Only the continuations a three- or
+// four-byte lead demands two and three bytes ahead need a separate check.
+enum {
+    __UTF8_TOO_SHORT = 1 << 0,      // 11______ 0_______ or 11______ 11______
+    __UTF8_TOO_LONG = 1 << 1,       // 0_______ 10______
+    __UTF8_OVERLONG_3 = 1 << 2,     // 11100000 100_____
+    __UTF8_TOO_LARGE = 1 << 3,      // 11110100 1001____ and above
+    __UTF8_SURROGATE = 1 << 4,      // 11101101 101_____
+    __UTF8_OVERLONG_2 = 1 << 5,     // 1100000_ 10______
+    __UTF8_TOO_LARGE_1000 = 1 << 6, // 11110101 1000____ and above
+    __UTF8_OVERLONG_4 = 1 << 6,     // 11110000 1000____
+    __UTF8_TWO_CONTS = 1 << 7,      // 10______ 10______
+    __UTF8_CARRY = __UTF8_TOO_SHORT | __UTF8_TOO_LONG | __UTF8_TWO_CONTS
+};
+
+__ZYX_TARGET_SSSE3 inline __m128i __high_nibbles(__m128i v)
+{
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+// the error bits of the 16 bytes of input, given the 16 before them
+__ZYX_TARGET_SSSE3 inline __m128i __utf8_block_errors(__m128i input, __m128i prev_input)
+{
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG,
+        __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG,
+        static_cast<char>(__UTF8_TWO_CONTS), static_cast<char>(__UTF8_TWO_CONTS),
+        static_cast<char>(__UTF8_TWO_CONTS), static_cast<char>(__UTF8_TWO_CONTS),
+        __UTF8_TOO_SHORT | __UTF8_OVERLONG_2,
+        __UTF8_TOO_SHORT,
+        __UTF8_TOO_SHORT | __UTF8_OVERLONG_3 | __UTF8_SURROGATE,
+        __UTF8_TOO_SHORT | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000 | __UTF8_OVERLONG_4);
+    const char large = static_cast<char>(__UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000);
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        static_cast<char>(__UTF8_CARRY | __UTF8_OVERLONG_3 | __UTF8_OVERLONG_2 | __UTF8_OVERLONG_4),
+        static_cast<char>(__UTF8_CARRY | __UTF8_OVERLONG_2),
+        static_cast<char>(__UTF8_CARRY),
+        static_cast<char>(__UTF8_CARRY),
+        static_cast<char>(__UTF8_CARRY | __UTF8_TOO_LARGE),
+        large, large, large, large, large, large, large, large,
+        static_cast<char>(large | __UTF8_SURROGATE),
+        large, large);
+    const char cont = static_cast<char>(__UTF8_TOO_LONG | __UTF8_OVERLONG_2 | __UTF8_TWO_CONTS);
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT,
+        __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT,
+        static_cast<char>(cont | __UTF8_OVERLONG_3 | __UTF8_TOO_LARGE_1000 | __UTF8_OVERLONG_4),
+        static_cast<char>(cont | __UTF8_OVERLONG_3 | __UTF8_TOO_LARGE),
+        static_cast<char>(cont | __UTF8_SURROGATE | __UTF8_TOO_LARGE),
+        static_cast<char>(cont | __UTF8_SURROGATE | __UTF8_TOO_LARGE),
+        __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT);
+
+    const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    const __m128i special = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(byte_1_high_table, __high_nibbles(prev1)),
+                      _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)))),
+        _mm_shuffle_epi8(byte_2_high_table, __high_nibbles(input)));
+
+    // 0x80 where a lead two or three bytes back needs a continuation here
+    const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    const __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+                                        _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80)));
+    const __m128i must23_80 = _mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must23_80, special);
+}
+
+// non-zero where the block ends inside a sequence
+__ZYX_TARGET_SSSE3 inline __m128i __utf8_incomplete(__m128i input)
+{
+    const __m128i max_value = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            static_cast<char>(0xF0 - 1),
+                                            static_cast<char>(0xE0 - 1),
+                                            static_cast<char>(0xC0 - 1));
+    return _mm_subs_epu8(input, max_value);
+}
+
+__ZYX_TARGET_SSSE3 inline bool __utf8_valid_ssse3(const char* p, const char* last)
+{
+    __m128i error = _mm_setzero_si128();
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    char tail[16];
+    for (;;) {
+        __m128i input;
+        const bool at_end = last - p < 16;
+        if (at_end) {
+            // zero padding is ASCII, which ends any open sequence too early
+            memset(tail, 0, sizeof(tail));
+            if (p != last)
+                memcpy(tail, p, last - p);
+            input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+        } else {
+            input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            p += 16;
+        }
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, prev_incomplete);
+        } else {
+            error = _mm_or_si128(error, __utf8_block_errors(input, prev_input));
+            prev_incomplete = __utf8_incomplete(input);
+        }
+        prev_input = input;
+        if (at_end)
+            break;
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+inline bool __cpu_has_ssse3()
+{
+#if defined(__SSSE3__)
+    return true;
+#elif defined(__GNUC__)
+    return __builtin_cpu_supports("ssse3");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#endif
+}
+
+#endif
+
+// true if s is valid UTF-8
+inline bool is_valid_utf8(StringView s)
+{
+#if ZYX_SSSE3
+    static const bool use_ssse3 = __cpu_has_ssse3();
+    if (use_ssse3)
+        return __utf8_valid_ssse3(s.begin(), s.end());
+#endif
+    return __utf8_valid_scalar(s.begin(), s.end());
+}
+
+// the number of code points in s, which must be valid UTF-8
+inline size_t utf8_length(StringView s)
+{
+    const char* p = s.begin();
+    const char* last = s.end();
+    size_t n = 0;
+#if ZYX_SSE2
+    // lead bytes are those above 0xBF as signed bytes are above -65; the
+    // per-lane counters are summed before they can overflow
+    const __m128i limit = _mm_set1_epi8(-65);
+    while (last - p >= 16) {
+        __m128i counts = _mm_setzero_si128();
+        for (int i = 0; i < 255 && last - p >= 16; ++i, p += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(v, limit));
+        }
+        const __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+        n += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+#endif
+    for (; p != last; ++p)
+        n += static_cast<signed char>(*p) > -65;
+    return n;
+}
+
+// UTF-8 to UTF-16 with surrogate pairs; out needs room for s.size() units
+inline char16_t* utf8_to_utf16(StringView s, char16_t* out)
+{
+    const char* p = s.begin();
+    const char* last = s.end();
+    while (p != last) {
+        if (last - p >= 16 && __ascii_block(p)) {
+#if ZYX_SSE2
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i zero = _mm_setzero_si128();
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(v, zero));
+#else
+            for (int i = 0; i < 16; ++i)
+                out[i] = static_cast<char16_t>(p[i]);
+#endif
+            p += 16;
+            out += 16;
+            continue;
+        }
+        const char* stop = last - p > 16 ? p + 16 : last;
+        while (p < stop) {
+            char32_t cp;
+            p = __utf8_decode(p, last, cp);
+            if (p == nullptr)
+                return nullptr;
+            if (cp < 0x10000) {
+                *out++ = static_cast<char16_t>(cp);
+            } else {
+                cp -= 0x10000;
+                *out++ = static_cast<char16_t>(0xD800 + (cp >> 10));
+                *out++ = static_cast<char16_t>(0xDC00 + (cp & 0x3FF));
+            }
+        }
+    }
+    return out;
+}
+
+// UTF-8 to UTF-32; out needs room for s.size() units
+inline char32_t* utf8_to_utf32(StringView s, char32_t* out)
+{
+    const char* p = s.begin();
+    const char* last = s.end();
+    while (p != last) {
+        if (last - p >= 16 && __ascii_block(p)) {
+#if ZYX_SSE2
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i lo = _mm_unpacklo_epi8(v, zero);
+            const __m128i hi = _mm_unpackhi_epi8(v, zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(hi, zero));
+#else
+            for (int i = 0; i < 16; ++i)
+                out[i] = static_cast<char32_t>(p[i]);
+#endif
+            p += 16;
+            out += 16;
+            continue;
+        }
+        const char* stop = last - p > 16 ? p + 16 : last;
+        while (p < stop) {
+            p = __utf8_decode(p, last, *out);
+            if (p == nullptr)
+                return nullptr;
+            ++out;
+        }
+    }
+    return out;
+}
+
+// UTF-16 to UTF-8; unpaired surrogates are invalid, and out needs room for
+// 3 bytes per unit
+inline char* utf16_to_utf8(const char16_t* first, const char16_t* last, char* out)
+{
+    while (first != last) {
+#if ZYX_SSE2
+        if (last - first >= 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(-0x80)),
+                                                  _mm_setzero_si128())) == 0xFFFF) {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(v, v));
+                first += 8;
+                out += 8;
+                continue;
+            }
+        }
+#endif
+        char32_t cp = *first++;
+        if (cp >= 0xD800 && cp <= 0xDFFF) {
+            if (cp >= 0xDC00 || first == last || *first < 0xDC00 || *first > 0xDFFF)
+                return nullptr;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (*first++ - 0xDC00);
+        }
+        out = __utf8_encode(cp, out);
+    }
+    return out;
+}
+
+// UTF-32 to UTF-8; surrogates and values above U+10FFFF are invalid, and
+// out needs room for 4 bytes per unit
+inline char* utf32_to_utf8(const char32_t* first, const char32_t* last, char* out)
+{
+    for (; first != last; ++first) {
+        const char32_t cp = *first;
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            return nullptr;
+        out = __utf8_encode(cp, out);
+    }
+    return out;
+}
+
+// Yields the code points of a UTF-8 range. A byte that does not start a
+// valid sequence yields U+FFFD and is skipped alone, so iteration always
+// advances and ends, whatever the input.
+class Utf8Iterator
+{
+public:
+    typedef forward_iterator_tag    iterator_category;
+    typedef char32_t                value_type;
+    typedef const char32_t*         pointer;
+    typedef char32_t                reference;
+    typedef ptrdiff_t               difference_type;
+
+    typedef Utf8Iterator    self;
+
+public:
+    Utf8Iterator() : cur(nullptr), next(nullptr), last(nullptr), cp(0) { }
+
+    Utf8Iterator(const char* first, const char* last_) : cur(first), last(last_)
+    {
+        decode();
+    }
+
+public:
+    bool operator==(const self& x) const { return cur == x.cur; }
+    bool operator!=(const self& x) const { return cur != x.cur; }
+
+    reference operator*() const { return cp; }
+
+    // the bytes of the current code point
+    const char* base() const { return cur; }
+    size_t width() const { return next - cur; }
+
+    self& operator++()
+    {
+        cur = next;
+        decode();
+        return *this;
+    }
+
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+private:
+    void decode()
+    {
+        if (cur == last) {
+            next = last;
+            return;
+        }
+        next = __utf8_decode(cur, last, cp);
+        if (next == nullptr) {
+            next = cur + 1;
+            cp = 0xFFFD;
+        }
+    }
+
+private:
+    const char* cur;
+    const char* next;
+    const char* last;
+    char32_t cp;
+};
+
+// a begin/end pair for range-based for
+class Utf8Range
+{
+public:
+    typedef Utf8Iterator    iterator;
+
+    Utf8Range(const char* first_, const char* last_) : first(first_), last(last_) { }
+
+    iterator begin() const { return iterator(first, last); }
+    iterator end() const { return iterator(last, last); }
+
+private:
+    const char* first;
+    const char* last;
+};
+
+// the code points of s
+inline Utf8Range code_points(StringView s)
+{
+    return Utf8Range(s.begin(), s.end());
+}
+
+}
+
+#endif
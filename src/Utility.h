@@ -2,9 +2,26 @@
 #define ZYX_UTILITY 
 
 #include <cstddef>
+#include <utility>
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#endif
 
 namespace Zyx {
 
+// asks the cache to start loading the line at p; only a hint, so p may be 
+// null or dangling
+inline void __prefetch(const void* p)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
 template <typename T>
 void swap(T& a, T& b)
 {
@@ -45,6 +62,10 @@ struct Pair
 
     Pair(const first_type& a, const second_type& b) : first(a), second(b) { }
 
+    // b is moved in when it is an rvalue
+    template <typename V>
+    Pair(const first_type& a, V&& b) : first(a), second(std::forward<V>(b)) { }
+
     Pair(const Pair& pr) : first(pr.first), second(pr.second) { }
 
     template <typename U, typename V>
@@ -0,0 +1,179 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdlib>
+#include "../src/BTree.h"
+#include "../src/BTreeMap.h"
+#include "../src/BTreeSet.h"
+#include "../src/Functional.h"
+
+// 64-byte nodes hold 12 ints, so a few thousand values make a deep tree
+typedef Zyx::BTree<int, int, Zyx::identity<int>, Zyx::less<int>, Zyx::alloc, 64> SmallTree;
+typedef Zyx::BTree<int, int, Zyx::identity<int>, Zyx::less<int> > IntTree;
+
+TEST_CASE("test BTreeMap.h", "[BTreeMap]")
+{
+    SECTION("test insert and operator[] function")
+    {
+        Zyx::BTreeMap<int, int> m;
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE(m.insert(Zyx::make_pair(i, i * 2)).second);
+        REQUIRE(!m.insert(Zyx::make_pair(10, 0)).second);
+        m[10] += 1;
+        m[2000] = 5;
+        REQUIRE(m.size() == 1001);
+        REQUIRE(m.find(10)->second == 21);
+        REQUIRE(m.find(2000)->second == 5);
+        REQUIRE(m.find(1500) == m.end());
+    }
+
+    SECTION("test iterator function")
+    {
+        Zyx::BTreeMap<int, int> m;
+        for (int i = 999; i >= 0; --i)
+            m.insert(Zyx::make_pair(i, i));
+        int expect = 0;
+        for (Zyx::BTreeMap<int, int>::iterator it = m.begin(); it != m.end(); ++it)
+            REQUIRE(it->first == expect++);
+        REQUIRE(expect == 1000);
+        Zyx::BTreeMap<int, int>::iterator it = m.end();
+        while (it != m.begin())
+            REQUIRE((--it)->first == --expect);
+        REQUIRE(expect == 0);
+    }
+
+    SECTION("test lower_bound and upper_bound function")
+    {
+        Zyx::BTreeMap<int, int> m;
+        for (int i = 0; i < 1000; i += 2)
+            m.insert(Zyx::make_pair(i, i));
+        REQUIRE(m.lower_bound(101)->first == 102);
+        REQUIRE(m.lower_bound(100)->first == 100);
+        REQUIRE(m.upper_bound(100)->first == 102);
+        REQUIRE(m.lower_bound(999) == m.end());
+        REQUIRE(m.count(100) == 1);
+        REQUIRE(m.count(101) == 0);
+    }
+
+    SECTION("test erase function")
+    {
+        Zyx::BTreeMap<int, int> m;
+        for (int i = 0; i < 1000; ++i)
+            m.insert(Zyx::make_pair(i, i));
+        for (int i = 0; i < 1000; i += 2)
+            REQUIRE(m.erase(i) == 1);
+        REQUIRE(m.erase(0) == 0);
+        REQUIRE(m.size() == 500);
+        Zyx::BTreeMap<int, int>::iterator it = m.erase(m.find(11));
+        REQUIRE(it->first == 13);
+        m.erase(m.lower_bound(100), m.lower_bound(200));
+        REQUIRE(m.size() == 449);
+        REQUIRE(m.lower_bound(100)->first == 201);
+        m.erase(m.begin(), m.end());
+        REQUIRE(m.empty());
+        REQUIRE(m.begin() == m.end());
+    }
+
+    SECTION("test copy and compare function")
+    {
+        Zyx::BTreeMap<int, int> m1;
+        for (int i = 0; i < 1000; ++i)
+            m1.insert(Zyx::make_pair(i, i));
+        Zyx::BTreeMap<int, int> m2(m1);
+        REQUIRE(m1 == m2);
+        m2[5] = 0;
+        REQUIRE(m2 < m1);
+        m1.swap(m2);
+        REQUIRE(m1.find(5)->second == 0);
+    }
+}
+
+TEST_CASE("test BTreeSet.h", "[BTreeSet]")
+{
+    SECTION("test BTreeSet function")
+    {
+        int a[] = { 5, 3, 9, 1, 3, 7 };
+        Zyx::BTreeSet<int> s(a, a + 6);
+        REQUIRE(s.size() == 5);
+        REQUIRE(*s.begin() == 1);
+        REQUIRE(!s.insert(9).second);
+        REQUIRE(s.erase(3) == 1);
+        REQUIRE(s.count(3) == 0);
+    }
+
+    SECTION("test BTreeMultiSet function")
+    {
+        Zyx::BTreeMultiSet<int> s;
+        for (int i = 0; i < 1000; ++i)
+            s.insert(i % 10);
+        REQUIRE(s.size() == 1000);
+        REQUIRE(s.count(4) == 100);
+        REQUIRE(s.erase(4) == 100);
+        REQUIRE(s.count(4) == 0);
+        REQUIRE(*s.lower_bound(4) == 5);
+
+        Zyx::BTreeMultiSet<int> same;
+        for (int i = 0; i < 10000; ++i)
+            same.insert(7);
+        same.insert(8);
+        Zyx::BTreeMultiSet<int>::iterator first = same.begin();
+        for (int i = 0; i < 5000; ++i)
+            ++first;
+        Zyx::BTreeMultiSet<int>::iterator last = same.end();
+        same.erase(first, --last);
+        REQUIRE(same.size() == 5001);
+        REQUIRE(same.count(7) == 5000);
+        REQUIRE(*same.erase(same.begin()) == 7);
+    }
+
+    SECTION("test node fill and structure after every insert and erase")
+    {
+        SmallTree up, down;
+        for (int i = 0; i < 2000; ++i) {
+            up.insert_unique(i);
+            down.insert_unique(-i);
+            REQUIRE(up.__btree_verify());
+            REQUIRE(down.__btree_verify());
+        }
+
+        // appending to the end of leaves inside the tree must split them evenly
+        SmallTree gaps;
+        for (int i = 0; i < 100; ++i)
+            gaps.insert_unique(i * 100);
+        for (int i = 0; i < 100; ++i) {
+            for (int j = 1; j < 40; ++j) {
+                gaps.insert_unique(i * 100 + j);
+                REQUIRE(gaps.__btree_verify());
+            }
+        }
+        REQUIRE(gaps.size() == 4000);
+
+        srand(31);
+        SmallTree t;
+        IntTree wide;
+        for (int i = 0; i < 5000; ++i) {
+            const int k = rand() % 1000;
+            if (rand() % 3 == 0) {
+                t.erase(k);
+                wide.erase(k);
+            } else {
+                t.insert_equal(k);
+                wide.insert_equal(k);
+            }
+            REQUIRE(t.__btree_verify());
+            REQUIRE(wide.__btree_verify());
+        }
+        SmallTree copy(t);
+        REQUIRE(copy.__btree_verify());
+        REQUIRE((copy == t));
+
+        // draining sorted trees from either end
+        while (!up.empty()) {
+            up.erase(up.begin());
+            down.erase(--down.end());
+            REQUIRE(up.__btree_verify());
+            REQUIRE(down.__btree_verify());
+        }
+        REQUIRE(down.empty());
+    }
+}
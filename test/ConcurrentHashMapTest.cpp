@@ -0,0 +1,120 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdio>
+#include <thread>
+#include "../src/ConcurrentHashMap.h"
+#include "../src/String.h"
+
+struct add_second
+{
+    int* sum;
+    explicit add_second(int* s) : sum(s) { }
+    void operator()(const Zyx::Pair<const int, int>& val) const { *sum += val.second; }
+};
+
+struct count_shard
+{
+    size_t* total;
+    explicit count_shard(size_t* t) : total(t) { }
+    template <typename Table>
+    void operator()(const Table& table) const { *total += table.size(); }
+};
+
+TEST_CASE("test ConcurrentHashMap.h", "[ConcurrentHashMap]")
+{
+    SECTION("test ConcurrentHashMap(size_type n_shards) function")
+    {
+        Zyx::ConcurrentHashMap<int, int> m(10);
+        REQUIRE(m.shard_count() == 16);
+        REQUIRE(m.empty());
+    }
+
+    SECTION("test insert and insert_or_assign function")
+    {
+        Zyx::ConcurrentHashMap<int, int> m;
+        REQUIRE(m.insert(Zyx::make_pair(1, 10)));
+        REQUIRE(!m.insert(Zyx::make_pair(1, 20)));
+        REQUIRE(!m.insert_or_assign(1, 30));
+        REQUIRE(m.insert_or_assign(2, 40));
+        int val = 0;
+        REQUIRE(m.find(1, val));
+        REQUIRE(val == 30);
+        REQUIRE(!m.find(3, val));
+        REQUIRE(m.size() == 2);
+    }
+
+    SECTION("test find_and_apply and for_each_shard function")
+    {
+        Zyx::ConcurrentHashMap<int, int> m(4);
+        for (int i = 0; i < 100; ++i)
+            m.insert_or_assign(i, i * 2);
+        int sum = 0;
+        REQUIRE(m.find_and_apply(21, add_second(&sum)));
+        REQUIRE(sum == 42);
+        REQUIRE(!m.find_and_apply(200, add_second(&sum)));
+        size_t total = 0;
+        m.for_each_shard(count_shard(&total));
+        REQUIRE(total == 100);
+    }
+
+    SECTION("test erase and clear function")
+    {
+        Zyx::ConcurrentHashMap<int, int> m;
+        for (int i = 0; i < 100; ++i)
+            m.insert_or_assign(i, i);
+        REQUIRE(m.erase(5) == 1);
+        REQUIRE(m.erase(5) == 0);
+        REQUIRE(m.count(5) == 0);
+        REQUIRE(m.size() == 99);
+        m.clear();
+        REQUIRE(m.empty());
+    }
+
+    SECTION("test concurrent insert_or_assign and find function")
+    {
+        Zyx::ConcurrentHashMap<int, int> m;
+        std::thread threads[4];
+        for (int t = 0; t < 4; ++t) {
+            threads[t] = std::thread([&m, t]() {
+                for (int i = 0; i < 10000; ++i) {
+                    m.insert_or_assign(t * 10000 + i, i);
+                    int val = 0;
+                    m.find(t * 10000 + i / 2, val);
+                }
+            });
+        }
+        for (int t = 0; t < 4; ++t)
+            threads[t].join();
+        REQUIRE(m.size() == 40000);
+    }
+
+    SECTION("test concurrent use with heap-allocated String keys")
+    {
+        Zyx::ConcurrentHashMap<Zyx::String, int> m;
+        std::thread threads[4];
+        for (int t = 0; t < 4; ++t) {
+            threads[t] = std::thread([&m, t]() {
+                char key[64];
+                for (int i = 0; i < 5000; ++i) {
+                    // every thread inserts and erases keys the others touch
+                    int n = snprintf(key, sizeof(key), "a key longer than the local buffer %d", i);
+                    m.insert_or_assign(Zyx::String(key, n), t);
+                    n = snprintf(key, sizeof(key), "a key longer than the local buffer %d", (i + 2500) % 5000);
+                    m.erase(Zyx::String(key, n));
+                }
+            });
+        }
+        for (int t = 0; t < 4; ++t)
+            threads[t].join();
+        for (int i = 0; i < 5000; ++i) {
+            char key[64];
+            const int n = snprintf(key, sizeof(key), "a key longer than the local buffer %d", i);
+            m.insert_or_assign(Zyx::String(key, n), i);
+        }
+        REQUIRE(m.size() == 5000);
+        int val = 0;
+        REQUIRE(m.find(Zyx::String("a key longer than the local buffer 4999"), val));
+        REQUIRE(val == 4999);
+    }
+}
@@ -0,0 +1,127 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdlib>
+#include "../src/IntervalMap.h"
+#include "../src/Vector.h"
+
+typedef Zyx::IntervalMap<int, int> Intervals;
+
+// the entries meeting [lo, hi], found by a scan in interval order
+static Zyx::Vector<Intervals::const_iterator> brute_overlapping(const Intervals& m, int lo, int hi)
+{
+    Zyx::Vector<Intervals::const_iterator> result;
+    for (Intervals::const_iterator it = m.begin(); it != m.end(); ++it) {
+        if (it->first.first <= hi && lo <= it->first.second)
+            result.push_back(it);
+    }
+    return result;
+}
+
+static bool same_entries(const Zyx::Vector<Intervals::const_iterator>& a,
+                         const Zyx::Vector<Intervals::const_iterator>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+// compares every query with the scan for a spread of ranges and points
+static void check_queries(const Intervals& m)
+{
+    for (int q = 0; q < 200; ++q) {
+        const int lo = rand() % 1100 - 50;
+        const int hi = lo + rand() % (q % 2 == 0 ? 10 : 200);
+        Zyx::Vector<Intervals::const_iterator> expect = brute_overlapping(m, lo, hi);
+
+        Zyx::Vector<Intervals::const_iterator> got;
+        m.overlapping(lo, hi, Zyx::back_inserter(got));
+        REQUIRE(same_entries(got, expect));
+
+        Intervals::const_iterator first = m.find_overlapping(lo, hi);
+        REQUIRE((expect.empty() ? first == m.end() : first == expect[0]));
+        REQUIRE(m.overlaps(lo, hi) == !expect.empty());
+
+        Zyx::Vector<Intervals::const_iterator> stabbed;
+        m.stabbing(lo, Zyx::back_inserter(stabbed));
+        REQUIRE(same_entries(stabbed, brute_overlapping(m, lo, lo)));
+    }
+}
+
+struct short_interval
+{
+    bool operator()(const Intervals::value_type& val) const
+    {
+        return val.first.second - val.first.first < 20;
+    }
+};
+
+TEST_CASE("test IntervalMap.h", "[IntervalMap]")
+{
+    SECTION("test insert and queries on a few intervals")
+    {
+        Intervals m;
+        m.insert(10, 20, 1);
+        m.insert(15, 25, 2);
+        m.insert(30, 40, 3);
+        m.insert(10, 20, 4);
+        REQUIRE(m.size() == 4);
+        REQUIRE(m.count(Intervals::key_type(10, 20)) == 2);
+        REQUIRE(m.overlaps(20, 20));
+        REQUIRE(m.overlaps(25, 30));
+        REQUIRE(!m.overlaps(26, 29));
+        REQUIRE(!m.overlaps(41, 100));
+        REQUIRE(m.find_overlapping(21, 35)->second == 2);
+        REQUIRE(m.find_overlapping(26, 29) == m.end());
+
+        Zyx::Vector<Intervals::iterator> hits;
+        m.stabbing(18, Zyx::back_inserter(hits));
+        REQUIRE(hits.size() == 3);
+        REQUIRE(hits[2]->second == 2);
+    }
+
+    SECTION("test queries against a scan after insert, erase and copy")
+    {
+        srand(37);
+        Intervals m;
+        for (int i = 0; i < 2000; ++i) {
+            const int lo = rand() % 1000;
+            const int len = i % 10 == 0 ? rand() % 500 : rand() % 30;
+            if (i % 3 == 0)
+                m.insert(m.begin(), Intervals::value_type(Intervals::key_type(lo, lo + len), i));
+            else
+                m.insert(lo, lo + len, i);
+        }
+        check_queries(m);
+
+        // erase by iterator, by key, by range and by predicate
+        for (int i = 0; i < 300; ++i) {
+            Intervals::iterator it = m.find_overlapping(rand() % 1000, 1000);
+            if (it != m.end())
+                m.erase(it);
+        }
+        for (int i = 0; i < 100; ++i)
+            m.erase(m.begin()->first);
+        Intervals::iterator first = m.find_overlapping(400, 400);
+        Intervals::iterator last = first;
+        for (int i = 0; i < 100 && last != m.end(); ++i)
+            ++last;
+        m.erase(first, last);
+        m.erase_if(short_interval());
+        check_queries(m);
+
+        Intervals copy(m);
+        REQUIRE(copy == m);
+        check_queries(copy);
+        Intervals assigned;
+        assigned.insert(0, 1000, -1);
+        assigned = copy;
+        check_queries(assigned);
+        copy.clear();
+        check_queries(m);
+    }
+}
@@ -0,0 +1,162 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include "../src/LockFreeHashSet.h"
+#include "../src/LockFreeHashMap.h"
+#include "../src/String.h"
+
+struct add_value
+{
+    long* sum;
+    explicit add_value(long* s) : sum(s) { }
+    void operator()(int val) const { *sum += val; }
+};
+
+struct counted
+{
+    static int copies;
+    int val;
+    explicit counted(int v) : val(v) { }
+    counted(const counted& x) : val(x.val) { ++copies; }
+};
+
+int counted::copies = 0;
+
+inline bool operator==(const counted& lhs, const counted& rhs) { return lhs.val == rhs.val; }
+
+struct counted_hash
+{
+    size_t operator()(const counted& x) const { return static_cast<size_t>(x.val); }
+};
+
+TEST_CASE("test LockFreeHashSet.h", "[LockFreeHashSet]")
+{
+    SECTION("test insert, erase and contains function")
+    {
+        Zyx::LockFreeHashSet<int> s;
+        REQUIRE(s.empty());
+        REQUIRE(s.insert(1));
+        REQUIRE(!s.insert(1));
+        REQUIRE(s.insert(2));
+        REQUIRE(s.contains(1));
+        REQUIRE(s.count(2) == 1);
+        REQUIRE(!s.contains(3));
+        REQUIRE(s.erase(1) == 1);
+        REQUIRE(s.erase(1) == 0);
+        REQUIRE(!s.contains(1));
+        REQUIRE(s.insert(1));
+        REQUIRE(s.size() == 2);
+    }
+
+    SECTION("test bucket growth")
+    {
+        Zyx::LockFreeHashSet<int> s(4);
+        const size_t initial = s.bucket_count();
+        for (int i = 0; i < 10000; ++i)
+            REQUIRE(s.insert(i));
+        REQUIRE(s.bucket_count() > initial);
+        REQUIRE(s.size() == 10000);
+        for (int i = 0; i < 10000; ++i)
+            REQUIRE(s.contains(i));
+        for (int i = 0; i < 10000; i += 2)
+            REQUIRE(s.erase(i) == 1);
+        REQUIRE(s.size() == 5000);
+        REQUIRE(!s.contains(5000));
+        REQUIRE(s.contains(5001));
+    }
+
+    SECTION("test for_each and find_and_apply function")
+    {
+        Zyx::LockFreeHashSet<int> s;
+        for (int i = 1; i <= 100; ++i)
+            s.insert(i);
+        s.erase(50);
+        long sum = 0;
+        s.for_each(add_value(&sum));
+        REQUIRE(sum == 5050 - 50);
+        sum = 0;
+        REQUIRE(s.find_and_apply(21, add_value(&sum)));
+        REQUIRE(sum == 21);
+        REQUIRE(!s.find_and_apply(50, add_value(&sum)));
+        REQUIRE(sum == 21);
+    }
+
+    SECTION("test concurrent insert, erase and contains function")
+    {
+        Zyx::LockFreeHashSet<int> s;
+        std::atomic<int> misses(0);
+        std::thread threads[4];
+        for (int t = 0; t < 4; ++t) {
+            threads[t] = std::thread([&s, &misses, t]() {
+                for (int i = 0; i < 10000; ++i) {
+                    s.insert(t * 10000 + i);
+                    if (!s.contains(t * 10000 + i))
+                        ++misses;
+                    if (i % 2 == 1)
+                        s.erase(t * 10000 + i - 1);
+                    s.contains((t + 1) % 4 * 10000 + i);
+                }
+            });
+        }
+        for (int t = 0; t < 4; ++t)
+            threads[t].join();
+        REQUIRE(misses == 0);
+        REQUIRE(s.size() == 20000);
+        for (int t = 0; t < 4; ++t) {
+            REQUIRE(!s.contains(t * 10000));
+            REQUIRE(s.contains(t * 10000 + 1));
+        }
+    }
+
+    SECTION("test duplicate insert copies nothing")
+    {
+        Zyx::LockFreeHashSet<counted, counted_hash> s;
+        REQUIRE(s.insert(counted(7)));
+        const int copies = counted::copies;
+        REQUIRE(!s.insert(counted(7)));
+        REQUIRE(counted::copies == copies);
+    }
+
+    SECTION("test concurrent use with heap-allocated String values")
+    {
+        Zyx::LockFreeHashSet<Zyx::String> s;
+        std::thread threads[4];
+        for (int t = 0; t < 4; ++t) {
+            threads[t] = std::thread([&s]() {
+                char text[64];
+                for (int i = 0; i < 5000; ++i) {
+                    // erased strings are destroyed on whichever thread reclaims them
+                    int n = snprintf(text, sizeof(text), "a value longer than the local buffer %d", i);
+                    s.insert(Zyx::String(text, n));
+                    n = snprintf(text, sizeof(text), "a value longer than the local buffer %d", (i + 2500) % 5000);
+                    s.erase(Zyx::String(text, n));
+                }
+            });
+        }
+        for (int t = 0; t < 4; ++t)
+            threads[t].join();
+        REQUIRE(s.size() <= 5000);
+        s.insert(Zyx::String("a value longer than the local buffer 4999"));
+        REQUIRE(s.contains(Zyx::String("a value longer than the local buffer 4999")));
+    }
+}
+
+TEST_CASE("test LockFreeHashMap.h", "[LockFreeHashMap]")
+{
+    SECTION("test insert, find and erase function")
+    {
+        Zyx::LockFreeHashMap<int, int> m;
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE(m.insert(Zyx::make_pair(i, i * 2)));
+        REQUIRE(!m.insert(Zyx::make_pair(5, 0)));
+        int val = 0;
+        REQUIRE(m.find(5, val));
+        REQUIRE(val == 10);
+        REQUIRE(m.erase(5) == 1);
+        REQUIRE(!m.find(5, val));
+        REQUIRE(m.size() == 999);
+    }
+}
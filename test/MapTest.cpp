@@ -0,0 +1,263 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+#include "../src/Map.h"
+#include "../src/MultiMap.h"
+#include "../src/Set.h"
+#include "../src/MultiSet.h"
+#include "../src/HashMap.h"
+#include "../src/HashSet.h"
+#include "../src/String.h"
+#include "../src/Vector.h"
+#include "../src/Algorithm.h"
+
+// counts how it was constructed, and throws from its constructors on request
+struct tracked
+{
+    static int constructed;
+    static int copied;
+    static int moved;
+    static bool throwing;
+
+    int val;
+
+    tracked() : val(0) { created(); }
+    tracked(int v) : val(v) { created(); }
+    tracked(const tracked& x) : val(x.val) { created(); ++copied; }
+    tracked(tracked&& x) : val(x.val) { created(); ++moved; }
+    tracked& operator=(const tracked& x) { val = x.val; ++copied; return *this; }
+    tracked& operator=(tracked&& x) { val = x.val; ++moved; return *this; }
+
+    static void reset() { constructed = copied = moved = 0; throwing = false; }
+
+private:
+    static void created()
+    {
+        if (throwing)
+            throw std::runtime_error("tracked");
+        ++constructed;
+    }
+};
+
+int tracked::constructed = 0;
+int tracked::copied = 0;
+int tracked::moved = 0;
+bool tracked::throwing = false;
+
+typedef Zyx::Map<int, tracked> TrackedMap;
+
+// malloc_alloc that counts the blocks it has out
+struct counting_alloc
+{
+    static int blocks;
+
+    static void* allocate(size_t n)
+    {
+        ++blocks;
+        return Zyx::malloc_alloc::allocate(n);
+    }
+
+    static void deallocate(void* p, size_t n)
+    {
+        --blocks;
+        Zyx::malloc_alloc::deallocate(p, n);
+    }
+};
+
+int counting_alloc::blocks = 0;
+
+// a lookup key no container key converts from
+struct stranger { };
+
+// whether c.find(k) names a usable overload
+template <typename C, typename K>
+static auto offers_find(const C& c, const K& k, int) -> decltype(c.find(k), true)
+{
+    return true;
+}
+
+template <typename C, typename K>
+static bool offers_find(const C&, const K&, long)
+{
+    return false;
+}
+
+TEST_CASE("test Map.h", "[Map]")
+{
+    SECTION("test hinted insert with good and bad hints")
+    {
+        srand(33);
+        Zyx::Map<int, int> m;
+        Zyx::Set<int> s;
+        Zyx::Vector<int> ref;
+        for (int i = 0; i < 2000; ++i) {
+            const int k = rand() % 1500;
+            switch (i % 4) {
+            case 0:    // the right hint
+                m.insert(m.lower_bound(k), Zyx::make_pair(k, i));
+                s.insert(s.lower_bound(k), k);
+                break;
+            case 1:    // a hint past the slot
+                m.insert(m.end(), Zyx::make_pair(k, i));
+                s.insert(s.end(), k);
+                break;
+            case 2:    // a hint before the slot
+                m.insert(m.begin(), Zyx::make_pair(k, i));
+                s.insert(s.begin(), k);
+                break;
+            default:
+                m.insert(Zyx::make_pair(k, i));
+                s.insert(k);
+                break;
+            }
+            if (Zyx::find(ref.begin(), ref.end(), k) == ref.end())
+                ref.insert(Zyx::upper_bound(ref.begin(), ref.end(), k), k);
+        }
+        REQUIRE(m.size() == ref.size());
+        REQUIRE(Zyx::equal(s.begin(), s.end(), ref.begin()));
+        int i = 0;
+        for (Zyx::Map<int, int>::iterator it = m.begin(); it != m.end(); ++it)
+            REQUIRE(it->first == ref[i++]);
+
+        // an existing key returns its element and keeps the old value
+        Zyx::Map<int, int>::iterator it = m.insert(m.end(), Zyx::make_pair(ref[0], -1));
+        REQUIRE(it == m.begin());
+        REQUIRE(it->second != -1);
+
+        // appending increasing keys at end() keeps equal keys in order
+        Zyx::MultiMap<int, int> mm;
+        Zyx::MultiSet<int> ms;
+        for (int k = 0; k < 1000; ++k) {
+            mm.insert(mm.end(), Zyx::make_pair(k / 3, k));
+            ms.insert(ms.begin(), 999 - k);
+        }
+        int expect = 0;
+        for (Zyx::MultiMap<int, int>::iterator p = mm.begin(); p != mm.end(); ++p)
+            REQUIRE(p->second == expect++);
+        REQUIRE(ms.size() == 1000);
+        REQUIRE(*ms.begin() == 0);
+        REQUIRE(*--ms.end() == 999);
+    }
+
+    SECTION("test try_emplace and operator[] construct only for new keys")
+    {
+        TrackedMap m;
+        tracked::reset();
+        REQUIRE(m.try_emplace(1, 10).second);
+        REQUIRE(tracked::constructed == 1);
+        REQUIRE(!m.try_emplace(1, 20).second);
+        REQUIRE(tracked::constructed == 1);
+        REQUIRE(m[1].val == 10);
+        REQUIRE(tracked::constructed == 1);
+
+        REQUIRE(m[2].val == 0);
+        REQUIRE(m.size() == 2);
+        m[2].val = 5;
+        REQUIRE(m.find(2)->second.val == 5);
+
+        // an rvalue argument is moved into the element, not copied
+        tracked::reset();
+        tracked v(7);
+        REQUIRE(m.try_emplace(3, static_cast<tracked&&>(v)).second);
+        REQUIRE(tracked::copied == 0);
+        REQUIRE(tracked::moved == 1);
+        REQUIRE(m.try_emplace(m.end(), 4, tracked(8))->second.val == 8);
+        REQUIRE(tracked::copied == 0);
+        REQUIRE(m.try_emplace(m.begin(), 4, tracked(9))->second.val == 8);
+    }
+
+    SECTION("test insert_or_assign function")
+    {
+        TrackedMap m;
+        tracked::reset();
+        REQUIRE(m.insert_or_assign(1, tracked(1)).second);
+        REQUIRE(!m.insert_or_assign(1, tracked(2)).second);
+        REQUIRE(m[1].val == 2);
+        REQUIRE(tracked::copied == 0);
+
+        const tracked c(3);
+        TrackedMap::iterator it = m.insert_or_assign(m.end(), 5, c);
+        REQUIRE(it->second.val == 3);
+        REQUIRE(tracked::copied == 1);
+        it = m.insert_or_assign(m.begin(), 5, tracked(4));
+        REQUIRE(it->second.val == 4);
+        REQUIRE(m.size() == 2);
+    }
+
+    SECTION("test a throwing constructor leaves the map unchanged")
+    {
+        Zyx::Map<int, tracked, Zyx::less<int>, counting_alloc> m;
+        m.try_emplace(1, 1);
+        const int blocks = counting_alloc::blocks;
+        tracked::reset();
+        tracked::throwing = true;
+        REQUIRE_THROWS(m.try_emplace(2, 2));
+        REQUIRE_THROWS(m[3]);
+        REQUIRE_THROWS(m.insert_or_assign(4, 4));
+        tracked::throwing = false;
+        const TrackedMap::value_type val(5, tracked(5));
+        tracked::throwing = true;
+        REQUIRE_THROWS(m.insert(val));
+        tracked::throwing = false;
+        // every node allocated for a failed insert was given back
+        REQUIRE(counting_alloc::blocks == blocks);
+        REQUIRE(m.size() == 1);
+        REQUIRE(m.begin()->first == 1);
+        REQUIRE(m.try_emplace(2, 2).second);
+        REQUIRE(m.size() == 2);
+    }
+
+    SECTION("test MultiMap range constructors keep duplicates")
+    {
+        Zyx::Vector<Zyx::Pair<int, int> > v;
+        for (int i = 0; i < 30; ++i)
+            v.push_back(Zyx::make_pair(i % 10, i));
+        Zyx::MultiMap<int, int> mm(v.begin(), v.end());
+        REQUIRE(mm.size() == 30);
+        REQUIRE(mm.count(3) == 3);
+        Zyx::MultiMap<int, int> cmp(v.begin(), v.end(), Zyx::less<int>());
+        REQUIRE(cmp.size() == 30);
+        Zyx::Map<int, int> m(v.begin(), v.end());
+        REQUIRE(m.size() == 10);
+    }
+
+    SECTION("test heterogeneous lookups exist only for transparent functors")
+    {
+        REQUIRE(!offers_find(Zyx::Map<int, int>(), stranger(), 0));
+        REQUIRE(!offers_find(Zyx::Set<int>(), stranger(), 0));
+        REQUIRE(!offers_find(Zyx::HashMap<int, int>(), stranger(), 0));
+        REQUIRE(!offers_find(Zyx::HashSet<int>(), stranger(), 0));
+
+        // a key that converts still finds through the key_type overloads
+        Zyx::Map<int, int> plain;
+        plain[2] = 20;
+        REQUIRE(plain.find(2.0)->second == 20);
+        REQUIRE(plain.count(2.0) == 1);
+
+        Zyx::Map<long, int, Zyx::less<void> > m;
+        Zyx::Set<long, Zyx::less<void> > s;
+        for (int i = 0; i < 10; ++i) {
+            m[i] = i;
+            s.insert(i);
+        }
+        REQUIRE(m.find(3)->second == 3);
+        REQUIRE(m.count(4) == 1);
+        REQUIRE(m.lower_bound(5)->first == 5);
+        REQUIRE(m.upper_bound(5)->first == 6);
+        REQUIRE(Zyx::distance(m.equal_range(7).first, m.equal_range(7).second) == 1);
+        REQUIRE(*s.find(3) == 3);
+        REQUIRE(s.count(42) == 0);
+        REQUIRE(*s.upper_bound(8) == 9);
+
+        Zyx::HashMap<Zyx::String, int> hm;
+        hm[Zyx::String("key")] = 1;
+        Zyx::HashSet<Zyx::String> hs;
+        hs.insert(Zyx::String("key"));
+        REQUIRE(hm.find("key")->second == 1);
+        REQUIRE(hm.count("nokey") == 0);
+        REQUIRE(hs.count("key") == 1);
+        REQUIRE(hs.equal_range("key").first != hs.end());
+    }
+}
@@ -0,0 +1,250 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <utility>
+#include "../src/Map.h"
+#include "../src/MultiMap.h"
+#include "../src/Set.h"
+#include "../src/MultiSet.h"
+#include "../src/HashMap.h"
+#include "../src/HashSet.h"
+#include "../src/Vector.h"
+
+// malloc_alloc that counts the blocks it has out
+struct counting_alloc
+{
+    static int blocks;
+
+    static void* allocate(size_t n)
+    {
+        ++blocks;
+        return Zyx::malloc_alloc::allocate(n);
+    }
+
+    static void deallocate(void* p, size_t n)
+    {
+        --blocks;
+        Zyx::malloc_alloc::deallocate(p, n);
+    }
+};
+
+int counting_alloc::blocks = 0;
+
+typedef Zyx::Set<int, Zyx::less<int>, counting_alloc> CountedSet;
+typedef Zyx::MultiSet<int, Zyx::less<int>, counting_alloc> CountedMultiSet;
+typedef Zyx::HashSet<int, Zyx::hash<int>, Zyx::equal_to<int>, counting_alloc> CountedHashSet;
+typedef Zyx::HashMultiSet<int, Zyx::hash<int>, Zyx::equal_to<int>, counting_alloc> CountedHashMultiSet;
+
+// counts the elements of c equal to k by walking it
+template <typename Container>
+int occurrences(const Container& c, int k)
+{
+    int n = 0;
+    for (typename Container::const_iterator it = c.begin(); it != c.end(); ++it)
+        if (*it == k)
+            ++n;
+    return n;
+}
+
+// extracts every key of src that is also in dst and checks the handle keeps
+// its node when dst refuses it
+template <typename Container>
+void check_reinsert_unique(Container& src, Container& dst)
+{
+    const int blocks = counting_alloc::blocks;
+    typename Container::node_type nh = src.extract(3);
+    REQUIRE(!nh.empty());
+    REQUIRE(nh.value() == 3);
+    REQUIRE(src.count(3) == 0);
+    REQUIRE(src.size() == 9);
+
+    Zyx::Pair<typename Container::iterator, bool> p = dst.insert(std::move(nh));
+    REQUIRE(p.second);
+    REQUIRE(*p.first == 3);
+    REQUIRE(nh.empty());
+    REQUIRE(dst.count(3) == 1);
+    // moving the node allocated nothing
+    REQUIRE(counting_alloc::blocks == blocks);
+
+    nh = dst.extract(dst.find(3));
+    REQUIRE(!nh.empty());
+    dst.insert(3);
+    p = dst.insert(std::move(nh));
+    REQUIRE(!p.second);
+    REQUIRE(*p.first == 3);
+    REQUIRE(!nh.empty());
+    REQUIRE(dst.count(3) == 1);
+
+    // the refused node goes back to the allocator with its handle
+    nh = typename Container::node_type();
+    REQUIRE(counting_alloc::blocks == blocks);
+
+    REQUIRE(src.extract(42).empty());
+}
+
+// merges src into dst, where dst already holds the even keys of src
+template <typename Container>
+void check_merge_unique(Container& src, Container& dst)
+{
+    for (int i = 0; i < 100; ++i)
+        src.insert(i);
+    for (int i = 0; i < 100; i += 2)
+        dst.insert(i);
+    const int blocks = counting_alloc::blocks;
+
+    dst.merge(src);
+    REQUIRE(dst.size() == 100);
+    REQUIRE(src.size() == 50);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(dst.count(i) == 1);
+        // the keys dst already had stay behind in src
+        REQUIRE(src.count(i) == (i % 2 == 0 ? 1u : 0u));
+    }
+    REQUIRE(counting_alloc::blocks == blocks);
+
+    dst.merge(dst);
+    REQUIRE(dst.size() == 100);
+}
+
+template <typename Container>
+void check_merge_equal(Container& src, Container& dst)
+{
+    for (int i = 0; i < 100; ++i)
+        src.insert(i % 10);
+    for (int i = 0; i < 10; ++i)
+        dst.insert(i);
+    const int blocks = counting_alloc::blocks;
+
+    dst.merge(src);
+    REQUIRE(src.empty());
+    REQUIRE(dst.size() == 110);
+    for (int i = 0; i < 10; ++i)
+        REQUIRE(occurrences(dst, i) == 11);
+    REQUIRE(counting_alloc::blocks == blocks);
+
+    typename Container::node_type nh = dst.extract(5);
+    REQUIRE(nh.value() == 5);
+    REQUIRE(dst.count(5) == 10);
+    dst.insert(std::move(nh));
+    REQUIRE(dst.count(5) == 11);
+}
+
+TEST_CASE("NodeHandleTest")
+{
+    SECTION("test extract and re-insert into another container")
+    {
+        {
+            CountedSet src, dst;
+            for (int i = 0; i < 10; ++i)
+                src.insert(i);
+            check_reinsert_unique(src, dst);
+        }
+        {
+            CountedHashSet src, dst;
+            for (int i = 0; i < 10; ++i)
+                src.insert(i);
+            check_reinsert_unique(src, dst);
+        }
+        REQUIRE(counting_alloc::blocks == 0);
+
+        Zyx::Map<int, int> m, n;
+        m[1] = 10;
+        m[2] = 20;
+        Zyx::Map<int, int>::node_type nh = m.extract(1);
+        nh.value().second = 11;
+        REQUIRE(n.insert(std::move(nh)).second);
+        REQUIRE(n[1] == 11);
+        REQUIRE(m.size() == 1);
+    }
+
+    SECTION("test extract from multi containers takes one element")
+    {
+        {
+            CountedMultiSet ms;
+            for (int i = 0; i < 3; ++i)
+                ms.insert(7);
+            CountedMultiSet::node_type nh = ms.extract(7);
+            REQUIRE(nh.value() == 7);
+            REQUIRE(ms.count(7) == 2);
+            CountedMultiSet other;
+            other.insert(std::move(nh));
+            REQUIRE(other.count(7) == 1);
+        }
+        {
+            CountedHashMultiSet ms;
+            for (int i = 0; i < 3; ++i)
+                ms.insert(7);
+            CountedHashMultiSet::node_type nh = ms.extract(ms.begin());
+            REQUIRE(nh.value() == 7);
+            REQUIRE(ms.count(7) == 2);
+        }
+        REQUIRE(counting_alloc::blocks == 0);
+    }
+
+    SECTION("test merge leaves duplicates in the source")
+    {
+        {
+            CountedSet src, dst;
+            check_merge_unique(src, dst);
+        }
+        {
+            CountedHashSet src, dst;
+            check_merge_unique(src, dst);
+        }
+        {
+            CountedMultiSet src, dst;
+            check_merge_equal(src, dst);
+        }
+        {
+            CountedHashMultiSet src, dst;
+            check_merge_equal(src, dst);
+        }
+        REQUIRE(counting_alloc::blocks == 0);
+
+        Zyx::Map<int, int> m, n;
+        for (int i = 0; i < 10; ++i) {
+            m[i] = i;
+            if (i % 3 == 0)
+                n[i] = -i;
+        }
+        n.merge(m);
+        REQUIRE(n.size() == 10);
+        REQUIRE(m.size() == 4);
+        for (int i = 0; i < 10; i += 3) {
+            REQUIRE(n[i] == -i);
+            REQUIRE(m[i] == i);
+        }
+
+        Zyx::MultiMap<int, int> mm, nn;
+        for (int i = 0; i < 20; ++i)
+            mm.insert(Zyx::make_pair(i % 5, i));
+        nn.insert(Zyx::make_pair(0, -1));
+        nn.merge(mm);
+        REQUIRE(mm.empty());
+        REQUIRE(nn.size() == 21);
+        REQUIRE(nn.count(0) == 5);
+    }
+
+    SECTION("test clear and destruction free every tree node")
+    {
+        Zyx::Vector<int> keys;
+        for (int i = 0; i < 2000; ++i)
+            keys.push_back(rand() % 5000);
+        {
+            CountedSet s;
+            const int empty_blocks = counting_alloc::blocks;
+            s.insert(keys.begin(), keys.end());
+            REQUIRE(counting_alloc::blocks == empty_blocks + (int)s.size());
+            // a tree with left subtrees several levels deep
+            s.clear();
+            REQUIRE(counting_alloc::blocks == empty_blocks);
+
+            s.insert(keys.begin(), keys.end());
+            CountedSet copy(s);
+            CountedMultiSet ms(keys.begin(), keys.end());
+            REQUIRE(ms.size() == keys.size());
+        }
+        REQUIRE(counting_alloc::blocks == 0);
+    }
+}
@@ -0,0 +1,163 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdlib>
+#include "../src/OrderStatisticSet.h"
+#include "../src/OrderStatisticMap.h"
+#include "../src/Algorithm.h"
+#include "../src/Vector.h"
+
+struct set_key
+{
+    int operator()(int k) const { return k; }
+};
+
+struct map_key
+{
+    int operator()(const Zyx::Pair<const int, int>& val) const { return val.first; }
+};
+
+struct is_even
+{
+    bool operator()(int k) const { return k % 2 == 0; }
+    bool operator()(const Zyx::Pair<const int, int>& val) const { return val.first % 2 == 0; }
+};
+
+// compares nth, index_of, rank and distance with the sorted keys in ref
+template <typename Container, typename KeyOf>
+static void check_order(const Container& c, const Zyx::Vector<int>& ref, KeyOf key)
+{
+    REQUIRE(c.size() == ref.size());
+    for (size_t i = 0; i < ref.size(); ++i) {
+        typename Container::const_iterator it = c.nth(i);
+        REQUIRE(key(*it) == ref[i]);
+        REQUIRE(c.index_of(it) == i);
+    }
+    REQUIRE((c.nth(ref.size()) == c.end()));
+    REQUIRE(c.index_of(c.end()) == ref.size());
+
+    // present and absent keys, and keys beyond both ends
+    for (int k = -2; k < 1002; k += 3) {
+        const size_t expect = Zyx::lower_bound(ref.begin(), ref.end(), k) - ref.begin();
+        REQUIRE(c.rank(k) == expect);
+    }
+
+    for (int q = 0; q < 50 && !ref.empty(); ++q) {
+        size_t i = rand() % (ref.size() + 1);
+        size_t j = rand() % (ref.size() + 1);
+        if (i > j)
+            Zyx::swap(i, j);
+        REQUIRE(c.distance(c.nth(i), c.nth(j)) == static_cast<ptrdiff_t>(j - i));
+        REQUIRE(c.distance(c.nth(j), c.nth(i)) == -static_cast<ptrdiff_t>(j - i));
+    }
+}
+
+static void ref_insert(Zyx::Vector<int>& ref, int k, bool unique)
+{
+    Zyx::Vector<int>::iterator pos = Zyx::upper_bound(ref.begin(), ref.end(), k);
+    if (!unique || pos == ref.begin() || *(pos - 1) != k)
+        ref.insert(pos, k);
+}
+
+static void ref_erase(Zyx::Vector<int>& ref, int k)
+{
+    ref.erase(Zyx::lower_bound(ref.begin(), ref.end(), k), Zyx::upper_bound(ref.begin(), ref.end(), k));
+}
+
+static void ref_erase_even(Zyx::Vector<int>& ref)
+{
+    ref.erase(Zyx::remove_if(ref.begin(), ref.end(), is_even()), ref.end());
+}
+
+TEST_CASE("test OrderStatisticSet.h", "[OrderStatisticSet]")
+{
+    SECTION("test nth, rank, index_of and distance function")
+    {
+        Zyx::OrderStatisticSet<int> s;
+        Zyx::Vector<int> ref;
+        check_order(s, ref, set_key());
+        srand(34);
+        for (int i = 0; i < 600; ++i) {
+            const int k = rand() % 1000;
+            if (i % 3 == 0)
+                s.insert(s.lower_bound(k), k);
+            else
+                s.insert(k);
+            ref_insert(ref, k, true);
+        }
+        check_order(s, ref, set_key());
+
+        for (int i = 0; i < 100; ++i) {
+            const int k = rand() % 1000;
+            s.erase(k);
+            ref_erase(ref, k);
+        }
+        s.erase(s.nth(10));
+        ref.erase(ref.begin() + 10);
+        s.erase(s.nth(50), s.nth(150));
+        ref.erase(ref.begin() + 50, ref.begin() + 150);
+        check_order(s, ref, set_key());
+
+        s.erase_if(is_even());
+        ref_erase_even(ref);
+        check_order(s, ref, set_key());
+
+        Zyx::OrderStatisticSet<int> copy(s);
+        check_order(copy, ref, set_key());
+    }
+
+    SECTION("test duplicates in OrderStatisticMultiSet")
+    {
+        Zyx::OrderStatisticMultiSet<int> s;
+        Zyx::Vector<int> ref;
+        for (int i = 0; i < 600; ++i) {
+            const int k = rand() % 200 * 5;
+            if (i % 4 == 0)
+                s.insert(s.end(), k);
+            else
+                s.insert(k);
+            ref_insert(ref, k, false);
+        }
+        check_order(s, ref, set_key());
+
+        for (int i = 0; i < 30; ++i) {
+            const int k = rand() % 200 * 5;
+            REQUIRE(s.erase(k) == static_cast<size_t>(Zyx::count(ref.begin(), ref.end(), k)));
+            ref_erase(ref, k);
+        }
+        s.erase(s.nth(100), s.nth(300));
+        ref.erase(ref.begin() + 100, ref.begin() + 300);
+        s.erase_if(is_even());
+        ref_erase_even(ref);
+        check_order(s, ref, set_key());
+    }
+}
+
+TEST_CASE("test OrderStatisticMap.h", "[OrderStatisticMap]")
+{
+    SECTION("test nth, rank, index_of and distance function")
+    {
+        Zyx::OrderStatisticMap<int, int> m;
+        Zyx::Vector<int> ref;
+        for (int i = 0; i < 500; ++i) {
+            const int k = rand() % 1000;
+            if (i % 2 == 0)
+                m.insert(m.end(), Zyx::make_pair(k, i));
+            else
+                m.insert(Zyx::make_pair(k, i));
+            ref_insert(ref, k, true);
+        }
+        check_order(m, ref, map_key());
+
+        for (int i = 0; i < 100; ++i) {
+            const int k = rand() % 1000;
+            m.erase(k);
+            ref_erase(ref, k);
+        }
+        m.erase(m.nth(20), m.nth(120));
+        ref.erase(ref.begin() + 20, ref.begin() + 120);
+        m.erase_if(is_even());
+        ref_erase_even(ref);
+        check_order(m, ref, map_key());
+    }
+}
@@ -0,0 +1,183 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <thread>
+#include "../src/PersistentMap.h"
+#include "../src/String.h"
+
+typedef Zyx::PersistentMap<int, int> IntMap;
+typedef Zyx::__persistent_node<IntMap::value_type> IntNode;
+
+// the height of the subtree at x, or -1 if it is not a valid AVL tree
+static int avl_height(const IntNode* x)
+{
+    if (x == nullptr)
+        return 0;
+    const int l = avl_height(x->left);
+    const int r = avl_height(x->right);
+    if (l < 0 || r < 0 || l - r > 1 || r - l > 1 || x->height != 1 + Zyx::max(l, r))
+        return -1;
+    return x->height;
+}
+
+static int avl_height(const IntMap& m)
+{
+    return m.empty() ? 0 : avl_height(m.begin().stack[0]);
+}
+
+TEST_CASE("test PersistentMap.h", "[PersistentMap]")
+{
+    SECTION("test insert, insert_or_assign and erase function")
+    {
+        IntMap m;
+        REQUIRE(m.insert(Zyx::make_pair(1, 10)).second);
+        REQUIRE(!m.insert(Zyx::make_pair(1, 20)).second);
+        REQUIRE(m.find(1)->second == 10);
+        REQUIRE(!m.insert_or_assign(1, 30).second);
+        REQUIRE(m.find(1)->second == 30);
+        REQUIRE(m.insert_or_assign(2, 40).second);
+        REQUIRE(m.size() == 2);
+        REQUIRE(m.erase(1) == 1);
+        REQUIRE(m.erase(1) == 0);
+        REQUIRE(m.count(1) == 0);
+        REQUIRE(!m.contains(1));
+        REQUIRE(m.contains(2));
+        REQUIRE(*m.get(2) == 40);
+        REQUIRE(m.get(1) == nullptr);
+        REQUIRE(m.find(1) == m.end());
+        REQUIRE(m.size() == 1);
+    }
+
+    SECTION("test rebalancing on insert and erase")
+    {
+        IntMap m;
+        for (int i = 0; i < 4096; ++i)
+            m.insert(Zyx::make_pair(i, i));
+        REQUIRE(avl_height(m) > 0);
+        REQUIRE(avl_height(m) <= 18);
+        for (int i = 8191; i >= 4096; --i)
+            m.insert(Zyx::make_pair(i, i));
+        REQUIRE(avl_height(m) > 0);
+        REQUIRE(avl_height(m) <= 19);
+        for (int i = 0; i < 8192; i += 3)
+            REQUIRE(m.erase(i) == 1);
+        for (int i = 8191; i >= 6000; --i)
+            m.erase(i);
+        REQUIRE(avl_height(m) > 0);
+        int expect = 1;
+        for (IntMap::const_iterator it = m.begin(); it != m.end(); ++it) {
+            REQUIRE(it->first == expect);
+            expect += expect % 3 == 1 ? 1 : 2;
+        }
+        REQUIRE(m.size() == 4000);
+    }
+
+    SECTION("test iterator, lower_bound and upper_bound function")
+    {
+        IntMap m;
+        for (int i = 0; i < 1000; i += 2)
+            m.insert(Zyx::make_pair(i, i));
+        REQUIRE(m.lower_bound(101)->first == 102);
+        REQUIRE(m.lower_bound(100)->first == 100);
+        REQUIRE(m.upper_bound(100)->first == 102);
+        REQUIRE(m.lower_bound(999) == m.end());
+        REQUIRE(m.upper_bound(998) == m.end());
+        REQUIRE(m.lower_bound(-5) == m.begin());
+        Zyx::Pair<IntMap::const_iterator, IntMap::const_iterator> p = m.equal_range(500);
+        REQUIRE(p.first->first == 500);
+        REQUIRE(p.second->first == 502);
+        int n = 0;
+        for (IntMap::const_iterator it = m.lower_bound(900); it != m.end(); ++it)
+            ++n;
+        REQUIRE(n == 50);
+    }
+
+    SECTION("test snapshot isolation")
+    {
+        IntMap v1;
+        for (int i = 0; i < 100; ++i)
+            v1.insert(Zyx::make_pair(i, i));
+        IntMap v2(v1);
+        v2.insert_or_assign(5, -5);
+        v2.erase(6);
+        v2.insert(Zyx::make_pair(1000, 1000));
+        IntMap v3 = v2;
+        v3.clear();
+
+        REQUIRE(v1.size() == 100);
+        REQUIRE(v1.find(5)->second == 5);
+        REQUIRE(v1.count(6) == 1);
+        REQUIRE(v1.count(1000) == 0);
+        REQUIRE(v2.size() == 100);
+        REQUIRE(v2.find(5)->second == -5);
+        REQUIRE(v2.count(6) == 0);
+        REQUIRE(v3.empty());
+        REQUIRE(v1 != v2);
+
+        IntMap v4(v1);
+        REQUIRE(v4 == v1);
+        v1.insert_or_assign(0, 1);
+        REQUIRE(v4.find(0)->second == 0);
+    }
+
+    SECTION("test snapshots read while another thread updates")
+    {
+        IntMap m;
+        for (int i = 0; i < 1000; ++i)
+            m.insert(Zyx::make_pair(i, 0));
+        const IntMap snapshot(m);
+        std::thread writer([&m]() {
+            for (int i = 0; i < 1000; ++i)
+                m.insert_or_assign(i, 1);
+        });
+        long sum = 0;
+        for (IntMap::const_iterator it = snapshot.begin(); it != snapshot.end(); ++it)
+            sum += it->second;
+        writer.join();
+        REQUIRE(sum == 0);
+        REQUIRE(m.find(999)->second == 1);
+    }
+
+    SECTION("test String keys released on a reader thread")
+    {
+        typedef Zyx::PersistentMap<Zyx::String, Zyx::String> Table;
+        struct build
+        {
+            static Table version(int v)
+            {
+                Table t;
+                for (int i = 0; i < 200; ++i) {
+                    Zyx::String key("a configuration key longer than the buffer ");
+                    key.append_int(i);
+                    Zyx::String val("a configuration value for version ");
+                    val.append_int(v);
+                    t.insert_or_assign(key, val);
+                }
+                return t;
+            }
+        };
+        // each reader drops the only reference to an old version while
+        // this thread keeps allocating Strings for newer ones
+        Table config = build::version(0);
+        Table snapshots[4];
+        std::thread readers[4];
+        size_t sizes[4];
+        for (int t = 0; t < 4; ++t) {
+            snapshots[t] = config;
+            config = build::version(t + 1);
+            readers[t] = std::thread([&snapshots, &sizes, t]() {
+                sizes[t] = snapshots[t].size();
+                snapshots[t].clear();
+            });
+        }
+        for (int v = 5; v < 20; ++v)
+            config = build::version(v);
+        for (int t = 0; t < 4; ++t) {
+            readers[t].join();
+            REQUIRE(sizes[t] == 200);
+        }
+        REQUIRE(config.size() == 200);
+        REQUIRE(*config.get(Zyx::String("a configuration key longer than the buffer 199")) ==
+                "a configuration value for version 19");
+    }
+}
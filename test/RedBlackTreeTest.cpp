@@ -0,0 +1,334 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdlib>
+#include "../src/RedBlackTree.h"
+#include "../src/Functional.h"
+#include "../src/Algorithm.h"
+#include "../src/Iterator.h"
+#include "../src/Vector.h"
+#include "../src/Set.h"
+#include "../src/Map.h"
+
+typedef Zyx::RedBlackTree<int, int, Zyx::identity<int>, Zyx::less<int> > IntTree;
+typedef Zyx::RedBlackTree<int, Zyx::Pair<const int, int>, 
+                          Zyx::select1st<Zyx::Pair<const int, int> >, Zyx::less<int> > PairTree;
+
+// random inserts and erases, checking the tree after every step
+template <typename Tree>
+static void churn(Tree& t, bool unique, int steps)
+{
+    for (int i = 0; i < steps; ++i) {
+        const int k = rand() % 500;
+        switch (rand() % 4) {
+        case 0:
+        case 1:
+            if (unique)
+                t.insert_unique(k);
+            else
+                t.insert_equal(k);
+            break;
+        case 2:
+            t.erase(k);
+            break;
+        default:
+            if (!t.empty())
+                t.erase(t.lower_bound(k) == t.end() ? t.begin() : t.lower_bound(k));
+            break;
+        }
+        REQUIRE(t.__rb_verify());
+    }
+}
+
+// n sorted keys, unique for a unique tree, from [first, first + range)
+static Zyx::Vector<int> random_keys(int n, int first, int range)
+{
+    IntTree t;
+    while (static_cast<int>(t.size()) < n)
+        t.insert_unique(first + rand() % range);
+    return Zyx::Vector<int>(t.begin(), t.end());
+}
+
+static bool holds(const IntTree& t, const Zyx::Vector<int>& keys)
+{
+    return t.size() == keys.size() && Zyx::equal(t.begin(), t.end(), keys.begin());
+}
+
+// counts its calls, and matches keys divisible by every
+struct divisible_by
+{
+    int every;
+    int* calls;
+    divisible_by(int e, int* c) : every(e), calls(c) { }
+    bool operator()(int k) const { ++*calls; return k % every == 0; }
+};
+
+enum set_op { op_union, op_intersect, op_difference };
+
+// runs op on trees of a and b in every form and compares with the
+// algorithm on the sorted ranges
+static void check_set_op(set_op op, const Zyx::Vector<int>& a, const Zyx::Vector<int>& b)
+{
+    Zyx::Vector<int> expect;
+    if (op == op_union)
+        Zyx::set_union(a.begin(), a.end(), b.begin(), b.end(), Zyx::back_inserter(expect));
+    else if (op == op_intersect)
+        Zyx::set_intersection(a.begin(), a.end(), b.begin(), b.end(), Zyx::back_inserter(expect));
+    else
+        Zyx::set_difference(a.begin(), a.end(), b.begin(), b.end(), Zyx::back_inserter(expect));
+
+    for (int form = 0; form < 4; ++form) {
+        const bool parallel = form % 2 == 1;
+        const bool rvalue = form >= 2;
+        IntTree x;
+        x.insert_unique(a.begin(), a.end());
+        IntTree y;
+        y.insert_unique(b.begin(), b.end());
+        if (rvalue) {
+            if (op == op_union)
+                x.union_with(std::move(y), parallel);
+            else if (op == op_intersect)
+                x.intersect_with(std::move(y), parallel);
+            else
+                x.difference_with(std::move(y), parallel);
+            REQUIRE(y.empty());
+            REQUIRE(y.__rb_verify());
+        } else {
+            const IntTree& cy = y;
+            if (op == op_union)
+                x.union_with(cy, parallel);
+            else if (op == op_intersect)
+                x.intersect_with(cy, parallel);
+            else
+                x.difference_with(cy, parallel);
+            REQUIRE(holds(y, b));
+        }
+        REQUIRE(x.__rb_verify());
+        REQUIRE(holds(x, expect));
+    }
+}
+
+TEST_CASE("test RedBlackTree.h", "[RedBlackTree]")
+{
+    SECTION("test invariants after random insert and erase")
+    {
+        srand(40);
+        IntTree unique;
+        REQUIRE(unique.__rb_verify());
+        churn(unique, true, 3000);
+        IntTree equal;
+        churn(equal, false, 3000);
+
+        // the header stays red through growing, emptying and regrowing
+        for (int i = 0; i < 1000; ++i)
+            equal.insert_equal(i % 7);
+        REQUIRE(equal.__rb_verify());
+        equal.clear();
+        REQUIRE(equal.__rb_verify());
+        churn(equal, false, 500);
+
+        IntTree copy(unique);
+        REQUIRE(copy.__rb_verify());
+        REQUIRE(copy == unique);
+    }
+
+    SECTION("test union, intersection and difference against the algorithms")
+    {
+        srand(35);
+        const set_op ops[] = { op_union, op_intersect, op_difference };
+        for (int i = 0; i < 3; ++i) {
+            // small inputs run serially even when parallel is asked for
+            check_set_op(ops[i], random_keys(300, 0, 1000), random_keys(200, 0, 1000));
+            check_set_op(ops[i], random_keys(10, 0, 100), Zyx::Vector<int>());
+            check_set_op(ops[i], Zyx::Vector<int>(), random_keys(10, 0, 100));
+            // large enough to split the recursion across threads
+            check_set_op(ops[i], random_keys(30000, 0, 60000), random_keys(25000, 0, 60000));
+            check_set_op(ops[i], random_keys(30000, 0, 30000), random_keys(30000, 30000, 30000));
+            check_set_op(ops[i], random_keys(50000, 0, 100000), random_keys(100, 0, 100000));
+        }
+
+        IntTree t;
+        t.insert_unique(1);
+        t.union_with(t);
+        t.difference_with(t, true);
+        REQUIRE(t.empty());
+
+        Zyx::Set<int> s;
+        Zyx::Set<int> u;
+        s.insert(1);
+        s.insert(2);
+        u.insert(2);
+        s.difference_with(u, true);
+        REQUIRE(s.size() == 1);
+        REQUIRE(*s.begin() == 1);
+        Zyx::Map<int, int> m;
+        Zyx::Map<int, int> n;
+        m[1] = 1;
+        n[1] = 2;
+        n[3] = 3;
+        m.union_with(n, true);
+        REQUIRE(m[1] == 1);
+        m.difference_with(n, true);
+        REQUIRE(m.empty());
+    }
+
+    SECTION("test range erase on both sides of the split threshold")
+    {
+        // lengths below, at and above the 64 elements where erase switches
+        // from one node at a time to split and join
+        const int lengths[] = { 0, 1, 10, 63, 64, 65, 300, 1999 };
+        for (int unique = 0; unique < 2; ++unique) {
+            for (int l = 0; l < 8; ++l) {
+                for (int start = 0; start + lengths[l] <= 2000; start += 997) {
+                    IntTree t;
+                    for (int i = 0; i < 2000; ++i) {
+                        if (unique)
+                            t.insert_unique(i);
+                        else
+                            t.insert_equal(i / 2);
+                    }
+                    Zyx::Vector<int> ref(t.begin(), t.end());
+                    IntTree::iterator first = t.begin();
+                    Zyx::advance(first, start);
+                    IntTree::iterator last = first;
+                    Zyx::advance(last, lengths[l]);
+                    IntTree::iterator before = start == 0 ? t.end() : Zyx::prev(first);
+                    t.erase(first, last);
+                    ref.erase(ref.begin() + start, ref.begin() + start + lengths[l]);
+                    REQUIRE(t.__rb_verify());
+                    REQUIRE(holds(t, ref));
+                    // iterators outside the range stay valid
+                    if (start != 0)
+                        REQUIRE(*before == ref[start - 1]);
+                    REQUIRE((last == t.end() ? start + lengths[l] == 2000 : *last == ref[start]));
+                }
+            }
+        }
+
+        IntTree t;
+        for (int i = 0; i < 100; ++i)
+            t.insert_equal(i % 10);
+        REQUIRE(t.erase(3) == 10);
+        REQUIRE(t.__rb_verify());
+        t.erase(t.begin(), t.end());
+        REQUIRE(t.empty());
+        REQUIRE(t.__rb_verify());
+    }
+
+    SECTION("test erase_if with no, few and many matches")
+    {
+        // every = 1000 matches a couple of elements and takes the in-place
+        // path, the others pass the threshold and relink the survivors
+        const int every[] = { 3001, 1000, 2, 1 };
+        for (int e = 0; e < 4; ++e) {
+            IntTree t;
+            for (int i = 1; i <= 3000; ++i)
+                t.insert_unique(i);
+            IntTree::iterator survivor = t.find(2999);
+            int calls = 0;
+            const size_t erased = t.erase_if(divisible_by(every[e], &calls));
+            REQUIRE(calls == 3000);
+            REQUIRE(erased == static_cast<size_t>(3000 / every[e]));
+            REQUIRE(t.size() == 3000 - erased);
+            REQUIRE(t.__rb_verify());
+            for (IntTree::iterator it = t.begin(); it != t.end(); ++it)
+                REQUIRE(*it % every[e] != 0);
+            if (2999 % every[e] != 0)
+                REQUIRE(*survivor == 2999);
+        }
+
+        Zyx::RedBlackTree<int, int, Zyx::identity<int>, Zyx::less<int>, Zyx::alloc,
+                          Zyx::__rb_tree_size_node<int> > sized;
+        for (int i = 0; i < 1000; ++i)
+            sized.insert_equal(i % 100);
+        int calls = 0;
+        REQUIRE(sized.erase_if(divisible_by(3, &calls)) == 340);
+        REQUIRE(sized.__rb_verify());
+        REQUIRE(*sized.nth(0) == 1);
+        REQUIRE(sized.rank(50) == 330);
+    }
+
+    SECTION("test building from sorted, unsorted and duplicate ranges")
+    {
+        srand(32);
+        // every size up to a few complete levels, so each red_depth is hit
+        for (int n = 0; n < 70; ++n) {
+            Zyx::Vector<int> keys;
+            for (int i = 0; i < n; ++i)
+                keys.push_back(2 * i);
+            IntTree u, e;
+            u.insert_unique(keys.begin(), keys.end());
+            e.insert_equal(keys.begin(), keys.end());
+            REQUIRE(u.__rb_verify());
+            REQUIRE(e.__rb_verify());
+            REQUIRE(holds(u, keys));
+            REQUIRE(holds(e, keys));
+
+            // one key out of place at the end sends the range to the fallback
+            if (n > 1) {
+                Zyx::Vector<int> late(keys);
+                late.back() = -1;
+                IntTree f;
+                f.insert_unique(late.begin(), late.end());
+                REQUIRE(f.__rb_verify());
+                Zyx::sort(late.begin(), late.end());
+                REQUIRE(holds(f, late));
+            }
+        }
+
+        // unsorted input with duplicates
+        Zyx::Vector<int> shuffled;
+        for (int i = 0; i < 3000; ++i)
+            shuffled.push_back(rand() % 1000);
+        IntTree su, se;
+        su.insert_unique(shuffled.begin(), shuffled.end());
+        se.insert_equal(shuffled.begin(), shuffled.end());
+        REQUIRE(su.__rb_verify());
+        REQUIRE(se.__rb_verify());
+        Zyx::sort(shuffled.begin(), shuffled.end());
+        REQUIRE(holds(se, shuffled));
+        Zyx::Vector<int> distinct(su.begin(), su.end());
+        REQUIRE(distinct.size() == static_cast<size_t>(Zyx::unique(shuffled.begin(), 
+                                                                    shuffled.end()) - shuffled.begin()));
+        REQUIRE(Zyx::equal(distinct.begin(), distinct.end(), shuffled.begin()));
+
+        // sorted runs of equal keys: a unique tree keeps the first of each 
+        // run, an equal tree keeps every element in input order
+        Zyx::Vector<Zyx::Pair<int, int> > runs;
+        for (int i = 0; i < 300; ++i)
+            runs.push_back(Zyx::make_pair(i / 3, i));
+        PairTree pu, pe;
+        pu.insert_unique(runs.begin(), runs.end());
+        pe.insert_equal(runs.begin(), runs.end());
+        REQUIRE(pu.__rb_verify());
+        REQUIRE(pe.__rb_verify());
+        REQUIRE(pu.size() == 100);
+        REQUIRE(pe.size() == 300);
+        int i = 0;
+        for (PairTree::iterator it = pu.begin(); it != pu.end(); ++it, ++i) {
+            REQUIRE(it->first == i);
+            REQUIRE(it->second == 3 * i);
+        }
+        i = 0;
+        for (PairTree::iterator it = pe.begin(); it != pe.end(); ++it, ++i)
+            REQUIRE(it->second == i);
+
+        // a tree that already holds keys inserts element by element
+        IntTree grown;
+        grown.insert_unique(5);
+        Zyx::Vector<int> keys = random_keys(500, 0, 2000);
+        grown.insert_unique(keys.begin(), keys.end());
+        REQUIRE(grown.__rb_verify());
+        const bool had_five = Zyx::binary_search(keys.begin(), keys.end(), 5);
+        REQUIRE(grown.size() == keys.size() + (had_five ? 0 : 1));
+    }
+
+    SECTION("test invariants with other allocators and augmented nodes")
+    {
+        Zyx::RedBlackTree<int, int, Zyx::identity<int>, Zyx::less<int>, Zyx::malloc_alloc> m;
+        churn(m, true, 2000);
+        Zyx::RedBlackTree<int, int, Zyx::identity<int>, Zyx::less<int>, Zyx::alloc,
+                          Zyx::__rb_tree_size_node<int> > sized;
+        churn(sized, false, 2000);
+    }
+}
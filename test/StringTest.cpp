@@ -0,0 +1,475 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdio>
+#include <cerrno>
+#include <cmath>
+#include <thread>
+#include "../src/String.h"
+#include "../src/StringSplit.h"
+#include "../src/StringBuilder.h"
+#include "../src/Utf8.h"
+#include "../src/Rope.h"
+#include "../src/SharedString.h"
+#include "../src/HashMap.h"
+#include "../src/Map.h"
+#include "../src/StringInterner.h"
+
+TEST_CASE("test String.h", "[String]")
+{
+    SECTION("test String() function")
+    {
+        Zyx::String s;
+        REQUIRE(s.size() == 0);
+        REQUIRE(s.empty());
+        REQUIRE(s.c_str()[0] == '\0');
+        REQUIRE(sizeof(Zyx::String) == 3 * sizeof(char*));
+    }
+
+    SECTION("test short and long strings")
+    {
+        Zyx::String s("short");
+        REQUIRE(s.size() == 5);
+        REQUIRE(s == "short");
+
+        Zyx::String l("a string that does not fit inside the object");
+        REQUIRE(l.size() == 44);
+        REQUIRE(l == "a string that does not fit inside the object");
+        REQUIRE(l.capacity() >= l.size());
+    }
+
+    SECTION("test growing past the local buffer")
+    {
+        Zyx::String s;
+        for (int i = 0; i < 100; ++i) {
+            s.push_back(static_cast<char>('a' + i % 26));
+            REQUIRE(s.size() == static_cast<size_t>(i + 1));
+            REQUIRE(s.c_str()[s.size()] == '\0');
+        }
+        s.erase(10, Zyx::String::npos);
+        REQUIRE(s == "abcdefghij");
+        s.reserve();
+        REQUIRE(s == "abcdefghij");
+        REQUIRE(s.capacity() < 100);
+    }
+
+    SECTION("test append(), insert() and erase()")
+    {
+        Zyx::String s("hello");
+        s.append(" world");
+        REQUIRE(s == "hello world");
+        s.insert(5, ",");
+        REQUIRE(s == "hello, world");
+        s.erase(0, 7);
+        REQUIRE(s == "world");
+        s.append(s);
+        REQUIRE(s == "worldworld");
+        s.insert(s.begin(), 3, '-');
+        REQUIRE(s == "---worldworld");
+    }
+
+    SECTION("test copy and swap()")
+    {
+        Zyx::String a("tiny");
+        Zyx::String b("a rather longer string on the heap");
+        Zyx::String c(a);
+        a.swap(b);
+        REQUIRE(a == "a rather longer string on the heap");
+        REQUIRE(b == "tiny");
+        REQUIRE(c == "tiny");
+        b = a;
+        REQUIRE(b == a);
+        a.clear();
+        REQUIRE(a.empty());
+        REQUIRE(b == "a rather longer string on the heap");
+    }
+
+    SECTION("test StringView")
+    {
+        Zyx::String s("key=value");
+        Zyx::StringView v = s;
+        REQUIRE(v.size() == s.size());
+        REQUIRE(v.find('=') == 3);
+        REQUIRE(v.substr(4) == "value");
+        REQUIRE(v.find_first_not_of("key") == 3);
+
+        Zyx::String t(v.substr(0, 3));
+        REQUIRE(t == "key");
+        t.append(Zyx::StringView("board"));
+        REQUIRE(t == "keyboard");
+        t.insert(0, v.substr(4));
+        REQUIRE(t == "valuekeyboard");
+    }
+
+    SECTION("test find() family and compare()")
+    {
+        Zyx::String s("GET /index.html HTTP/1.1\r\nHost: example.com\r\n");
+        REQUIRE(s.find("HTTP/") == 16);
+        REQUIRE(s.find("\r\n", 26) == 43);
+        const size_t npos = Zyx::String::npos;
+        REQUIRE(s.find("missing") == npos);
+        REQUIRE(s.rfind("\r\n") == 43);
+        REQUIRE(s.rfind('/') == 20);
+        REQUIRE(s.find_first_of(":\r") == 24);
+        REQUIRE(s.find_last_not_of("\r\n") == 42);
+        REQUIRE(s.find_first_not_of("GET ") == 4);
+
+        // long periodic needles switch to the two-way search
+        Zyx::String needle(200, 'a');
+        needle.append(1, 'b').append(199, 'a');
+        Zyx::String text(100000, 'a');
+        REQUIRE(text.find(needle) == npos);
+        REQUIRE(text.rfind(needle) == npos);
+        text.append(1, 'b').append(50000, 'a').append(1, 'b').append(50000, 'a');
+        REQUIRE(text.find(needle) == 99800);
+        REQUIRE(text.rfind(needle) == 149801);
+        REQUIRE(text.find(needle, 99801) == 149801);
+
+        Zyx::String a("apple");
+        Zyx::String b("apricot");
+        REQUIRE(a.compare(b) < 0);
+        REQUIRE(b.compare("apple") > 0);
+        REQUIRE(a.compare(0, 2, b, 0, 2) == 0);
+        REQUIRE(a < b);
+        REQUIRE(b > "apple");
+        REQUIRE(a <= "apple");
+        REQUIRE(a >= a);
+    }
+
+    SECTION("test append_int(), append_double() and from_chars()")
+    {
+        Zyx::String s("n=");
+        s.append_int(-1234567890123LL).append(" u=").append_int(42u);
+        REQUIRE(s == "n=-1234567890123 u=42");
+
+        Zyx::String d;
+        d.append_double(0.1).push_back(' ');
+        d.append_double(-2.5e-9).push_back(' ');
+        d.append_double(1e21).push_back(' ');
+        d.append_double(123456.0);
+        REQUIRE(d == "0.1 -2.5e-9 1e+21 123456");
+
+        const char* text = "-9876 rest";
+        long long n = 0;
+        REQUIRE(Zyx::from_chars(text, text + strlen(text), n) == text + 5);
+        REQUIRE(n == -9876);
+
+        const char* real = "6.02214076e23";
+        double x = 0;
+        REQUIRE(Zyx::from_chars(real, real + strlen(real), x) == real + strlen(real));
+        REQUIRE(x == 6.02214076e23);
+
+        // the special values to_chars writes read back
+        const double specials[] = { HUGE_VAL, -HUGE_VAL, std::nan("") };
+        for (int i = 0; i < 3; ++i) {
+            char out[Zyx::__MAX_NUMBER_CHARS];
+            char* end = Zyx::to_chars(out, out + sizeof(out), specials[i]);
+            REQUIRE(Zyx::from_chars(out, end, x) == end);
+            REQUIRE((i < 2 ? x == specials[i] : x != x));
+        }
+        const char* words[] = { "Infinity", "-INF", "infinite", "-nan", "NaN(1)" };
+        const int used[] = { 8, 4, 3, 4, 3 };
+        for (int i = 0; i < 5; ++i) {
+            const char* w = words[i];
+            REQUIRE(Zyx::from_chars(w, w + strlen(w), x) == w + used[i]);
+            REQUIRE((i < 3 ? std::fabs(x) == HUGE_VAL : x != x));
+            REQUIRE(std::signbit(x) == (w[0] == '-'));
+        }
+
+        // out of range leaves the value alone and errno as it was
+        const char* bad[] = { "in", "-n", "1e400", "-1e400", "1e-400", 
+                              "123456789012345678901234567890e300" };
+        errno = EDOM;
+        for (int i = 0; i < 6; ++i) {
+            x = 7;
+            REQUIRE(Zyx::from_chars(bad[i], bad[i] + strlen(bad[i]), x) == bad[i]);
+            REQUIRE(x == 7);
+        }
+        REQUIRE(errno == EDOM);
+        const char* tiny = "4.9e-324";
+        REQUIRE(Zyx::from_chars(tiny, tiny + strlen(tiny), x) == tiny + strlen(tiny));
+        REQUIRE(x == 4.9e-324);
+        const char* zero = "0e-400";
+        REQUIRE(Zyx::from_chars(zero, zero + strlen(zero), x) == zero + strlen(zero));
+        REQUIRE(x == 0);
+
+        char buffer[4];
+        REQUIRE(Zyx::to_chars(buffer, buffer + 4, 12345) == nullptr);
+    }
+
+    SECTION("test split() and tokenize()")
+    {
+        Zyx::String csv("id,name,,score");
+        const char* fields[] = { "id", "name", "", "score" };
+        int i = 0;
+        for (Zyx::StringView f : Zyx::split(csv, ','))
+            REQUIRE(f == fields[i++]);
+        REQUIRE(i == 4);
+
+        i = 0;
+        for (Zyx::StringView f : Zyx::split("a::b::", "::")) {
+            REQUIRE(f == (i == 0 ? "a" : i == 1 ? "b" : ""));
+            ++i;
+        }
+        REQUIRE(i == 3);
+
+        const char* words[] = { "split", "these", "words" };
+        i = 0;
+        for (Zyx::StringView w : Zyx::tokenize("  split \t these\nwords ", " \t\n"))
+            REQUIRE(w == words[i++]);
+        REQUIRE(i == 3);
+    }
+
+    SECTION("test StringBuilder")
+    {
+        Zyx::StringBuilder b;
+        REQUIRE(b.empty());
+        for (int i = 0; i < 1000; ++i) {
+            b += "item";
+            b.append_int(i);
+            b.push_back(';');
+        }
+        b.append_double(0.25);
+        Zyx::String s = b.str();
+        REQUIRE(s.size() == b.size());
+        REQUIRE(s.capacity() == s.size());
+        REQUIRE(s.compare(0, 14, "item0;item1;it") == 0);
+        REQUIRE(s.find("item999;0.25") == s.size() - 12);
+
+        b.clear();
+        REQUIRE(b.empty());
+        b.append(3, '-');
+        REQUIRE(b.str() == "---");
+    }
+
+    SECTION("test UTF-8 validation, transcoding and code_points()")
+    {
+        Zyx::String s("na\xC3\xAFve caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80, plain ASCII after it");
+        REQUIRE(Zyx::is_valid_utf8(s));
+        REQUIRE(Zyx::utf8_length(s) == s.size() - 7);
+        REQUIRE(!Zyx::is_valid_utf8("overlong \xC0\xAF slash"));
+        REQUIRE(!Zyx::is_valid_utf8("surrogate \xED\xA0\x80"));
+        REQUIRE(!Zyx::is_valid_utf8("truncated at the end \xE2\x82"));
+
+        char16_t u16[64];
+        char16_t* e16 = Zyx::utf8_to_utf16(s, u16);
+        REQUIRE(e16 - u16 == static_cast<ptrdiff_t>(Zyx::utf8_length(s)) + 1);
+        char back[3 * 64];
+        REQUIRE(Zyx::StringView(back, Zyx::utf16_to_utf8(u16, e16, back)) == s);
+
+        char32_t u32[64];
+        char32_t* e32 = Zyx::utf8_to_utf32(s, u32);
+        REQUIRE(Zyx::utf8_to_utf32("\xFF", u32) == nullptr);
+
+        int i = 0;
+        for (char32_t c : Zyx::code_points(s))
+            REQUIRE(c == u32[i++]);
+        REQUIRE(u32 + i == e32);
+        REQUIRE(*Zyx::code_points("\xFFx").begin() == 0xFFFD);
+    }
+}
+
+TEST_CASE("test Rope.h", "[Rope]")
+{
+    SECTION("test edits inside one leaf")
+    {
+        Zyx::Rope r("hello world");
+        r.insert(5, ",");
+        r.push_back('!');
+        r.insert(0, "oh, ");
+        REQUIRE(r.flatten() == "oh, hello, world!");
+        r.erase(2, 1);
+        r.erase(r.size() - 1, 1);
+        REQUIRE(r.flatten() == "oh hello, world");
+        REQUIRE(r.size() == 15);
+        REQUIRE(r[3] == 'h');
+        r.erase(0, r.size());
+        REQUIRE(r.empty());
+    }
+
+    SECTION("test edits that split and join the tree")
+    {
+        Zyx::String expect;
+        for (int i = 0; i < 20000; ++i)
+            expect.push_back(static_cast<char>('a' + i % 26));
+        Zyx::Rope r(expect);
+
+        Zyx::String block(3000, 'x');
+        r.insert(10000, block);
+        expect.insert(10000, block);
+        r.erase(500, 12000);
+        expect.erase(500, 12000);
+        REQUIRE(r.flatten() == expect);
+
+        unsigned seed = 1;
+        for (int i = 0; i < 2000; ++i) {
+            seed = seed * 1103515245 + 12345;
+            const size_t pos = seed % (expect.size() + 1);
+            if (i % 3 == 0) {
+                const size_t n = Zyx::min(static_cast<size_t>(seed >> 20 & 15), expect.size() - pos);
+                r.erase(pos, n);
+                expect.erase(pos, n);
+            } else {
+                const Zyx::StringView piece("0123456789", (seed >> 16) % 10 + 1);
+                r.insert(pos, piece);
+                expect.insert(pos, piece);
+            }
+        }
+        REQUIRE(r.size() == expect.size());
+        REQUIRE(r.size() > 10000);
+        REQUIRE(r.flatten() == expect);
+
+        Zyx::Rope other("<inserted rope>");
+        r.insert(100, other);
+        expect.insert(100, "<inserted rope>");
+        const Zyx::String head(expect, 0, 700);
+        r.append(Zyx::Rope(head));
+        expect.append(head);
+        REQUIRE(r.flatten() == expect);
+        REQUIRE(other.flatten() == "<inserted rope>");
+    }
+
+    SECTION("test substr, flatten and chunk iteration")
+    {
+        Zyx::String text;
+        for (int i = 0; i < 5000; ++i)
+            text.append_int(i);
+        Zyx::Rope r(text);
+        REQUIRE(r.flatten() == text);
+        const Zyx::StringView view(text);
+        REQUIRE(r.substr(1000, 3000).flatten() == view.substr(1000, 3000));
+        REQUIRE(r.substr(text.size() - 5).flatten() == view.substr(text.size() - 5));
+        REQUIRE(r[12345] == view[12345]);
+
+        Zyx::String joined;
+        size_t chunks = 0;
+        for (Zyx::Rope::chunk_iterator it = r.chunk_begin(); it != r.chunk_end(); ++it) {
+            REQUIRE(!(*it).empty());
+            joined.append(*it);
+            ++chunks;
+        }
+        REQUIRE(chunks > 1);
+        REQUIRE(joined == text);
+    }
+}
+
+TEST_CASE("test SharedString.h", "[SharedString]")
+{
+    SECTION("test copy, move, assign and substr sharing")
+    {
+        Zyx::SharedString s("GET /index.html HTTP/1.1");
+        REQUIRE(s.use_count() == 1);
+        Zyx::SharedString path = s.substr(4, 11);
+        REQUIRE(path == "/index.html");
+        REQUIRE((path.data() == s.data() + 4));
+        REQUIRE(s.use_count() == 2);
+        {
+            Zyx::SharedString copy(s);
+            REQUIRE(s.use_count() == 3);
+            Zyx::SharedString moved(static_cast<Zyx::SharedString&&>(copy));
+            REQUIRE(copy.empty());
+            REQUIRE(s.use_count() == 3);
+        }
+        REQUIRE(s.use_count() == 2);
+
+        Zyx::SharedString other("other");
+        other = path;
+        REQUIRE(other == "/index.html");
+        REQUIRE(s.use_count() == 3);
+        s = Zyx::SharedString("replaced");
+        REQUIRE(path.use_count() == 2);
+        REQUIRE(path == "/index.html");
+        REQUIRE(path.find("html") == 7);
+        REQUIRE(path.rfind('/') == 0);
+    }
+
+    SECTION("test the empty string")
+    {
+        Zyx::SharedString e;
+        REQUIRE(e.empty());
+        REQUIRE(e.use_count() == 0);
+        REQUIRE(Zyx::SharedString("").use_count() == 0);
+        REQUIRE(e == "");
+        Zyx::SharedString s("abc");
+        REQUIRE(s.substr(3).empty());
+        REQUIRE(e.compare(s) < 0);
+    }
+
+    SECTION("test transparent hash, equal_to and less")
+    {
+        Zyx::HashMap<Zyx::SharedString, int> h;
+        h[Zyx::SharedString("content-type")] = 1;
+        h[Zyx::SharedString("host")] = 2;
+        REQUIRE(h.find(Zyx::StringView("host"))->second == 2);
+        REQUIRE(h.find(Zyx::StringView("accept")) == h.end());
+        REQUIRE(Zyx::hash<Zyx::SharedString>()(Zyx::SharedString("host")) ==
+                Zyx::hash<Zyx::SharedString>()(Zyx::StringView("host")));
+
+        Zyx::Map<Zyx::SharedString, int> m;
+        m[Zyx::SharedString("b")] = 2;
+        m[Zyx::SharedString("a")] = 1;
+        REQUIRE(m.begin()->first == "a");
+        REQUIRE(m.find(Zyx::StringView("b"))->second == 2);
+        REQUIRE(Zyx::less<Zyx::SharedString>()(Zyx::StringView("a"), Zyx::SharedString("b")));
+        REQUIRE(Zyx::equal_to<Zyx::SharedString>()(Zyx::SharedString("a"), "a"));
+    }
+}
+
+TEST_CASE("test StringInterner.h", "[StringInterner]")
+{
+    SECTION("test intern, find and str function")
+    {
+        Zyx::StringInterner in;
+        REQUIRE(in.empty());
+        const Zyx::StringInterner::id_type a = in.intern("alpha");
+        const Zyx::StringInterner::id_type b = in.intern(Zyx::String("beta"));
+        REQUIRE(a != b);
+        REQUIRE(in.intern("alpha") == a);
+        REQUIRE(in.find("beta") == b);
+        const Zyx::StringInterner::id_type invalid = Zyx::StringInterner::invalid_id;
+        REQUIRE(in.find("gamma") == invalid);
+        REQUIRE(in.size() == 2);
+        REQUIRE(in.str(a) == "alpha");
+        REQUIRE(in.str(b).data()[4] == '\0');
+        REQUIRE(in.intern("") == 2);
+        REQUIRE(in.str(2).empty());
+
+        Zyx::String big(100000, 'z');
+        const Zyx::StringInterner::id_type z = in.intern(big);
+        REQUIRE(in.str(z) == big);
+        for (int i = 0; i < 5000; ++i) {
+            Zyx::String s("key");
+            s.append_int(i);
+            REQUIRE(in.intern(s) == static_cast<Zyx::StringInterner::id_type>(i + 4));
+        }
+        REQUIRE(in.str(a) == "alpha");
+        REQUIRE(in.str(4999 + 4) == "key4999");
+    }
+
+    SECTION("test concurrent intern function")
+    {
+        Zyx::StringInterner in;
+        Zyx::StringInterner::id_type ids[4][1000];
+        std::thread threads[4];
+        for (int t = 0; t < 4; ++t) {
+            threads[t] = std::thread([&in, &ids, t]() {
+                char name[16];
+                for (int i = 0; i < 1000; ++i) {
+                    const int n = snprintf(name, sizeof(name), "name%d", (i * 7 + t * 250) % 1000);
+                    ids[t][i] = in.intern(Zyx::StringView(name, n));
+                }
+            });
+        }
+        for (int t = 0; t < 4; ++t)
+            threads[t].join();
+        REQUIRE(in.size() == 1000);
+        for (int t = 0; t < 4; ++t) {
+            for (int i = 0; i < 1000; ++i) {
+                char name[16];
+                snprintf(name, sizeof(name), "name%d", (i * 7 + t * 250) % 1000);
+                REQUIRE(in.str(ids[t][i]) == name);
+                REQUIRE(in.find(name) == ids[t][i]);
+            }
+        }
+    }
+}